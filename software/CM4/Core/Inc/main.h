@@ -59,6 +59,12 @@ void Error_Handler(void);
 
 /* Private defines -----------------------------------------------------------*/
 /* USER CODE BEGIN Private defines */
+#define SII_INT_Pin GPIO_PIN_5
+#define SII_INT_GPIO_Port GPIOB
+#define SII_SCL_Pin GPIO_PIN_6
+#define SII_SCL_GPIO_Port GPIOB
+#define SII_SDA_Pin GPIO_PIN_7
+#define SII_SDA_GPIO_Port GPIOB
 
 /* USER CODE END Private defines */
 
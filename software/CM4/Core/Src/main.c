@@ -22,6 +22,16 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "boot.h"
+#include "ipc.h"
+#include "display_service.h"
+#include "hsem_lock.h"
+#include "ipc_bench.h"
+#include "pipeline.h"
+#include "pipeline_bench.h"
+#include "shared_mem.h"
+#include "test_pattern.h"
+#include "tile_sched.h"
 
 /* USER CODE END Includes */
 
@@ -44,11 +54,14 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+I2C_HandleTypeDef hi2c1;
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
+static void MX_I2C1_Init(void);
+static void SII_INT_Init(void);
 
 /* USER CODE END PFP */
 
@@ -97,7 +110,26 @@ int main(void)
 
   /* Initialize all configured peripherals */
   /* USER CODE BEGIN 2 */
-
+  /* Check the CM7 image agrees on the shared region layout and acknowledge it */
+  if (shared_mem_attach() != SHARED_MEM_STATUS_OK)
+  {
+    Error_Handler();
+  }
+  boot_mark(BOOT_MARK_CM4_ATTACHED);
+  ipc_init();
+  hsem_lock_init();
+  /* Takes tiles of the strips the CM7 is scanning out */
+  tile_sched_init(test_pattern_tile, NULL);
+#ifdef PIPELINE_BENCH
+  /* Geometry for the CM7's pipeline benchmark, built whenever the CM7 kicks */
+  pipeline_set_scene(pipeline_bench_scene, NULL);
+#endif
+  /* The display service owns the SiI1136; with no transmitter it answers every request with an
+     error instead of stopping the CM4 */
+  MX_I2C1_Init();
+  SII_INT_Init();
+  display_service_init(&hi2c1);
+  boot_mark(BOOT_MARK_DISPLAY_READY);
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -107,11 +139,72 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    ipc_msg_t msg;
+    if (ipc_recv_wait(&msg, DISPLAY_SERVICE_POLL_MS) == IPC_STATUS_OK)
+    {
+      if (!display_service_handle(&msg) && !tile_sched_handle(&msg) && !pipeline_handle(&msg))
+      {
+        ipc_bench_handle(&msg);
+      }
+    }
+    display_service_poll();
   }
   /* USER CODE END 3 */
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief I2C1 Initialization Function (SiI1136 TPI and, through it, the sink's DDC bus)
+  * @param None
+  * @retval None
+  */
+static void MX_I2C1_Init(void)
+{
+  hi2c1.Instance = I2C1;
+  hi2c1.Init.Timing = 0x10707DBC; /* 100 kHz from the 64 MHz kernel clock */
+  hi2c1.Init.OwnAddress1 = 0;
+  hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+  hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+  hi2c1.Init.OwnAddress2 = 0;
+  hi2c1.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+  hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+  hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+  if (HAL_I2C_Init(&hi2c1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief SiI1136 interrupt pin: active low, wakes the display service on hot-plug
+  * @param None
+  * @retval None
+  */
+static void SII_INT_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+  GPIO_InitStruct.Pin = SII_INT_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  HAL_GPIO_Init(SII_INT_GPIO_Port, &GPIO_InitStruct);
+
+  HAL_NVIC_SetPriority(EXTI9_5_IRQn, 6, 0);
+  HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  if (GPIO_Pin == SII_INT_Pin)
+  {
+    display_service_irq();
+  }
+}
 
 /* USER CODE END 4 */
 
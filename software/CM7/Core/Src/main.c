@@ -22,6 +22,22 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "blit.h"
+#include "boot.h"
+#include "display_service.h"
+#include "hsem_lock.h"
+#include "ipc.h"
+#include "ipc_bench.h"
+#include "mem_attr.h"
+#include "pipeline_bench.h"
+#include "pixel_convert_bench.h"
+#include "raster_bench.h"
+#include "scanout.h"
+#include "shared_mem.h"
+#include "test_pattern.h"
+#include "tile_sched.h"
+#include "timebase.h"
+#include "trace.h"
 
 /* USER CODE END Includes */
 
@@ -34,6 +50,15 @@
 /* USER CODE BEGIN PD */
 
 #define HSEM_ID_0 (0U) /* HW semaphore 0*/
+/* Longest the CM4 may take to leave D2 stop mode once released */
+#define CM4_BOOT_TIMEOUT_US 10000U
+/* Strip mode ring: STRIP_COUNT strips of STRIP_LINES lines of up to STRIP_MAX_WIDTH RGB565 pixels,
+the widest mode DISPLAY_MAX_PIXEL_CLOCK_KHZ allows */
+#define STRIP_LINES 8U
+#define STRIP_COUNT 4U
+#define STRIP_MAX_WIDTH 1280U
+/* Each strip is shared out between the cores in tiles this wide */
+#define STRIP_TILE_WIDTH 64U
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -44,12 +69,18 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+/* There is no framebuffer until the SDRAM is brought up, so the display is raced in strips */
+static uint16_t strip_ring[STRIP_MAX_WIDTH * STRIP_LINES * STRIP_COUNT] AXI_BUFFER;
+/* Strips the CM7 drew without the CM4's help because its IPC ring was full */
+static volatile uint32_t strip_solo_count;
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
+static void display_event(const display_event_t* event, void* user);
+static void strip_render(const surface_t* strip, uint16_t y, uint32_t frame, void* user);
 
 /* USER CODE END PFP */
 
@@ -65,21 +96,26 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-
+  /* MPU regions and L1 caches must be in place before anything touches SDRAM or shared memory */
+  mem_attr_init();
   /* USER CODE END 1 */
 
 /* USER CODE BEGIN Boot_Mode_Sequence_0 */
   int32_t timeout;
+  uint32_t start_us;
 /* USER CODE END Boot_Mode_Sequence_0 */
 
 /* USER CODE BEGIN Boot_Mode_Sequence_1 */
-  /* Wait until CPU2 boots and enters in stop mode or timeout*/
+  /* Wait until CPU2 boots and enters in stop mode or timeout. Counted in loops, not on the
+  timebase: enabling TIM2 would allocate a D2 peripheral to this core and keep D2 out of DStop */
   timeout = 0xFFFF;
   while((__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) != RESET) && (timeout-- > 0));
   if ( timeout < 0 )
   {
   Error_Handler();
   }
+  /* Shared timebase, from here on also the time since boot; retuned once the clocks are final */
+  timebase_init();
 /* USER CODE END Boot_Mode_Sequence_1 */
   /* MCU Configuration--------------------------------------------------------*/
 
@@ -93,8 +129,11 @@ int main(void)
   /* Configure the system clock */
   SystemClock_Config();
 /* USER CODE BEGIN Boot_Mode_Sequence_2 */
-/* When system initialization is finished, Cortex-M7 will release Cortex-M4 by means of
-HSEM notification */
+/* The CM4 only needs the clocks, so it is released right here; transmitter and EDID bring-up on
+the CM4 then overlap with the rest of the CM7's setup. Before that, only what the CM4 reads
+straight away: the timebase at its final rate and the shared region header it attaches to */
+timebase_retune();
+shared_mem_init();
 /*HW semaphore Clock enable*/
 __HAL_RCC_HSEM_CLK_ENABLE();
 /*Take HSEM */
@@ -102,12 +141,18 @@ HAL_HSEM_FastTake(HSEM_ID_0);
 /*Release HSEM in order to notify the CPU2(CM4)*/
 HAL_HSEM_Release(HSEM_ID_0,0);
 /* wait until CPU2 wakes up from stop mode */
-timeout = 0xFFFF;
-while((__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) == RESET) && (timeout-- > 0));
-if ( timeout < 0 )
+start_us = timebase_now_us();
+while (__HAL_RCC_GET_FLAG(RCC_FLAG_D2CKRDY) == RESET)
 {
-Error_Handler();
+  if (timebase_elapsed_us(start_us) > CM4_BOOT_TIMEOUT_US)
+  {
+    Error_Handler();
+    break;
+  }
 }
+/* The CM4 records nothing until tracing is enabled here */
+trace_init();
+boot_mark(BOOT_MARK_CLOCKS_READY);
 /* USER CODE END Boot_Mode_Sequence_2 */
 
   /* USER CODE BEGIN SysInit */
@@ -116,7 +161,59 @@ Error_Handler();
 
   /* Initialize all configured peripherals */
   /* USER CODE BEGIN 2 */
-
+  /* Scan-out itself starts in display_event(), once the CM4 reports a sink and its mode */
+  scanout_init();
+  blit_init();
+#ifdef BLIT_CALIBRATE
+  /* Replace the default software/DMA2D crossover sizes with measured ones */
+  static uint8_t blit_scratch[BLIT_CALIBRATE_SCRATCH_B] DMA_BUFFER;
+  static blit_calibration_t blit_calibration;
+  blit_calibrate(blit_scratch, &blit_calibration);
+#endif
+#ifdef RASTER_BENCH
+  /* Triangles and pixels per second into a cacheable on-chip target */
+  static uint16_t raster_bench_pixels[128 * 128] AXI_BUFFER;
+  static raster_bench_result_t raster_bench_result;
+  surface_t raster_bench_target = {(uint8_t*)raster_bench_pixels, 128, 128, 128 * 2,
+                                   PIXEL_FORMAT_RGB565};
+  raster_bench_run(&raster_bench_target, &raster_bench_result);
+#endif
+#ifdef PIXEL_CONVERT_BENCH
+  /* Cycles per pixel of the conversion kernels, and their agreement with the reference */
+  static uint8_t pixel_convert_scratch[PIXEL_CONVERT_BENCH_SCRATCH_B] AXI_BUFFER;
+  static pixel_convert_bench_result_t pixel_convert_result;
+  pixel_convert_bench_run(pixel_convert_scratch, &pixel_convert_result);
+#endif
+  /* Only wait for the CM4 once everything the CM7 can do on its own is done */
+  boot_mark(BOOT_MARK_CM7_READY);
+  if (shared_mem_wait_attached(100) != SHARED_MEM_STATUS_OK)
+  {
+    Error_Handler();
+  }
+  ipc_init();
+  hsem_lock_init();
+  /* Scan-out follows the sink: started by the CONNECTED event, stopped when it goes away */
+  display_client_set_event_callback(display_event, NULL);
+  tile_sched_init(test_pattern_tile, NULL);
+#ifdef IPC_BENCH
+  static ipc_bench_result_t ipc_bench_result;
+  if (ipc_bench_run(&ipc_bench_result) != IPC_STATUS_OK)
+  {
+    Error_Handler();
+  }
+#endif
+#ifdef PIPELINE_BENCH
+  /* Frame times with geometry (CM4) and raster (CM7) overlapped, then taking turns */
+  static uint16_t pipeline_bench_pixels[PIPELINE_BENCH_WIDTH * PIPELINE_BENCH_HEIGHT] AXI_BUFFER;
+  static pipeline_bench_result_t pipeline_bench_result;
+  surface_t pipeline_bench_target = {(uint8_t*)pipeline_bench_pixels, PIPELINE_BENCH_WIDTH,
+                                     PIPELINE_BENCH_HEIGHT, PIPELINE_BENCH_WIDTH * 2,
+                                     PIXEL_FORMAT_RGB565};
+  if (!pipeline_bench_run(&pipeline_bench_target, &pipeline_bench_result))
+  {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -126,6 +223,14 @@ Error_Handler();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    /* Display responses and hot-plug events from the CM4 */
+    ipc_msg_t msg;
+    while (ipc_recv(&msg) == IPC_STATUS_OK)
+    {
+      display_client_handle(&msg);
+    }
+    /* In strip mode, render the strips the scan has freed; returns at once otherwise */
+    scanout_strip_poll();
   }
   /* USER CODE END 3 */
 }
@@ -178,6 +283,69 @@ void SystemClock_Config(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief Starts strip-mode scan-out in the mode the CM4 programmed, or stops it on unplug.
+  * @param event: display event from the CM4
+  * @param user: unused
+  * @retval None
+  */
+static void display_event(const display_event_t* event, void* user)
+{
+  (void)user;
+  if (event->event != DISPLAY_EVENT_CONNECTED)
+  {
+    scanout_stop();
+    return;
+  }
+  /* Full height, centred, at most STRIP_MAX_WIDTH wide over the black background */
+  uint16_t width = event->mode.h_active < STRIP_MAX_WIDTH ? event->mode.h_active : STRIP_MAX_WIDTH;
+  /* Rows of whole cache lines, which the tile scheduler needs */
+  width &= (uint16_t)~(CACHE_LINE_SIZE_B / 2U - 1U);
+  scanout_strip_config_t config = {
+    .width = width,
+    .height = event->mode.v_active,
+    .x = (int16_t)((event->mode.h_active - width) / 2),
+    .y = 0,
+    .format = PIXEL_FORMAT_RGB565,
+    .strip_lines = STRIP_LINES,
+    .num_strips = STRIP_COUNT,
+    .render = strip_render,
+    .user = NULL,
+  };
+  /* A mode the LTDC cannot show leaves the output dark rather than stopping the CM7 */
+  if (scanout_start_strips(&event->mode, &config, strip_ring, sizeof(strip_ring)) !=
+      SCANOUT_STATUS_OK)
+  {
+    scanout_stop();
+  }
+}
+
+/**
+  * @brief Draws one strip of the test pattern, with the CM4 taking a share of its tiles.
+  * @param strip: strip buffer, in its own coordinates
+  * @param y: first line of the strip within the frame
+  * @param frame: frame number
+  * @param user: unused
+  * @retval None
+  */
+static void strip_render(const surface_t* strip, uint16_t y, uint32_t frame, void* user)
+{
+  (void)y;
+  (void)user;
+  tile_sched_status_t status =
+      tile_sched_render_frame(strip, STRIP_TILE_WIDTH, strip->height, frame);
+  if (status == TILE_SCHED_STATUS_SOLO)
+  {
+    /* Drawn, but degraded: the CM4 was too busy to be asked */
+    strip_solo_count++;
+  }
+  else if (status != TILE_SCHED_STATUS_OK)
+  {
+    /* Drawn here alone if the scheduler cannot take it */
+    rect_t bounds = surface_bounds(strip);
+    test_pattern_draw(strip, &bounds, frame);
+  }
+}
 
 /* USER CODE END 4 */
 
@@ -23,6 +23,8 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "blit.h"
+#include "scanout.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -199,5 +201,37 @@ void SysTick_Handler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles HSEM1 global interrupt (inter-core doorbells).
+  */
+void HSEM1_IRQHandler(void)
+{
+  HAL_HSEM_IRQHandler();
+}
+
+/**
+  * @brief This function handles LTDC global interrupt (page flips latched).
+  */
+void LTDC_IRQHandler(void)
+{
+  scanout_irq();
+}
+
+/**
+  * @brief This function handles LTDC error interrupt (FIFO underrun, transfer error).
+  */
+void LTDC_ER_IRQHandler(void)
+{
+  scanout_irq();
+}
+
+/**
+  * @brief This function handles DMA2D global interrupt.
+  */
+void DMA2D_IRQHandler(void)
+{
+  blit_irq();
+}
+
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
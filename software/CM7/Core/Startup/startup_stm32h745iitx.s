@@ -80,6 +80,39 @@ LoopCopyDataInit:
   adds  r2, r0, r1
   cmp  r2, r3
   bcc  CopyDataInit
+
+/* Copy the FAST_CODE functions from flash to ITCM */
+  ldr  r0, =_sitcm
+  ldr  r1, =_eitcm
+  ldr  r2, =_siitcm
+  b  LoopCopyItcmInit
+
+CopyItcmInit:
+  ldr  r3, [r2], #4
+  str  r3, [r0], #4
+
+LoopCopyItcmInit:
+  cmp  r0, r1
+  bcc  CopyItcmInit
+
+/* Copy the FAST_DATA tables from flash to DTCM */
+  ldr  r0, =_sdtcm
+  ldr  r1, =_edtcm
+  ldr  r2, =_sidtcm
+  b  LoopCopyDtcmInit
+
+CopyDtcmInit:
+  ldr  r3, [r2], #4
+  str  r3, [r0], #4
+
+LoopCopyDtcmInit:
+  cmp  r0, r1
+  bcc  CopyDtcmInit
+
+/* Make sure the freshly copied code is visible to instruction fetch */
+  dsb
+  isb
+
   ldr  r2, =_sbss
   b  LoopFillZerobss
 /* Zero fill the bss segment. */  
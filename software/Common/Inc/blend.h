@@ -0,0 +1,66 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Software compositing spans: the twelve Porter-Duff operators plus additive, multiply and screen.
+//
+// Every combination of mode, source format, destination format and alpha source is compiled into
+// its own span function, so a span's loop carries no mode or format switches. blend_select()
+// looks the specialization up once per draw call; blit_composite() does that and then runs it row
+// by row.
+//
+// Pixels are straight (not premultiplied) alpha. The operators are evaluated on 8-bit weights:
+// with Fa and Fb the operator's source and destination factors,
+//   ws = a_src * Fa, wd = a_dst * Fb, a_out = ws + wd, c_out = (c_src * ws + c_dst * wd) / a_out
+// (multiply and screen add their third, a_src * a_dst, term as the compositing spec defines).
+// Destinations without alpha count as opaque and receive the result as it looks over black, i.e.
+// c_src * ws + c_dst * wd. PLUS saturates each premultiplied channel. DST never touches the
+// destination. For DMA2D-exact source-over use blit_blend() instead.
+
+typedef enum {
+    BLEND_MODE_CLEAR,
+    BLEND_MODE_SRC,
+    BLEND_MODE_DST,
+    BLEND_MODE_SRC_OVER,
+    BLEND_MODE_DST_OVER,
+    BLEND_MODE_SRC_IN,
+    BLEND_MODE_DST_IN,
+    BLEND_MODE_SRC_OUT,
+    BLEND_MODE_DST_OUT,
+    BLEND_MODE_SRC_ATOP,
+    BLEND_MODE_DST_ATOP,
+    BLEND_MODE_XOR,
+    BLEND_MODE_PLUS,
+    BLEND_MODE_MULTIPLY,
+    BLEND_MODE_SCREEN,
+    BLEND_MODE_COUNT
+} blend_mode_t;
+
+typedef enum {
+    BLEND_ALPHA_PIXEL,        // The source pixel's own alpha.
+    BLEND_ALPHA_CONST,        // params.alpha for every pixel.
+    BLEND_ALPHA_PIXEL_CONST,  // Their product.
+    BLEND_ALPHA_COUNT
+} blend_alpha_t;
+
+typedef struct {
+    blend_mode_t mode;
+    blend_alpha_t alpha_source;
+    uint8_t alpha;  // BLEND_ALPHA_CONST and BLEND_ALPHA_PIXEL_CONST.
+    uint32_t rgb;   // A8 sources: the colour their coverage applies to, 0x00RRGGBB.
+} blend_params_t;
+
+// Blends count pixels of src into dst. Formats and mode are fixed by the specialization.
+typedef void (*blend_span_fn_t)(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                const blend_params_t* params);
+
+// Destinations: ARGB8888 and RGB565. Sources: those and A8.
+bool blend_supported(pixel_format_t dst_format, pixel_format_t src_format);
+
+// The specialization for params' mode and alpha source, or NULL if the formats or params are not
+// supported.
+blend_span_fn_t blend_select(pixel_format_t dst_format, pixel_format_t src_format,
+                             const blend_params_t* params);
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "blend.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 2D block transfers: fill, copy (converting between pixel formats as needed) and source-over
+// blending with per-pixel and/or constant alpha.
+//
+// On the CM7 each operation runs on the DMA2D, unless it is so small that programming the DMA2D
+// and maintaining the cache would cost more than doing it in software; the per-operation
+// crossover sizes come from blit_calibrate(). Everywhere else (the CM4, host tools) the software
+// path runs. Both paths produce identical pixels: the software one follows the DMA2D's
+// arithmetic, which blit_calibrate() checks on the target.
+//
+// Colour expansion replicates the top bits (0x1F -> 0xFF), narrowing truncates, and blending is
+//   a_fg = a_src * alpha / 255
+//   a_out = a_fg + a_dst - a_fg * a_dst / 255
+//   c_out = (c_src * a_fg + c_dst * a_dst - c_dst * (a_fg * a_dst / 255)) / a_out
+// with every division truncating.
+//
+// Surfaces in cacheable memory are cleaned/invalidated around DMA2D work as needed, so callers
+// never do cache maintenance for them; they must not be in the DTCM, which the DMA2D cannot reach.
+// L8 sources are read through the CLUT loaded last with blit_load_clut[_async](). L8 destinations
+// (indexed framebuffers) take fills, whose argb is then the palette index in its low byte, and
+// copies from other L8 surfaces; both run in software, since the DMA2D cannot write 8-bit pixels.
+//
+// The plain calls are synchronous. The _async ones queue the job for the DMA2D and return its
+// sequence number at once; each job's completion interrupt starts the next one, so a frame's worth
+// of blits runs back to back while the CPU does other work. Jobs complete in submission order, so
+// waiting for one means every earlier one is done too. Sources must stay unchanged, and
+// destinations untouched by the CPU, until then. A synchronous call first waits for the queue to
+// drain. Jobs the DMA2D cannot take run in software at their turn in the queue; on cores without
+// the DMA2D every job runs at once.
+//
+// The DMA2D only takes a queued job into a write-back (cached) destination if its rows start and
+// end on CACHE_LINE_SIZE_B boundaries, i.e. the surface's stride and the byte offsets of x0 and
+// x1 are multiples of it: finishing the job invalidates its lines, which would otherwise also
+// drop CPU writes next to it. Anything else waits for the queue to drain and runs in software, so
+// align rectangles (8 ARGB8888 or 16 RGB565 pixels) in cached surfaces to keep them queued.
+
+// Queued jobs; submitting to a full queue waits for the oldest.
+#define BLIT_QUEUE_DEPTH 32
+#define BLIT_CLUT_MAX 256
+#define BLIT_WAIT_FOREVER 0xFFFFFFFFUL
+
+// Calibration sizes, in pixels per blit. Larger blits always go to the DMA2D.
+#define BLIT_CALIBRATE_SIZES 6
+#define BLIT_CALIBRATE_MAX_PIXELS 4096
+#define BLIT_CALIBRATE_SCRATCH_B (2 * BLIT_CALIBRATE_MAX_PIXELS * 4)
+
+typedef enum {
+    BLIT_STATUS_OK,
+    BLIT_STATUS_NULL_ARG,
+    BLIT_STATUS_BAD_FORMAT,  // ARGB8888, RGB888, RGB565, ARGB1555, ARGB4444; L8 as above.
+    BLIT_STATUS_DMA_ERR,
+    BLIT_STATUS_TIMEOUT,
+    BLIT_STATUS_BAD_CLUT     // Empty, larger than BLIT_CLUT_MAX, or out of the DMA2D's reach.
+} blit_status_t;
+
+typedef enum {
+    BLIT_OP_FILL,
+    BLIT_OP_COPY,     // Same format on both sides.
+    BLIT_OP_CONVERT,  // Copy between formats.
+    BLIT_OP_BLEND,
+    BLIT_OP_COUNT
+} blit_op_t;
+
+typedef enum {
+    BLIT_ENGINE_AUTO,      // By crossover size.
+    BLIT_ENGINE_SOFTWARE,
+    BLIT_ENGINE_DMA2D      // Falls back to software where the DMA2D is not available.
+} blit_engine_t;
+
+typedef struct {
+    uint32_t blits[BLIT_OP_COUNT];
+    uint32_t dma2d_blits[BLIT_OP_COUNT];
+    uint32_t dma2d_errors;
+} blit_stats_t;
+
+typedef struct {
+    uint32_t pixels[BLIT_CALIBRATE_SIZES];
+    uint32_t software_cycles[BLIT_OP_COUNT][BLIT_CALIBRATE_SIZES];
+    uint32_t dma2d_cycles[BLIT_OP_COUNT][BLIT_CALIBRATE_SIZES];
+    uint32_t crossover_pixels[BLIT_OP_COUNT];  // Smallest blit handed to the DMA2D.
+    uint32_t mismatches[BLIT_OP_COUNT];        // Pixels where the two engines disagreed.
+} blit_calibration_t;
+
+// DMA2D activity since the previous blit_frame_stats() call.
+typedef struct {
+    uint32_t frame_us;
+    uint32_t busy_us;     // Time the DMA2D spent on queued jobs.
+    uint8_t busy_pct;
+    uint16_t max_depth;   // Jobs queued or running, sampled at each submission.
+    uint16_t mean_depth;
+    uint32_t jobs;
+    uint32_t stalls;      // Submissions that had to wait for a full queue.
+} blit_frame_stats_t;
+
+// Powers up the DMA2D and its interrupt (CM7), empties the queue and loads the default crossover
+// table.
+void blit_init(void);
+
+// Rectangles are clipped to their surfaces; anything clipped away is simply not drawn.
+
+// Fills rect of dst with argb, converted to dst's format.
+blit_status_t blit_fill(const surface_t* dst, const rect_t* rect, uint32_t argb);
+// Copies src_rect of src to dst with its top-left corner at (x, y).
+blit_status_t blit_copy(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                        const rect_t* src_rect);
+// Blends src_rect of src over dst at (x, y). alpha scales the source's own alpha; sources without
+// an alpha channel count as opaque, so alpha alone then sets the opacity.
+blit_status_t blit_blend(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                         const rect_t* src_rect, uint8_t alpha);
+
+// Composites src_rect of src onto dst at (x, y) with any of blend.h's modes. Always runs in
+// software, after the queue drains; formats are those blend_supported() takes. Returns
+// BLIT_STATUS_BAD_FORMAT for anything else, including a mode or alpha source out of range.
+blit_status_t blit_composite(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                             const rect_t* src_rect, const blend_params_t* params);
+
+// Queued variants. *seq (may be NULL) identifies the job for blit_done() and blit_wait(). Jobs
+// clipped away entirely queue nothing and return the newest sequence number.
+blit_status_t blit_fill_async(const surface_t* dst, const rect_t* rect, uint32_t argb,
+                              uint32_t* seq);
+blit_status_t blit_copy_async(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                              const rect_t* src_rect, uint32_t* seq);
+blit_status_t blit_blend_async(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                               const rect_t* src_rect, uint8_t alpha, uint32_t* seq);
+// Loads count ARGB8888 entries into the DMA2D's foreground CLUT between queued jobs. argb must
+// stay valid while any L8 blit may still use it.
+blit_status_t blit_load_clut_async(const uint32_t* argb, uint16_t count, uint32_t* seq);
+blit_status_t blit_load_clut(const uint32_t* argb, uint16_t count);
+
+bool blit_done(uint32_t seq);
+// Sleeps until job seq (and so every earlier one) has finished, or timeout_us (or
+// BLIT_WAIT_FOREVER) passes. Returns BLIT_STATUS_DMA_ERR if the DMA2D failed on job seq itself,
+// as long as it is one of the last BLIT_QUEUE_DEPTH jobs.
+blit_status_t blit_wait(uint32_t seq, uint32_t timeout_us);
+// Returns BLIT_STATUS_DMA_ERR if any queued job failed since the previous call.
+blit_status_t blit_wait_idle(uint32_t timeout_us);
+
+// Call once per frame; returns the figures since the previous call and starts new ones.
+void blit_frame_stats(blit_frame_stats_t* stats);
+
+// Call from DMA2D_IRQHandler().
+void blit_irq(void);
+
+// Overrides the engine choice for every later blit, e.g. to compare the two.
+void blit_set_engine(blit_engine_t engine);
+void blit_set_crossover(blit_op_t op, uint32_t pixels);
+uint32_t blit_get_crossover(blit_op_t op);
+
+// Times every operation on both engines at BLIT_CALIBRATE_SIZES sizes, checks that they agree,
+// and installs the resulting crossover table. scratch needs BLIT_CALIBRATE_SCRATCH_B bytes of
+// DMA2D-reachable memory. Results are in CPU cycles.
+blit_status_t blit_calibrate(void* scratch, blit_calibration_t* result);
+
+void blit_get_stats(blit_stats_t* stats);
+
+static inline bool blit_format_supported(pixel_format_t format) {
+    return format <= PIXEL_FORMAT_ARGB4444;
+}
+
+static inline bool blit_src_format_supported(pixel_format_t format) {
+    return blit_format_supported(format) || format == PIXEL_FORMAT_L8;
+}
+
+// Reference per-pixel conversions, shared by every software kernel.
+
+static inline uint32_t blit_expand5(uint32_t v) {
+    return (v << 3) | (v >> 2);
+}
+
+static inline uint32_t blit_expand6(uint32_t v) {
+    return (v << 2) | (v >> 4);
+}
+
+static inline uint32_t blit_unpack(pixel_format_t format, const uint8_t* src) {
+    uint32_t v;
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return *(const uint32_t*)src;
+        case PIXEL_FORMAT_RGB888:
+            return 0xFF000000UL | ((uint32_t)src[2] << 16) | ((uint32_t)src[1] << 8) | src[0];
+        case PIXEL_FORMAT_RGB565:
+            v = *(const uint16_t*)src;
+            return 0xFF000000UL | (blit_expand5((v >> 11) & 0x1F) << 16) |
+                   (blit_expand6((v >> 5) & 0x3F) << 8) | blit_expand5(v & 0x1F);
+        case PIXEL_FORMAT_ARGB1555:
+            v = *(const uint16_t*)src;
+            return ((v & 0x8000) ? 0xFF000000UL : 0) | (blit_expand5((v >> 10) & 0x1F) << 16) |
+                   (blit_expand5((v >> 5) & 0x1F) << 8) | blit_expand5(v & 0x1F);
+        case PIXEL_FORMAT_ARGB4444:
+            v = *(const uint16_t*)src;
+            return (((v >> 12) & 0xF) * 0x11UL << 24) | (((v >> 8) & 0xF) * 0x11UL << 16) |
+                   (((v >> 4) & 0xF) * 0x11UL << 8) | ((v & 0xF) * 0x11UL);
+        default:
+            return 0;
+    }
+}
+
+static inline void blit_pack(pixel_format_t format, uint8_t* dst, uint32_t argb) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            *(uint32_t*)dst = argb;
+            break;
+        case PIXEL_FORMAT_RGB888:
+            dst[0] = (uint8_t)argb;
+            dst[1] = (uint8_t)(argb >> 8);
+            dst[2] = (uint8_t)(argb >> 16);
+            break;
+        case PIXEL_FORMAT_RGB565:
+            *(uint16_t*)dst = (uint16_t)(((argb >> 8) & 0xF800) | ((argb >> 5) & 0x07E0) |
+                                         ((argb >> 3) & 0x001F));
+            break;
+        case PIXEL_FORMAT_ARGB1555:
+            *(uint16_t*)dst = (uint16_t)(((argb >> 16) & 0x8000) | ((argb >> 9) & 0x7C00) |
+                                         ((argb >> 6) & 0x03E0) | ((argb >> 3) & 0x001F));
+            break;
+        case PIXEL_FORMAT_ARGB4444:
+            *(uint16_t*)dst = (uint16_t)(((argb >> 16) & 0xF000) | ((argb >> 12) & 0x0F00) |
+                                         ((argb >> 8) & 0x00F0) | ((argb >> 4) & 0x000F));
+            break;
+        case PIXEL_FORMAT_L8:  // A palette index, not a colour.
+            dst[0] = (uint8_t)argb;
+            break;
+        default:
+            break;
+    }
+}
+
+static inline uint32_t blit_mul8(uint32_t a, uint32_t b) {
+    return a * b / 255;
+}
+
+static inline uint32_t blit_blend_pixel(uint32_t src, uint32_t dst, uint8_t alpha) {
+    uint32_t a_fg = blit_mul8(src >> 24, alpha);
+    uint32_t a_bg = dst >> 24;
+    uint32_t a_mult = blit_mul8(a_fg, a_bg);
+    uint32_t a_out = a_fg + a_bg - a_mult;
+    if (a_out == 0) {
+        return 0;
+    }
+    uint32_t out = a_out << 24;
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        uint32_t c_fg = (src >> shift) & 0xFF;
+        uint32_t c_bg = (dst >> shift) & 0xFF;
+        out |= ((c_fg * a_fg + c_bg * a_bg - c_bg * a_mult) / a_out) << shift;
+    }
+    return out;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "mem_map.h"
+
+#include <stdint.h>
+
+// Boot milestones.
+//
+// The CM7 releases the CM4 as soon as the clocks are final, then both cores bring up their own
+// side in parallel: the CM4 the HDMI transmitter, EDID and mode selection; the CM7 memory and
+// scan-out. Each core records when it reaches its milestones on the shared timebase, which
+// starts once the CM4 first parks itself in stop, a few microseconds into boot, so every mark is
+// also the time since boot. Boot-to-first-pixel is
+// boot_mark_us(BOOT_MARK_FIRST_PIXEL). Every mark is also recorded as a "boot" trace instant,
+// arg the mark, which Tools/trace_merge lists with its time; marks reached before trace_init()
+// are only kept here.
+
+typedef enum {
+    BOOT_MARK_CLOCKS_READY,   // CM7: clocks final, CM4 released and awake, tracing started.
+    BOOT_MARK_CM4_ATTACHED,   // CM4: shared region validated.
+    BOOT_MARK_DISPLAY_READY,  // CM4: transmitter up; mode programmed if a sink was present.
+    BOOT_MARK_CM7_READY,      // CM7: own setup done, about to wait for the CM4.
+    BOOT_MARK_FIRST_PIXEL,    // CM7: first frame scanned out, at its vertical blanking.
+    BOOT_MARK_COUNT
+} boot_mark_t;
+
+// Member of shared_mem_t. Each mark is written once, by the core that owns it.
+typedef struct SHARED_ALIGNED {
+    volatile uint32_t marks_us[BOOT_MARK_COUNT];  // 0 until reached.
+} boot_shared_t;
+
+// Records the current time for mark, unless it was already reached.
+void boot_mark(boot_mark_t mark);
+// Microseconds since reset at which mark was reached, or 0 if it has not been yet.
+uint32_t boot_mark_us(boot_mark_t mark);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core_id.h"
+#include "fence.h"
+#include "mem_map.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Zero-copy buffer queues between the cores.
+//
+// A queue hands a small set of pixel buffers back and forth between one producer core (e.g. the
+// CM4 rendering an overlay) and one consumer core (the display path). Only buffer indices cross
+// over; the pixels are never copied. Each buffer is owned by exactly one side at a time:
+//
+//     producer: acquire -> (render) -> queue
+//     consumer: present -> (scan out) -> release
+//
+// present() takes the newest queued buffer and releases any older ones straight back, so a slow
+// consumer drops frames instead of falling behind. Each side only does the cache maintenance it
+// needs itself: a CM7 consumer that reads pixels with the CPU invalidates the buffer when it
+// presents, and a CM7 producer cleans, when it queues, everything the buffer may have been
+// written in since it was last queued: the frame's own damage, plus that of every frame queued
+// from other buffers meanwhile, which a buffer-age renderer repairs too (see damage.h). Neither
+// ever runs on the CM4, which has no data cache.
+//
+// Internally this is two SPSC rings of indices whose heads are fences, so either side can sleep
+// until the other has something for it.
+
+#define BUFFER_QUEUE_MAX_BUFFERS 4
+
+typedef enum {
+    BUFFER_QUEUE_OVERLAY,  // CM4-rendered overlay/HUD layer.
+    BUFFER_QUEUE_COUNT
+} buffer_queue_id_t;
+
+typedef enum {
+    BUFFER_QUEUE_STATUS_OK,
+    BUFFER_QUEUE_STATUS_NULL_ARG,
+    BUFFER_QUEUE_STATUS_BAD_CONFIG,
+    BUFFER_QUEUE_STATUS_WRONG_CORE,  // Producer call from the consumer core, or vice versa.
+    BUFFER_QUEUE_STATUS_NOT_OWNED,   // Buffer index is not in the state this call expects.
+    BUFFER_QUEUE_STATUS_EMPTY,       // present(): nothing new was queued.
+    BUFFER_QUEUE_STATUS_TIMEOUT      // acquire(): every buffer is still with the consumer.
+} buffer_queue_status_t;
+
+typedef enum {
+    BUFFER_STATE_FREE,
+    BUFFER_STATE_RENDERING,  // Owned by the producer.
+    BUFFER_STATE_QUEUED,     // In flight to the consumer.
+    BUFFER_STATE_PRESENTED   // Owned by the consumer.
+} buffer_state_t;
+
+typedef struct {
+    surface_t surface;
+    rect_t damage;              // Area changed since the previous frame queued, set when queued.
+    uint32_t frame;             // Producer's frame number, set when queued.
+    uint32_t queued_us;         // Timebase time when queued.
+    volatile uint32_t state;    // buffer_state_t; written only by the current owner.
+} buffer_queue_buffer_t;
+
+typedef struct SHARED_ALIGNED {
+    fence_t queued;    // Head of the queued ring: buffers ever queued. Signalled by the producer.
+    fence_t released;  // Head of the free ring: buffers ever released. Signalled by the consumer.
+    struct SHARED_ALIGNED {
+        volatile uint32_t free_tail;
+        uint8_t queued_ring[BUFFER_QUEUE_MAX_BUFFERS];
+        uint32_t frames;  // Queued so far.
+        // Per buffer: damage of the frames queued since it was last queued, all of it before then.
+        rect_t missed[BUFFER_QUEUE_MAX_BUFFERS];
+    } producer;
+    struct SHARED_ALIGNED {
+        volatile uint32_t queued_tail;
+        uint8_t free_ring[BUFFER_QUEUE_MAX_BUFFERS];
+        uint32_t presented;
+        uint32_t dropped;  // Queued buffers superseded before they were presented.
+    } consumer;
+    struct SHARED_ALIGNED {  // Written once by buffer_queue_init().
+        uint32_t num_buffers;
+        uint8_t producer_core;
+        uint8_t consumer_core;
+        bool consumer_cpu_reads;  // The consumer reads pixels with the CPU, not just by DMA.
+    } config;
+    buffer_queue_buffer_t buffers[BUFFER_QUEUE_MAX_BUFFERS];
+} buffer_queue_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    buffer_queue_t queues[BUFFER_QUEUE_COUNT];
+} buffer_queue_shared_t;
+
+buffer_queue_t* buffer_queue_get(buffer_queue_id_t id);
+
+// Sets the queue up with every buffer free. Call on either core before the other side uses it.
+// queued_sem_id and released_sem_id are doorbells from hsem_ids.h, or FENCE_NO_DOORBELL.
+buffer_queue_status_t buffer_queue_init(buffer_queue_t* queue, const surface_t* surfaces,
+                                        uint32_t num_buffers, core_id_t producer,
+                                        core_id_t consumer, bool consumer_cpu_reads,
+                                        uint32_t queued_sem_id, uint32_t released_sem_id);
+// Call once on each side, after init, so waits on that side are woken by the doorbells.
+buffer_queue_status_t buffer_queue_attach(buffer_queue_t* queue);
+
+// Producer: takes a free buffer to render into, waiting up to timeout_us for the consumer to
+// release one.
+buffer_queue_status_t buffer_queue_acquire(buffer_queue_t* queue, uint32_t timeout_us,
+                                           uint32_t* index, const surface_t** surface);
+// Producer: hands a rendered buffer to the consumer. damage may be NULL for the whole buffer.
+buffer_queue_status_t buffer_queue_queue(buffer_queue_t* queue, uint32_t index,
+                                         const rect_t* damage);
+
+// Consumer: takes the newest queued buffer. Returns EMPTY if nothing was queued since the last
+// call, in which case whatever is on screen should stay there.
+buffer_queue_status_t buffer_queue_present(buffer_queue_t* queue, uint32_t* index,
+                                           const buffer_queue_buffer_t** buffer);
+// Consumer: gives a buffer back once nothing reads it any more (e.g. after the display has
+// switched to a newer one).
+buffer_queue_status_t buffer_queue_release(buffer_queue_t* queue, uint32_t index);
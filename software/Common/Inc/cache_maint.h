@@ -0,0 +1,45 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Most rectangles considered per call. Extra rectangles are folded into the last one's bounds.
+#define CACHE_MAINT_MAX_RECTS 32
+
+// Past this many lines a set/way walk of the whole 16 KB D-cache is cheaper than by-address ops.
+#define CACHE_MAINT_FULL_CACHE_LINES 512
+
+typedef enum {
+    CACHE_MAINT_CLEAN,            // CPU wrote, a DMA master (DMA2D/LTDC/MDMA) is about to read.
+    CACHE_MAINT_INVALIDATE,       // A DMA master wrote, the CPU is about to read. Whole lines are
+                                  // dropped, so clean before starting the DMA write.
+    CACHE_MAINT_CLEAN_INVALIDATE  // Both; also safe when ranges may share lines with other data.
+} cache_maint_op_t;
+
+// Contiguous, cache-line-aligned address range.
+typedef struct {
+    uintptr_t start;
+    uint32_t size_b;
+} cache_range_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t ranges;
+    uint32_t lines;
+    uint32_t full_cache_ops;
+    uint32_t skipped;  // Calls that needed no maintenance for this surface's memory policy.
+} cache_maint_stats_t;
+
+// Covers every line the rectangles touch. Past max_ranges ranges (or CACHE_MAINT_MAX_RECTS
+// rectangles) the last one also takes in the lines between them, which must not be invalidated.
+size_t cache_maint_rects_to_ranges(const surface_t* surface, const rect_t* rects, size_t num_rects,
+                                   cache_range_t* ranges, size_t max_ranges);
+void cache_maint_ranges(const cache_range_t* ranges, size_t num_ranges, cache_maint_op_t op);
+// CACHE_MAINT_INVALIDATE becomes CACHE_MAINT_CLEAN_INVALIDATE whenever the ranges over-cover.
+void cache_maint_rects(const surface_t* surface, const rect_t* rects, size_t num_rects,
+                       cache_maint_op_t op);
+
+void cache_maint_get_stats(cache_maint_stats_t* stats);
+void cache_maint_reset_stats(void);
@@ -0,0 +1,16 @@
+#pragma once
+
+// Index of each core in per-core arrays that live in shared memory.
+typedef enum {
+    CORE_ID_CM7,
+    CORE_ID_CM4,
+    CORE_ID_COUNT
+} core_id_t;
+
+#if defined(CORE_CM7)
+#define CORE_ID_SELF CORE_ID_CM7
+#define CORE_ID_OTHER CORE_ID_CM4
+#else
+#define CORE_ID_SELF CORE_ID_CM4
+#define CORE_ID_OTHER CORE_ID_CM7
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Free-running cycle counter for profiling. On target this is the core's own DWT counter, so
+// values from the two cores are not comparable with each other. Host builds count nanoseconds.
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+
+#include "stm32h7xx.h"
+
+static inline void cycles_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(CORE_CM7)
+    DWT->LAR = 0xC5ACCE55;  // The M7 DWT is locked out of reset.
+#endif
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycles_now(void) {
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t cycles_per_second(void) {
+    return SystemCoreClock;
+}
+
+#else
+
+#include <time.h>
+
+static inline void cycles_init(void) {}
+
+static inline uint32_t cycles_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint32_t cycles_per_second(void) {
+    return 1000000000UL;
+}
+
+#endif
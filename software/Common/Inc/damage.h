@@ -0,0 +1,97 @@
+#pragma once
+
+#include "blit.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Damage tracking for partial frame updates.
+//
+// Each frame the caller reports what changed with damage_add(). A back buffer still holds the
+// frame it was last drawn with, so it only misses the damage of the frames drawn since then (its
+// buffer age). damage_begin() works that out for the buffer about to be drawn and returns two
+// regions: repair, which is stale in the back buffer but current in the front one and is copied
+// across by damage_repair(), and render, this frame's damage, which the caller redraws. Drawing,
+// blitting and cache maintenance are then all bounded by the damaged area. Buffers whose age is
+// unknown or too old for the history are redrawn in full.
+//
+// Regions hold a few rectangles. Adding one merges it with any other where drawing their bounds
+// costs less than drawing both plus DAMAGE_RECT_COST_PX, the fixed cost of handling a rectangle
+// separately; a full region merges the pair whose bounds grow least.
+
+#define DAMAGE_MAX_RECTS 16
+#define DAMAGE_MAX_BUFFERS 4
+// Frames of damage remembered; buffers older than this are redrawn in full.
+#define DAMAGE_HISTORY DAMAGE_MAX_BUFFERS
+// Roughly what a DMA2D job's setup and a cache maintenance call cost, in pixels of fill.
+#define DAMAGE_RECT_COST_PX 256
+
+typedef enum {
+    DAMAGE_STATUS_OK,
+    DAMAGE_STATUS_NULL_ARG,
+    DAMAGE_STATUS_BAD_CONFIG,  // No buffers, more than DAMAGE_MAX_BUFFERS, or an empty screen.
+    DAMAGE_STATUS_BAD_INDEX
+} damage_status_t;
+
+typedef struct {
+    uint8_t count;
+    rect_t rects[DAMAGE_MAX_RECTS];
+} damage_region_t;
+
+typedef struct {
+    damage_region_t repair;  // Copy from the front buffer.
+    damage_region_t render;  // Draw this frame.
+    uint8_t age;             // Frames since the back buffer was drawn; 0 if it never was.
+    bool full;               // render is the whole screen.
+} damage_frame_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t full_frames;
+    uint32_t rendered_px;
+    uint32_t repaired_px;
+    uint32_t merges;
+} damage_stats_t;
+
+typedef struct {
+    rect_t bounds;
+    uint8_t num_buffers;
+    int8_t front;                               // Buffer ended last, -1 before the first frame.
+    bool full_repaint;
+    uint32_t frame;                             // Frames ended so far.
+    uint32_t buffer_frame[DAMAGE_MAX_BUFFERS];  // Frame each buffer holds, 0 for none.
+    damage_region_t history[DAMAGE_HISTORY];    // Frame n's damage at [n % DAMAGE_HISTORY].
+    damage_region_t pending;                    // This frame's, so far.
+    damage_stats_t stats;
+} damage_tracker_t;
+
+void damage_region_clear(damage_region_t* region);
+// Adds rect, merging as above. Empty rectangles are ignored.
+void damage_region_add(damage_region_t* region, const rect_t* rect);
+uint32_t damage_region_area(const damage_region_t* region);
+
+// Starts with every buffer's contents unknown.
+damage_status_t damage_init(damage_tracker_t* tracker, uint16_t width, uint16_t height,
+                            uint8_t num_buffers);
+// Marks rect (clipped to the screen) as changed this frame.
+void damage_add(damage_tracker_t* tracker, const rect_t* rect);
+void damage_add_all(damage_tracker_t* tracker);
+
+// Debug override: every frame renders the whole screen, as if nothing were tracked. Damage that
+// was never reported shows up as stale pixels once this is turned off again.
+void damage_set_full_repaint(damage_tracker_t* tracker, bool full_repaint);
+
+// Works out what buffer index needs for this frame.
+damage_status_t damage_begin(damage_tracker_t* tracker, uint8_t index, damage_frame_t* frame);
+// Queues copies of frame->repair from front to back, returning the last one's sequence number in
+// *seq (may be NULL). The caller may draw outside the repaired area straight away, but must wait
+// for *seq before touching it.
+blit_status_t damage_repair(const damage_frame_t* frame, const surface_t* back,
+                            const surface_t* front, uint32_t* seq);
+// Records that buffer index now holds this frame, and starts the next one.
+damage_status_t damage_end(damage_tracker_t* tracker, uint8_t index);
+// The buffer ended last, i.e. the one to repair from; -1 before the first frame.
+int8_t damage_front(const damage_tracker_t* tracker);
+
+void damage_get_stats(const damage_tracker_t* tracker, damage_stats_t* stats);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ipc.h"
+#include "video_timing.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Display management.
+//
+// The CM4 owns the SiI1136 and everything that talks to it over the 100 kHz I2C bus: TPI setup,
+// hot-plug detection, DDC/EDID reads and mode selection. The CM7 never touches the bus; it sends
+// requests over the IPC rings and gets a response per request, tagged with the sequence number it
+// was given, plus unsolicited events when a sink is plugged in or removed.
+
+// Highest pixel clock the scan-out path is budgeted for (LTDC reading 16 bpp from SDRAM while the
+// CM7 and DMA2D render into the same device).
+#define DISPLAY_MAX_PIXEL_CLOCK_KHZ 75000
+// The SiI1136 cannot lock below this.
+#define DISPLAY_MIN_PIXEL_CLOCK_KHZ 25000
+
+// How often the CM4 re-checks the hot-plug state if no interrupt arrives.
+#define DISPLAY_SERVICE_POLL_MS 100
+// A sink's EDID may not be readable straight after HPD asserts.
+#define DISPLAY_SERVICE_HPD_SETTLE_MS 200
+
+#define DISPLAY_CLIENT_MAX_PENDING 8
+
+typedef enum {
+    DISPLAY_STATUS_OK,
+    DISPLAY_STATUS_NULL_ARG,
+    DISPLAY_STATUS_BUSY,          // Too many requests in flight, or the IPC ring is full.
+    DISPLAY_STATUS_BAD_REQUEST,
+    DISPLAY_STATUS_I2C_ERR,
+    DISPLAY_STATUS_NO_SINK,
+    DISPLAY_STATUS_EDID_ERR,      // EDID unreadable or corrupt; a safe fallback mode was used.
+    DISPLAY_STATUS_MODE_UNSUPPORTED
+} display_status_t;
+
+typedef enum {
+    DISPLAY_OP_GET_STATE,  // Current mode; status is NO_SINK if nothing is connected.
+    DISPLAY_OP_SET_MODE,   // Program the given timing, or pick the best one if pixel_clock_khz == 0.
+    DISPLAY_OP_SET_OUTPUT, // Enable (arg = 1) or disable (arg = 0) the TMDS output.
+    DISPLAY_OP_RESCAN      // Re-read the EDID and re-select the mode.
+} display_op_t;
+
+typedef enum {
+    DISPLAY_EVENT_CONNECTED,     // mode holds the mode the CM4 selected and programmed.
+    DISPLAY_EVENT_DISCONNECTED
+} display_event_type_t;
+
+// Payload of IPC_MSG_DISPLAY_REQUEST.
+typedef struct {
+    uint16_t seq;
+    uint8_t op;
+    uint8_t arg;
+    video_timing_t timing;
+} display_request_t;
+
+// Payload of IPC_MSG_DISPLAY_RESPONSE.
+typedef struct {
+    uint16_t seq;
+    uint8_t op;
+    uint8_t status;
+    video_timing_t mode;
+} display_response_t;
+
+// Payload of IPC_MSG_DISPLAY_EVENT.
+typedef struct {
+    uint8_t event;
+    uint8_t status;
+    uint16_t _reserved;
+    video_timing_t mode;
+} display_event_t;
+
+_Static_assert(sizeof(display_request_t) <= IPC_PAYLOAD_SIZE_B, "display request too large");
+_Static_assert(sizeof(display_response_t) <= IPC_PAYLOAD_SIZE_B, "display response too large");
+_Static_assert(sizeof(display_event_t) <= IPC_PAYLOAD_SIZE_B, "display event too large");
+
+#if defined(CORE_CM4)
+
+#include "stm32h7xx_hal.h"
+
+/***** SERVICE (CM4) *****/
+
+// Brings up the SiI1136 TPI on the given bus. If a sink is already connected, also reads its EDID,
+// programs a mode and sends DISPLAY_EVENT_CONNECTED, without waiting out the hot-plug settle time.
+display_status_t display_service_init(I2C_HandleTypeDef* i2c);
+// Handles a display request. Returns false for messages that are not display requests.
+bool display_service_handle(const ipc_msg_t* msg);
+// Hot-plug housekeeping; call from the CM4 main loop at least every DISPLAY_SERVICE_POLL_MS. Also
+// retries responses and events held back by a full IPC ring; the service never waits on the CM7.
+// Output is enabled whenever a mode is selected for a newly connected sink or a rescan.
+void display_service_poll(void);
+// Call from the SiI1136 INT pin's EXTI interrupt.
+void display_service_irq(void);
+
+#endif
+
+#if defined(CORE_CM7)
+
+/***** CLIENT (CM7) *****/
+
+typedef void (*display_response_callback_t)(const display_response_t* response, void* user);
+typedef void (*display_event_callback_t)(const display_event_t* event, void* user);
+
+// Sends a request without waiting. callback (may be NULL) runs from display_client_handle() when
+// the response arrives. timing is only used by DISPLAY_OP_SET_MODE and may otherwise be NULL.
+display_status_t display_client_request(display_op_t op, uint8_t arg, const video_timing_t* timing,
+                                        display_response_callback_t callback, void* user);
+// Routes display responses and events. Returns false for messages that are not for the client.
+bool display_client_handle(const ipc_msg_t* msg);
+void display_client_set_event_callback(display_event_callback_t callback, void* user);
+// Last state reported by the CM4. Returns false if no sink is connected.
+bool display_client_get_mode(video_timing_t* mode);
+
+#endif
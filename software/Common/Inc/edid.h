@@ -1,8 +1,13 @@
+#pragma once
+
+#include "video_timing.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
 #define EDID_BASIC_SIZE_B 128
+#define EDID_NUM_DETAILED_TIMINGS 4
 
 typedef struct {
     const uint8_t _data[EDID_BASIC_SIZE_B];
@@ -144,12 +149,5 @@ edid_status_t edid_get_timing_has_pxl_fmt_and_refrate(edid_t* edid,
                                                       bool* timing_has_pxl_fmt_and_refrate);
 edid_status_t edid_get_continuous_freq(edid_t* edid, bool* freq_is_continuous);
 
-uint8_t edid_buf[EDID_BASIC_SIZE_B] = {
-    0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x10, 0xac, 0x34, 0x12, 0x66, 0x2e, 0x4b, 0x42,
-    0x0e, 0x14, 0x01, 0x03, 0x80, 0x33, 0x1d, 0x78, 0x2a, 0x81, 0xf1, 0xa3, 0x57, 0x53, 0x9f, 0x27,
-    0x0a, 0x50, 0x54, 0xbf, 0xef, 0x80, 0x81, 0x00, 0x95, 0x00, 0xb3, 0x00, 0x81, 0x40, 0x71, 0x4f,
-    0x81, 0x80, 0xa9, 0x40, 0x95, 0x0f, 0x02, 0x3a, 0x80, 0x18, 0x71, 0x38, 0x2d, 0x40, 0x58, 0x2c,
-    0x45, 0x00, 0xfe, 0x1f, 0x11, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x38, 0x4b, 0x1e,
-    0x51, 0x11, 0x00, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0xfc, 0x00, 0x53,
-    0x4d, 0x58, 0x4c, 0x32, 0x33, 0x37, 0x30, 0x48, 0x44, 0x0a, 0x20, 0x20, 0x00, 0x00, 0x00, 0xff,
-    0x00, 0x48, 0x31, 0x41, 0x4b, 0x35, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0a, 0x20, 0x20, 0x00, 0xa1};
+edid_status_t edid_get_established_timings(edid_t* edid, uint32_t* timings);
+edid_status_t edid_get_detailed_timing(edid_t* edid, uint8_t index, video_timing_t* timing);
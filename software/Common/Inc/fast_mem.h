@@ -0,0 +1,24 @@
+#pragma once
+
+// Placement attributes for hot paths on the Cortex-M7.
+//
+// FAST_CODE functions are copied from flash into ITCM by the startup code and execute with zero
+// wait states; use it for rasterizer inner loops, blend kernels and interrupt handlers. Calls
+// between ITCM and flash are out of direct branch range and go through linker-generated veneers,
+// so keep the whole hot loop inside ITCM rather than calling back out to flash per pixel.
+//
+// FAST_DATA objects are copied into DTCM with the same startup loop. Use it for lookup tables
+// that would otherwise be read from flash (const data lives in .rodata). GCC refuses to mix
+// const and non-const objects in one named section within a translation unit, so declare
+// FAST_DATA tables without const.
+//
+// SystemInit() runs before the copy and must never be marked FAST_CODE. The CM4 has no TCMs,
+// and host builds have no special sections, so both macros expand to nothing there.
+
+#if defined(CORE_CM7)
+#define FAST_CODE __attribute__((section(".itcm_text"), noinline))
+#define FAST_DATA __attribute__((section(".dtcm_data"), aligned(4)))
+#else
+#define FAST_CODE
+#define FAST_DATA
+#endif
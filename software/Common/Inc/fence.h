@@ -0,0 +1,73 @@
+#pragma once
+
+#include "mem_map.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Cross-core fences.
+//
+// A fence is a monotonically increasing 32-bit value in shared memory with a single signalling
+// context. The producer signals a value once everything it promised for that value (a display
+// list, a rendered frame, a finished DMA) is visible; consumers wait until the fence reaches the
+// value they need. Values are compared modulo 2^32, so they may wrap but never go backwards.
+//
+// If the fence has a doorbell (an HSEM ID from hsem_ids.h), signalling rings it so a waiter on
+// the other core wakes from WFE at once. Fences that are signalled and waited on by the same core
+// (e.g. from a DMA interrupt) need none: taking the interrupt already ends the WFE.
+//
+// Every signal is stamped with the shared timebase, and the last few can be looked up afterwards
+// to measure latency across the cores.
+
+// Signals whose timestamps are kept; the oldest of them may be mid-overwrite and is never used.
+#define FENCE_HISTORY 4
+#define FENCE_NO_DOORBELL 0xFFFFFFFFUL
+#define FENCE_WAIT_FOREVER 0xFFFFFFFFUL
+
+typedef enum {
+    FENCE_STATUS_OK,
+    FENCE_STATUS_NULL_ARG,
+    FENCE_STATUS_BAD_ID,
+    FENCE_STATUS_BAD_VALUE,  // Signal would move the fence backwards.
+    FENCE_STATUS_TIMEOUT,
+    FENCE_STATUS_PENDING,    // Value not reached yet.
+    FENCE_STATUS_EXPIRED     // Value reached too long ago for its timestamp to be kept.
+} fence_status_t;
+
+typedef struct {
+    uint32_t value;
+    uint32_t time_us;
+} fence_point_t;
+
+// Lives in shared_mem_t (or in any memory both sides can see uncached).
+typedef struct SHARED_ALIGNED {
+    volatile uint32_t value;
+    volatile uint32_t signals;  // Number of signals, indexes history.
+    fence_point_t history[FENCE_HISTORY];
+    uint32_t sem_id;
+} fence_t;
+
+static inline bool fence_value_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static inline uint32_t fence_value(const fence_t* fence) {
+    return fence->value;
+}
+
+static inline bool fence_reached(const fence_t* fence, uint32_t value) {
+    return !fence_value_before(fence->value, value);
+}
+
+// Resets the fence to 0. sem_id is its doorbell or FENCE_NO_DOORBELL. Call before either core
+// uses it.
+fence_status_t fence_init(fence_t* fence, uint32_t sem_id);
+// Waiting core: routes the fence's doorbell to this core so fence_wait() wakes promptly.
+fence_status_t fence_attach(const fence_t* fence);
+// Signalling context: advances the fence to value, stamps it, and rings the doorbell.
+fence_status_t fence_signal(fence_t* fence, uint32_t value);
+// Sleeps in WFE until the fence reaches value. Reads made after an OK return see everything the
+// producer wrote before signalling.
+fence_status_t fence_wait(const fence_t* fence, uint32_t value, uint32_t timeout_us);
+// Timebase time at which the fence first reached value.
+fence_status_t fence_timestamp(const fence_t* fence, uint32_t value, uint32_t* time_us);
@@ -0,0 +1,26 @@
+#pragma once
+
+// Central allocation of the 32 hardware semaphores. Every user of HSEM takes its ID from here so
+// two subsystems can never end up sharing one by accident. An ID is used either as a doorbell
+// (hsem_notify.h, fence.h) or as a lock (hsem_lock.h), never both.
+
+// Boot release of the CM4 by the CM7 (CubeMX's HSEM_ID_0).
+#define HSEM_ID_BOOT 0U
+
+// IPC doorbells, one per direction; released by the producer to wake the consumer.
+#define HSEM_ID_IPC_TO_CM4 1U
+#define HSEM_ID_IPC_TO_CM7 2U
+
+// Tile scheduler: lock for the rare case where both cores race for the last tile, and the CM4's
+// end-of-frame doorbell to the CM7.
+#define HSEM_ID_TILE_SCHED 3U
+#define HSEM_ID_TILE_DONE 4U
+
+// Geometry/raster pipeline: the CM4 tells the CM7 a display list is ready.
+#define HSEM_ID_PIPELINE_READY 5U
+
+// Overlay buffer queue: a buffer was queued (to the consumer) or released (to the producer).
+#define HSEM_ID_OVERLAY_QUEUED 6U
+#define HSEM_ID_OVERLAY_RELEASED 7U
+
+#define HSEM_ID_COUNT 32U
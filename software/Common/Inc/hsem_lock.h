@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core_id.h"
+#include "hsem_ids.h"
+#include "mem_map.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Cross-core locks on top of the hardware semaphores.
+//
+// Every lock is identified by its HSEM ID from hsem_ids.h; the semaphore itself is the lock state,
+// so a mutex needs no memory of its own. A contended acquire spins for a short while, then arms
+// the semaphore's free notification and sleeps in WFE until the holder releases it.
+//
+// HSEM locks are owned by a core, not by a context: taking one that this core already holds
+// succeeds at once. They exclude the other core only; code on one core that takes the same lock
+// from thread and interrupt context must serialize that itself.
+//
+// Each lock keeps per-core statistics in shared memory, so either core (or a debugger) can see
+// where the two cores collide. Cycle counts are in the acquiring core's own clock.
+
+// Attempts before a contended acquire gives up spinning and waits for the release.
+#define HSEM_LOCK_SPIN_TRIES 32
+
+typedef enum {
+    HSEM_LOCK_STATUS_OK,
+    HSEM_LOCK_STATUS_BAD_ID,
+    HSEM_LOCK_STATUS_BUSY  // Trylock only: held by the other core (or, for a writer, by readers).
+} hsem_lock_status_t;
+
+typedef struct SHARED_ALIGNED {
+    uint32_t acquires;
+    uint32_t contended;        // Acquires that found the lock held and had to wait.
+    uint32_t try_failures;
+    uint32_t max_wait_cycles;
+    uint32_t max_hold_cycles;
+    uint32_t cycles_per_s;
+} hsem_lock_stats_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    hsem_lock_stats_t stats[HSEM_ID_COUNT][CORE_ID_COUNT];  // Indexed by HSEM ID.
+} hsem_lock_shared_t;
+
+// Reader/writer lock for data that is read often by both cores and rarely changed. The HSEM
+// guards the reader count and is held for the whole of a write.
+typedef struct SHARED_ALIGNED {
+    volatile uint32_t readers;
+    uint32_t sem_id;
+} hsem_rwlock_t;
+
+// Call once per core, after the shared region is set up.
+void hsem_lock_init(void);
+
+hsem_lock_status_t hsem_mutex_lock(uint32_t sem_id);
+hsem_lock_status_t hsem_mutex_trylock(uint32_t sem_id);
+void hsem_mutex_unlock(uint32_t sem_id);
+
+// Called by the core that owns the protected data, before the other core can use it.
+hsem_lock_status_t hsem_rwlock_init(hsem_rwlock_t* lock, uint32_t sem_id);
+void hsem_rwlock_read_lock(hsem_rwlock_t* lock);
+void hsem_rwlock_read_unlock(hsem_rwlock_t* lock);
+void hsem_rwlock_write_lock(hsem_rwlock_t* lock);
+hsem_lock_status_t hsem_rwlock_write_trylock(hsem_rwlock_t* lock);
+void hsem_rwlock_write_unlock(hsem_rwlock_t* lock);
+
+void hsem_lock_get_stats(uint32_t sem_id, core_id_t core, hsem_lock_stats_t* stats);
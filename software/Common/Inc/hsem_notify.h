@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Cross-core doorbells on top of HSEM free notifications.
+//
+// Taking and immediately releasing a semaphore raises the "free" interrupt on whichever core has
+// notification enabled for it, which is all a doorbell needs. The HAL masks the interrupt for an ID
+// each time it fires; the dispatcher here re-arms it before running the callback.
+//
+// Callbacks run in interrupt context on the receiving core.
+
+typedef void (*hsem_notify_callback_t)(uint32_t sem_id, void* user);
+
+typedef enum {
+    HSEM_NOTIFY_STATUS_OK,
+    HSEM_NOTIFY_STATUS_BAD_ID,
+    HSEM_NOTIFY_STATUS_BUSY  // Semaphore held by someone else; the doorbell was not rung.
+} hsem_notify_status_t;
+
+// Enables this core's HSEM interrupt. Call once, after the HSEM clock is on.
+void hsem_notify_init(void);
+// Routes free notifications for sem_id to callback on this core. A NULL callback disarms it.
+hsem_notify_status_t hsem_notify_register(uint32_t sem_id, hsem_notify_callback_t callback,
+                                          void* user);
+// Rings the doorbell for sem_id. Never blocks.
+hsem_notify_status_t hsem_notify_signal(uint32_t sem_id);
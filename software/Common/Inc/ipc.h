@@ -0,0 +1,94 @@
+#pragma once
+
+#include "mem_map.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Inter-core message rings.
+//
+// One single-producer/single-consumer ring per direction, living in the shared region. Each core
+// only ever writes its own index (the producer owns head, the consumer owns tail), so no
+// read-modify-write is shared between the cores and both ends are wait-free. This matters on the
+// H7: there is no global exclusive monitor, so LDREX/STREX would not be atomic across cores anyway.
+//
+// Indices run freely and wrap at 2^32; the slot is index % IPC_RING_SLOTS. The producer rings an
+// HSEM doorbell only when the consumer had drained the ring, so a busy stream costs no interrupts.
+
+#define IPC_RING_SLOTS 64  // Power of two.
+#define IPC_PAYLOAD_SIZE_B 28
+
+#define IPC_WAIT_FOREVER UINT32_MAX
+
+typedef enum {
+    IPC_STATUS_OK,
+    IPC_STATUS_NULL_ARG,
+    IPC_STATUS_TOO_LONG,
+    IPC_STATUS_FULL,
+    IPC_STATUS_EMPTY,
+    IPC_STATUS_TIMEOUT
+} ipc_status_t;
+
+typedef enum {
+    IPC_MSG_NONE = 0,
+
+    // ipc_bench.c
+    IPC_MSG_BENCH_PING,
+    IPC_MSG_BENCH_PONG,
+    IPC_MSG_BENCH_BULK,
+    IPC_MSG_BENCH_BULK_DONE,
+
+    // display_service.c / display_client.c
+    IPC_MSG_DISPLAY_REQUEST,
+    IPC_MSG_DISPLAY_RESPONSE,
+    IPC_MSG_DISPLAY_EVENT,
+
+    // tile_sched.c
+    IPC_MSG_TILE_SCHED_FRAME,
+
+    // pipeline.c
+    IPC_MSG_PIPELINE_KICK
+} ipc_msg_type_t;
+
+// One message per cache line.
+typedef struct SHARED_ALIGNED {
+    uint16_t type;
+    uint16_t len;
+    uint8_t payload[IPC_PAYLOAD_SIZE_B];
+} ipc_msg_t;
+
+typedef struct {
+    volatile uint32_t head SHARED_ALIGNED;  // Written by the producer only.
+    volatile uint32_t tail SHARED_ALIGNED;  // Written by the consumer only.
+    ipc_msg_t slots[IPC_RING_SLOTS];
+} ipc_ring_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    ipc_ring_t to_cm4;
+    ipc_ring_t to_cm7;
+} ipc_shared_t;
+
+_Static_assert(sizeof(ipc_msg_t) == CACHE_LINE_SIZE_B, "IPC slots must be one cache line");
+_Static_assert((IPC_RING_SLOTS & (IPC_RING_SLOTS - 1)) == 0, "IPC ring size must be 2^n");
+
+// Per-core counters.
+typedef struct {
+    uint32_t sent;
+    uint32_t received;
+    uint32_t full;            // Sends rejected because the ring was full.
+    uint32_t doorbells_sent;
+    uint32_t doorbells_received;
+} ipc_stats_t;
+
+// Arms this core's receive doorbell. Call on both cores once the shared region is attached.
+void ipc_init(void);
+
+// Copies len bytes of payload into the next slot of this core's outgoing ring.
+ipc_status_t ipc_send(uint16_t type, const void* payload, uint16_t len);
+// Pops the next message from this core's incoming ring, or returns IPC_STATUS_EMPTY.
+ipc_status_t ipc_recv(ipc_msg_t* msg);
+// As ipc_recv(), but sleeps in WFE until a message arrives or timeout_ms elapses.
+ipc_status_t ipc_recv_wait(ipc_msg_t* msg, uint32_t timeout_ms);
+
+void ipc_get_stats(ipc_stats_t* stats);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ipc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// IPC ring benchmark. The CM7 drives it with ipc_bench_run(); the CM4 answers from its message
+// loop via ipc_bench_handle(). Times are in CM7 cycles.
+
+#define IPC_BENCH_ROUND_TRIPS 1000
+#define IPC_BENCH_BULK_MESSAGES 100000
+
+typedef struct {
+    uint32_t round_trip_min_cycles;
+    uint32_t round_trip_avg_cycles;
+    uint32_t round_trip_max_cycles;
+    uint32_t bulk_messages;
+    uint32_t bulk_cycles;
+    uint32_t bulk_messages_per_s;
+} ipc_bench_result_t;
+
+// CM7: runs a ping-pong latency test, then streams IPC_BENCH_BULK_MESSAGES one way and waits for
+// the CM4 to confirm it received all of them.
+#if defined(CORE_CM7)
+ipc_status_t ipc_bench_run(ipc_bench_result_t* result);
+#endif
+// CM4: handles benchmark messages. Returns false for anything that is not one.
+bool ipc_bench_handle(const ipc_msg_t* msg);
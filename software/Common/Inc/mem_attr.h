@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mem_map.h"
+
+#include <stdint.h>
+
+// Cache policy applied to a memory region by the CM7 MPU.
+typedef enum {
+    MEM_ATTR_NO_ACCESS,        // Strongly ordered, no access, execute-never.
+    MEM_ATTR_WRITE_BACK,       // Normal, write-back, read/write allocate.
+    MEM_ATTR_WRITE_THROUGH,    // Normal, write-through, no write allocate.
+    MEM_ATTR_UNCACHED,         // Normal, non-cacheable.
+    MEM_ATTR_UNCACHED_SHARED   // Normal, non-cacheable, shareable between bus masters.
+} mem_attr_policy_t;
+
+// Framebuffers default to write-back; cache maintenance is then done per dirty rectangle before
+// DMA2D/LTDC touch them. Build with MEM_ATTR_FB_WRITE_THROUGH=1 to trade CPU write bandwidth for
+// never having to clean.
+#ifndef MEM_ATTR_FB_WRITE_THROUGH
+#define MEM_ATTR_FB_WRITE_THROUGH 0
+#endif
+
+#if MEM_ATTR_FB_WRITE_THROUGH
+#define MEM_ATTR_FB_POLICY MEM_ATTR_WRITE_THROUGH
+#else
+#define MEM_ATTR_FB_POLICY MEM_ATTR_WRITE_BACK
+#endif
+
+// MPU region table: X(number, base, size, policy). Later entries take priority where regions
+// overlap, so the SDRAM framebuffer window overrides the SDRAM-wide default. Every entry is
+// checked at build time for a power-of-two size of at least 32 bytes and a size-aligned base.
+#define MEM_ATTR_REGIONS(X)                                                   \
+    X(0, FMC_BANK1_BASE, FMC_BANK1_SIZE, MEM_ATTR_NO_ACCESS)                   \
+    X(1, SDRAM_BASE, SDRAM_SIZE, MEM_ATTR_WRITE_BACK)                          \
+    X(2, SDRAM_FB_BASE, SDRAM_FB_SIZE, MEM_ATTR_FB_POLICY)                     \
+    X(3, AXI_SRAM_NC_BASE, AXI_SRAM_NC_SIZE, MEM_ATTR_UNCACHED)                \
+    X(4, SHARED_SRAM_BASE, SHARED_SRAM_SIZE, MEM_ATTR_UNCACHED_SHARED)
+
+// Places a buffer in the uncached AXI SRAM window, aligned to a cache line. Buffers here can be
+// handed to DMA without any cache maintenance. The CM4 has no data cache, so there it only aligns.
+#if defined(CORE_CM7)
+#define DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(CACHE_LINE_SIZE_B)))
+#else
+#define DMA_BUFFER __attribute__((aligned(CACHE_LINE_SIZE_B)))
+#endif
+
+// Places a buffer in cacheable AXI SRAM, aligned to a cache line. For working buffers the CPU
+// hits hard but a DMA master (which cannot reach the DTCM) also reads or writes; whoever hands
+// them over does the cache maintenance.
+#if defined(CORE_CM7)
+#define AXI_BUFFER __attribute__((section(".axi_buffer"), aligned(CACHE_LINE_SIZE_B)))
+#else
+#define AXI_BUFFER __attribute__((aligned(CACHE_LINE_SIZE_B)))
+#endif
+
+void mem_attr_init(void);
+mem_attr_policy_t mem_attr_get_policy(uintptr_t addr);
@@ -0,0 +1,52 @@
+#pragma once
+
+/*************************
+ ***** EXTERNAL SDRAM *****
+ *************************/
+
+// 64 MB SDRAM on FMC SDRAM bank 1.
+#define SDRAM_BASE 0xC0000000UL
+#define SDRAM_SIZE (64UL * 1024 * 1024)
+
+// The bottom of SDRAM is reserved for framebuffers; everything above it is handed to the
+// general-purpose asset heap (decoded images, glyph atlases, mesh buffers, etc.).
+#define SDRAM_FB_BASE SDRAM_BASE
+#define SDRAM_FB_SIZE (16UL * 1024 * 1024)
+#define SDRAM_HEAP_BASE (SDRAM_FB_BASE + SDRAM_FB_SIZE)
+#define SDRAM_HEAP_SIZE (SDRAM_SIZE - SDRAM_FB_SIZE)
+
+// D-cache line size of the Cortex-M7. DMA buffers must be aligned to (and sized in multiples of)
+// this so that cache maintenance never touches a neighbouring object.
+#define CACHE_LINE_SIZE_B 32
+
+// Gives an object (or struct member) a cache line to itself. Used for anything shared between the
+// cores so that two writers never share a line.
+#define SHARED_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE_B)))
+
+/**************************
+ ***** ON-CHIP MEMORY *****
+ **************************/
+
+// CM7 DTCM (128 KB). Zero-wait-state for the CM7 only; the DMA2D and LTDC cannot reach it.
+#define DTCM_BASE 0x20000000UL
+#define DTCM_SIZE (128UL * 1024)
+
+// D1 AXI SRAM (512 KB). The CM7 keeps general-purpose working buffers in the cacheable low part
+// and DMA buffers / bulk inter-core data in the uncached top part.
+#define AXI_SRAM_BASE 0x24000000UL
+#define AXI_SRAM_SIZE (512UL * 1024)
+#define AXI_SRAM_NC_SIZE (128UL * 1024)
+#define AXI_SRAM_NC_BASE (AXI_SRAM_BASE + AXI_SRAM_SIZE - AXI_SRAM_NC_SIZE)
+
+// D3 SRAM4 (64 KB). Reachable by both cores and stays powered while D1/D2 sleep; used for the
+// inter-core shared region.
+#define SHARED_SRAM_BASE 0x38000000UL
+#define SHARED_SRAM_SIZE (64UL * 1024)
+
+/**********************
+ ***** FMC BANK 1 *****
+ **********************/
+
+// NOR/PSRAM bank 1. Unused on this board, but enabled after reset.
+#define FMC_BANK1_BASE 0x60000000UL
+#define FMC_BANK1_SIZE (256UL * 1024 * 1024)
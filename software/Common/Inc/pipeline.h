@@ -0,0 +1,145 @@
+#pragma once
+
+#include "core_id.h"
+#include "fence.h"
+#include "ipc.h"
+#include "mem_map.h"
+#include "raster.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Two-stage frame pipeline: geometry on the CM4, rasterization on the CM7.
+//
+// The CM4 runs the scene for frame N+1 through transform, back-face cull, guard-band clip and
+// binning while the CM7 rasterizes frame N from the other display list. The lists are
+// double-buffered (frame N lives in lists[N % 2]). Two fences hand them back and forth: ready
+// (signalled by the CM4 with the frame whose list is complete) and consumed (signalled by the CM7
+// with the frame it finished rasterizing). A list is free for frame N once consumed >= N - 2.
+//
+// The lists themselves are allocated by the CM7 in the uncached AXI SRAM window and published
+// through shared memory. Neither side needs cache maintenance to see the other's writes.
+//
+// The CM7 renders each tile of the target in an on-chip tile buffer: it clears the tile, draws
+// the tile's triangles into it, and queues a DMA2D copy of the finished tile to the target while
+// it renders the next one in a second buffer. All overdraw stays in AXI SRAM and the D-cache, and
+// every target pixel is written exactly once per frame, in whole tiles. Tiles whose pixels do not
+// fit PIPELINE_TILE_BUFFER_B are drawn straight into the target instead.
+//
+// The firmware does not run the pipeline yet: pipeline_raster_frame() needs a whole-frame target,
+// and there is none until the SDRAM is brought up (scan-out races the beam in strips meanwhile).
+// The CM4 already routes its messages, so starting it takes pipeline_set_scene() on the CM4 and
+// pipeline_init() plus a per-frame pipeline_raster_frame() on the CM7. Until then, building both
+// cores with PIPELINE_BENCH runs it on a small on-chip target (see pipeline_bench.h).
+//
+// The CM7 wakes the CM4 with an IPC kick after each frame. If the CM4's ring stays full for
+// PIPELINE_KICK_TIMEOUT_US the kick is retried at the start of the next frame instead, and that
+// frame fails rather than waiting for a list the CM4 was never asked for.
+
+#define PIPELINE_NUM_LISTS 2
+#define PIPELINE_MAX_TRIS 512
+#define PIPELINE_MAX_TILES 1024
+#define PIPELINE_MAX_BIN_ENTRIES 4096
+
+#define PIPELINE_KICK_TIMEOUT_US 1000
+
+// Size of each of the CM7's two tile buffers, e.g. 64x64 RGB565 or 64x32 ARGB8888.
+#define PIPELINE_TILE_BUFFER_B (8 * 1024)
+#define PIPELINE_DEFAULT_CLEAR_ARGB 0xFF000000UL
+
+// Triangles may extend this far past the viewport before they are clipped. Keeps every vertex
+// within int16 pixels, and so within range of the rasterizer's edge functions.
+#define PIPELINE_GUARD_BAND_PX 2048
+
+typedef enum {
+    PIPELINE_STATUS_OK,
+    PIPELINE_STATUS_NULL_ARG,
+    PIPELINE_STATUS_BAD_LAYOUT,
+    PIPELINE_STATUS_IPC_ERR
+} pipeline_status_t;
+
+// A binned display list: triangles in screen space, and for each tile the indices of the
+// triangles that touch it (tile t uses tile_prims[tile_offsets[t]] .. [tile_offsets[t + 1] - 1]).
+typedef struct {
+    uint32_t frame;
+    uint16_t num_tris;
+    uint16_t num_tiles;
+    uint16_t tile_offsets[PIPELINE_MAX_TILES + 1];
+    uint16_t tile_prims[PIPELINE_MAX_BIN_ENTRIES];
+    raster_tri_t tris[PIPELINE_MAX_TRIS];
+} pipeline_list_t;
+
+typedef struct SHARED_ALIGNED {
+    uint32_t frames;
+    uint32_t last_cycles;   // CM4: geometry time. CM7: raster time. Last frame.
+    uint32_t stall_cycles;  // CM7 only: waiting for the CM4's list, last frame.
+    uint32_t flush_cycles;  // CM7 only: waiting for tile write-back to free a buffer, last frame.
+    uint32_t tris_in;       // CM4 only, last frame: submitted, and left after cull/clip.
+    uint32_t tris_out;
+    uint32_t dropped;       // CM4 only: triangles that did not fit in the list, total.
+    uint32_t cycles_per_s;
+} pipeline_core_stats_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    fence_t ready;           // Last frame whose list is complete. CM4.
+    fence_t consumed;        // Last frame rasterized. CM7.
+    struct SHARED_ALIGNED {  // Written once by the CM7 in pipeline_init().
+        pipeline_list_t* lists[PIPELINE_NUM_LISTS];
+        uint16_t width;
+        uint16_t height;
+        uint16_t tile_w;
+        uint16_t tile_h;
+        uint16_t cols;
+        uint16_t rows;
+        volatile uint16_t depth;  // Lists the CM4 may fill ahead of the CM7; 1 runs them serially.
+    } config;
+    pipeline_core_stats_t stats[CORE_ID_COUNT];
+} pipeline_shared_t;
+
+/***** GEOMETRY (CM4) *****/
+
+typedef struct {
+    float x;
+    float y;
+} pipeline_vec2_t;
+
+// 2D affine transform: x' = m[0] * x + m[1] * y + m[2], y' = m[3] * x + m[4] * y + m[5].
+typedef struct {
+    float m[6];
+} pipeline_transform_t;
+
+typedef struct pipeline_builder pipeline_builder_t;
+
+// Called once per frame on the CM4 to submit that frame's geometry.
+typedef void (*pipeline_scene_fn_t)(pipeline_builder_t* builder, uint32_t frame, void* user);
+
+#if defined(CORE_CM4)
+void pipeline_set_scene(pipeline_scene_fn_t scene, void* user);
+// Transforms, culls, clips and bins num_tris indexed triangles. With cull_backfaces unset,
+// back-facing triangles are flipped instead of dropped.
+void pipeline_submit(pipeline_builder_t* builder, const pipeline_vec2_t* verts,
+                     const uint16_t* indices, uint16_t num_tris,
+                     const pipeline_transform_t* transform, uint32_t argb, bool cull_backfaces);
+// Builds lists for every free slot. Returns false for messages that are not for the pipeline.
+bool pipeline_handle(const ipc_msg_t* msg);
+#endif
+
+/***** RASTER (CM7) *****/
+
+#if defined(CORE_CM7)
+// Publishes the lists and the tiling, then starts the CM4 on the first two frames.
+pipeline_status_t pipeline_init(uint16_t width, uint16_t height, uint16_t tile_w, uint16_t tile_h);
+// Rasterizes the next frame into target (which must match the size given to pipeline_init()),
+// waiting for the CM4 if its list is not ready yet. Every pixel is cleared to the clear colour
+// first. Returns the frame number once target is complete, 0 on error.
+uint32_t pipeline_raster_frame(const surface_t* target);
+void pipeline_set_clear_color(uint32_t argb);
+// With overlap off (on by default) the CM4 starts a frame's geometry only once the CM7 has
+// finished reading the previous list, so the two stages take turns. For measuring what the
+// overlap gains; takes effect over the next frame or two.
+void pipeline_set_overlap(bool overlap);
+#endif
+
+void pipeline_get_stats(core_id_t core, pipeline_core_stats_t* stats);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pipeline.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Geometry/raster pipeline benchmark. Built into both cores with PIPELINE_BENCH: the CM4 submits
+// pipeline_bench_scene() (PIPELINE_BENCH_TRIS triangles, rotated a little each frame) and the CM7
+// drives frames with pipeline_bench_run(), first with the stages overlapped and then with them
+// taking turns. Overlapped frames should take about as long as the slower stage, serial ones as
+// long as both together. Times are in microseconds on the shared timebase.
+
+#define PIPELINE_BENCH_TRIS 256
+#define PIPELINE_BENCH_FRAMES 100
+// Frames run after switching modes before timing starts, so lists built ahead are used up.
+#define PIPELINE_BENCH_WARMUP_FRAMES 4
+#define PIPELINE_BENCH_WIDTH 128
+#define PIPELINE_BENCH_HEIGHT 128
+#define PIPELINE_BENCH_TILE_PX 32
+
+typedef struct {
+    uint32_t frames;
+    uint32_t frame_us;     // Wall time per frame, mean.
+    uint32_t geometry_us;  // CM4 per list, mean.
+    uint32_t raster_us;    // CM7 per frame, mean, including the last tile's write-back.
+    uint32_t stall_us;     // CM7 waiting for the CM4's list, mean.
+} pipeline_bench_mode_t;
+
+typedef struct {
+    pipeline_bench_mode_t overlapped;
+    pipeline_bench_mode_t serial;
+} pipeline_bench_result_t;
+
+#if defined(CORE_CM4)
+// Register with pipeline_set_scene().
+void pipeline_bench_scene(pipeline_builder_t* builder, uint32_t frame, void* user);
+#endif
+
+#if defined(CORE_CM7)
+// Calls pipeline_init() for target, which must be PIPELINE_BENCH_WIDTH x PIPELINE_BENCH_HEIGHT in
+// DMA2D-reachable memory, and leaves the pipeline overlapped. Returns false if a frame failed.
+bool pipeline_bench_run(const surface_t* target, pipeline_bench_result_t* result);
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Row-wise pixel-format conversion.
+//
+// Sources may be ARGB8888, RGB888, RGB565, ARGB1555, ARGB4444, L8 (through a CLUT) or A8 (alpha
+// over a fixed colour); destinations any of those except L8. Results are exactly those of the
+// reference per-pixel path (blit_unpack()/blit_pack(), i.e. the DMA2D's arithmetic):
+// pixel_convert_row() only reorganises the work, which the benchmark checks.
+//
+// The common pairs have word-at-a-time kernels that move two to four pixels per 32-bit load or
+// store and do the channel arithmetic on packed words, using the DSP pack/extract instructions
+// where the core has them. A few pixels at the start run per pixel until both rows are
+// word-aligned, and so do the last ones. Rows that can never both be aligned (e.g. an ARGB8888
+// row at an odd halfword) run per pixel throughout.
+
+typedef enum {
+    PIXEL_CONVERT_STATUS_OK,
+    PIXEL_CONVERT_STATUS_NULL_ARG,   // Also an L8 source without params.
+    PIXEL_CONVERT_STATUS_BAD_FORMAT
+} pixel_convert_status_t;
+
+typedef struct {
+    const uint32_t* clut;  // L8 sources: ARGB8888 entries. Indices past clut_size read as 0.
+    uint16_t clut_size;
+    uint32_t rgb;          // A8 sources: the colour every pixel gets, 0x00RRGGBB.
+} pixel_convert_params_t;
+
+bool pixel_convert_supported(pixel_format_t dst_format, pixel_format_t src_format);
+
+// Converts count pixels from src to dst. The rows must not overlap unless they are the same
+// format. params may be NULL unless the source is L8.
+pixel_convert_status_t pixel_convert_row(uint8_t* dst, pixel_format_t dst_format,
+                                         const uint8_t* src, pixel_format_t src_format,
+                                         uint32_t count, const pixel_convert_params_t* params);
+// The per-pixel reference.
+pixel_convert_status_t pixel_convert_row_ref(uint8_t* dst, pixel_format_t dst_format,
+                                             const uint8_t* src, pixel_format_t src_format,
+                                             uint32_t count, const pixel_convert_params_t* params);
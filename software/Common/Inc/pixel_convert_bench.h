@@ -0,0 +1,32 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pixel-format conversion benchmark and self-check. For each pair with a word-at-a-time kernel,
+// times pixel_convert_row() against the per-pixel reference on long aligned rows, then compares
+// the two byte for byte over every combination of row alignment and a range of short lengths, so
+// the head/tail handling is covered too. Runs on the CM7 (built with PIXEL_CONVERT_BENCH) and on
+// the host via Tools/pixel_convert_bench.c. Cycles are the core's own, or nanoseconds on the host.
+
+#define PIXEL_CONVERT_BENCH_PIXELS 1024
+#define PIXEL_CONVERT_BENCH_CASES 10
+// Source, kernel output and reference output rows, each with room to be misaligned.
+#define PIXEL_CONVERT_BENCH_SCRATCH_B (3 * (PIXEL_CONVERT_BENCH_PIXELS * 4 + 8))
+
+typedef struct {
+    pixel_format_t dst_format;
+    pixel_format_t src_format;
+    uint32_t cycles_per_kpx;      // pixel_convert_row(), per 1000 pixels.
+    uint32_t ref_cycles_per_kpx;  // pixel_convert_row_ref().
+    uint32_t mismatches;          // Output bytes where the two differed.
+} pixel_convert_bench_case_t;
+
+typedef struct {
+    pixel_convert_bench_case_t cases[PIXEL_CONVERT_BENCH_CASES];
+} pixel_convert_bench_result_t;
+
+// scratch needs PIXEL_CONVERT_BENCH_SCRATCH_B bytes, word-aligned.
+bool pixel_convert_bench_run(void* scratch, pixel_convert_bench_result_t* result);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core_id.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+// Fixed-size block pools that both cores allocate from and free to without HSEM round trips.
+//
+// The H7 has no global exclusive monitor, so nothing can be compare-and-swapped across the cores.
+// Each pool is therefore split into two partitions, one per core. A core allocates only from its
+// own partition, through a tagged-index free list whose head lives in that core's private memory
+// and is updated with LDREX/STREX (safe against its own interrupts). Freeing a block from the
+// other partition pushes its index onto an SPSC return ring in shared memory; the home core pulls
+// returned blocks back onto its free list when it runs dry. Return rings are as large as a
+// partition can be, so a free never fails or waits.
+//
+// Free blocks hold their free-list link in their first bytes. Storage must be visible to both
+// cores without cache maintenance, e.g. the CM7's uncached AXI window.
+
+#define POOL_MAX_BLOCKS 512  // Per pool; indices fit in the 16-bit free-list links.
+#define POOL_MIN_BLOCK_SIZE_B 4
+#define POOL_BLOCK_ALIGN_B 8
+
+// Central allocation of pool IDs, like hsem_ids.h for semaphores.
+typedef enum {
+    POOL_ID_SPRITES,
+    POOL_ID_DISPLAY_NODES,
+    POOL_ID_EVENTS,
+    POOL_COUNT
+} pool_id_t;
+
+typedef enum {
+    POOL_STATUS_OK,
+    POOL_STATUS_NULL_ARG,
+    POOL_STATUS_BAD_ID,
+    POOL_STATUS_BAD_CONFIG,
+    POOL_STATUS_NOT_INITIALIZED
+} pool_status_t;
+
+// Per-partition counters, written only by the home core.
+typedef struct SHARED_ALIGNED {
+    uint32_t allocs;
+    uint32_t failures;    // Allocations that found the partition empty.
+    uint32_t returned;    // Blocks the other core freed back to this partition.
+    uint32_t in_use;      // Allocated and not yet back on the free list.
+    uint32_t high_water;  // Largest in_use seen.
+    uint32_t num_blocks;
+} pool_stats_t;
+
+// Blocks homed on one core that the other core has freed.
+typedef struct {
+    volatile uint32_t head SHARED_ALIGNED;  // Written by the freeing core.
+    volatile uint32_t tail SHARED_ALIGNED;  // Written by the home core.
+    uint16_t slots[POOL_MAX_BLOCKS];
+} pool_return_ring_t;
+
+typedef struct SHARED_ALIGNED {
+    uint32_t magic;
+    uint8_t* storage;
+    uint32_t block_size_b;
+    uint16_t num_blocks;
+    uint16_t cm7_blocks;  // Blocks [0, cm7_blocks) are homed on the CM7, the rest on the CM4.
+    pool_stats_t stats[CORE_ID_COUNT];
+    pool_return_ring_t returns[CORE_ID_COUNT];  // Indexed by home core.
+} pool_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    pool_t pools[POOL_COUNT];
+} pool_shared_t;
+
+// CM7: describes the pool. storage (POOL_BLOCK_ALIGN_B aligned) holds num_blocks blocks of
+// block_size_b, rounded up to a multiple of POOL_BLOCK_ALIGN_B; cm7_blocks of them go to the
+// CM7's partition. Both cores must then attach.
+pool_status_t pool_init(pool_id_t id, void* storage, uint32_t block_size_b, uint32_t num_blocks,
+                        uint32_t cm7_blocks);
+// Builds this core's free list. Call once per core after pool_init().
+pool_status_t pool_attach(pool_id_t id);
+
+// NULL when this core's partition is exhausted. Usable from interrupts.
+void* pool_alloc(pool_id_t id);
+// Accepts blocks from either partition. Usable from interrupts.
+void pool_free(pool_id_t id, void* block);
+
+void pool_get_stats(pool_id_t id, core_id_t core, pool_stats_t* stats);
+
+// Typed wrappers: POOL_DEFINE_TYPED(sprite, sprite_t, POOL_ID_SPRITES) gives sprite_alloc() and
+// sprite_free().
+#define POOL_DEFINE_TYPED(name, type, id)                                                    \
+    _Static_assert(sizeof(type) >= POOL_MIN_BLOCK_SIZE_B, #type " is too small for a pool"); \
+    static inline type* name##_alloc(void) {                                                 \
+        return (type*)pool_alloc(id);                                                        \
+    }                                                                                        \
+    static inline void name##_free(type* block) {                                            \
+        pool_free(id, block);                                                                \
+    }
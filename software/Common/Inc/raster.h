@@ -0,0 +1,50 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdint.h>
+
+// Triangle rasterizer, flat or Gouraud shaded.
+//
+// Vertices are screen-space fixed point with RASTER_SUBPIXEL_BITS fractional bits (28.4) and must
+// lie within int16 pixels. Triangles must be wound so that their signed area is positive
+// (clockwise on screen, since y points down); the geometry stage culls or flips the rest. Pixels
+// are sampled at their centres with a top-left fill rule, so triangles sharing an edge never both
+// cover a pixel.
+//
+// Coverage is tested on 4x1 pixel blocks with incremental edge functions, rejecting whole blocks
+// (and windows of blocks) at once. Shaded triangles interpolate colour incrementally as packed
+// 16-bit lanes, using the DSP SIMD instructions where the core has them. Only ARGB8888, RGB888,
+// RGB565 and L8 targets are drawn. On L8 the low byte of argb is the palette index, so shaded
+// triangles interpolate indices, e.g. across a palette ramp that is then colour-cycled.
+
+#define RASTER_SUBPIXEL_BITS 4
+#define RASTER_SUBPIXEL_ONE (1 << RASTER_SUBPIXEL_BITS)
+
+typedef struct {
+    int32_t x[3];
+    int32_t y[3];
+    uint32_t argb;
+} raster_tri_t;
+
+// Twice the signed area, in squared sub-pixel units.
+static inline int64_t raster_tri_area2(const raster_tri_t* tri) {
+    return (int64_t)(tri->x[1] - tri->x[0]) * (tri->y[2] - tri->y[0]) -
+           (int64_t)(tri->x[2] - tri->x[0]) * (tri->y[1] - tri->y[0]);
+}
+
+// Pixel bounds of the triangle, half-open.
+rect_t raster_tri_bounds(const raster_tri_t* tri);
+
+// Vertex colours are interpolated across the triangle, each channel to within one level.
+typedef struct {
+    int32_t x[3];
+    int32_t y[3];
+    uint32_t argb[3];
+} raster_shaded_tri_t;
+
+// Fills the pixels of tri that lie inside clip (which must lie inside target). Both return the
+// number of pixels written.
+uint32_t raster_triangle(const surface_t* target, const rect_t* clip, const raster_tri_t* tri);
+uint32_t raster_shaded_triangle(const surface_t* target, const rect_t* clip,
+                                const raster_shaded_tri_t* tri);
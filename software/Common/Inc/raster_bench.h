@@ -0,0 +1,32 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Rasterizer throughput. Draws the same pseudo-random triangles, flat and shaded, at a few sizes
+// into a caller-supplied target. Runs on the CM7 (built with RASTER_BENCH) and on the host via
+// Tools/raster_bench.c, so the SIMD and portable inner loops can be compared. Cycles are the
+// core's own, or nanoseconds on the host.
+
+#define RASTER_BENCH_TRIS 1000
+#define RASTER_BENCH_SIZES 3
+#define RASTER_BENCH_CASES (2 * RASTER_BENCH_SIZES)
+
+typedef struct {
+    uint16_t size_px;  // Vertices lie within a square of this side.
+    bool shaded;
+    uint32_t tris;
+    uint32_t pixels;
+    uint32_t cycles;
+    uint32_t tris_per_s;
+    uint32_t pixels_per_s;
+} raster_bench_case_t;
+
+typedef struct {
+    raster_bench_case_t cases[RASTER_BENCH_CASES];
+} raster_bench_result_t;
+
+// target must be at least as large as the biggest size, in any format the rasterizer draws.
+bool raster_bench_run(const surface_t* target, raster_bench_result_t* result);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "surface.h"
+#include "video_timing.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// LTDC scan-out.
+//
+// The CM7 drives the LTDC straight from the video_timing_t the CM4 programmed into the SiI1136,
+// so both ends of the parallel bus always agree on the mode. The pixel clock comes from PLL3,
+// using its fractional divider to hit the timing's clock to within a few ppm.
+//
+// One layer shows a framebuffer, placed anywhere in the active area over a solid background.
+// Page flips only change the layer's shadow registers and ask for a reload at vertical blanking,
+// so the LTDC switches buffers between frames (never mid-frame) and nothing is copied. A flip
+// counts as done once the reload has happened; from then on the previous buffer is no longer
+// scanned and may be drawn into. Framebuffers in cacheable memory must be cleaned before they
+// are shown.
+//
+// Strip mode ("racing the beam") needs no framebuffer at all. A ring of a few strip buffers, each
+// strip_lines tall, is rendered just ahead of the scan line: the LTDC's line interrupt fires at
+// every strip boundary, frees the strip that has just been scanned and points a layer at the one
+// after next, and scanout_strip_poll() renders into every free buffer in display order. The two
+// layers take alternate strips, so each is reprogrammed (with an immediate reload, which leaves
+// the other layer's identical registers alone) while the other is being scanned. A strip that is
+// not ready by the time the scan reaches it counts as a deadline miss and shows whatever its
+// buffer last held; the renderer then skips ahead rather than falling further behind. Content is
+// drawn at most num_strips strips before it is shown, so the input-to-photon latency is a
+// fraction of a frame, and the whole output fits in on-chip SRAM.
+//
+// Indexed surfaces (L8, AL44, AL88) are looked up in a 256-entry palette, which both layers share.
+// Palette changes are made to a copy and written to the LTDC's CLUTs by the line interrupt at the
+// start of the next vertical blanking (in strip mode too, wherever the strips end), so a frame
+// never shows half of an update. Colour cycling is then just a rotation of
+// palette entries: an animated full-screen effect costs no pixel writes at all.
+//
+// The board wires R[7:3], G[7:2] and B[7:3] to the SiI1136, so RGB565 loses nothing.
+
+// Shown outside the layer window, 0x00RRGGBB.
+#define SCANOUT_BACKGROUND_RGB 0x000000UL
+
+#define SCANOUT_PALETTE_SIZE 256
+
+#define SCANOUT_MIN_STRIPS 2
+#define SCANOUT_MAX_STRIPS 16
+
+typedef enum {
+    SCANOUT_STATUS_OK,
+    SCANOUT_STATUS_NULL_ARG,
+    SCANOUT_STATUS_BAD_TIMING,   // Interlaced, or outside what the LTDC registers can hold.
+    SCANOUT_STATUS_BAD_SURFACE,  // Format the LTDC cannot read, or does not fit the active area.
+    SCANOUT_STATUS_CLOCK_ERR,    // Pixel clock out of PLL3's range.
+    SCANOUT_STATUS_NOT_RUNNING,
+    SCANOUT_STATUS_BUSY,         // The previous flip has not been latched yet.
+    SCANOUT_STATUS_TIMEOUT,
+    SCANOUT_STATUS_WRONG_MODE,   // Flip in strip mode, or strip poll outside it.
+    SCANOUT_STATUS_BAD_PALETTE   // Entries past SCANOUT_PALETTE_SIZE.
+} scanout_status_t;
+
+typedef struct {
+    uint32_t pixel_clock_hz;  // Achieved, which may differ slightly from the timing's.
+    uint32_t flips;           // Latched by the LTDC.
+    uint32_t busy;            // Rejected because a flip was still pending.
+    uint32_t underruns;       // FIFO ran dry: memory could not keep up with the pixel clock.
+    uint32_t transfer_errors;
+    // Strip mode.
+    uint32_t strip_frames;
+    uint32_t strips;          // Rendered.
+    uint32_t strip_misses;    // Not rendered when the scan reached them.
+    uint32_t strip_skips;     // Abandoned by the renderer because they were already being shown.
+    uint32_t strip_min_lead;  // Fewest strips between one finishing and the scan reaching it.
+    // Indexed colour.
+    uint32_t palette_updates;  // Latched by the LTDC.
+    uint32_t palette_entries;  // Written to the CLUTs.
+} scanout_stats_t;
+
+// Draws one strip: the lines y .. y + strip->height - 1 of frame, in strip's own coordinates.
+typedef void (*scanout_strip_fn_t)(const surface_t* strip, uint16_t y, uint32_t frame,
+                                   void* user);
+
+typedef struct {
+    uint16_t width;   // Of the area the strips cover, at (x, y) in the active area.
+    uint16_t height;  // A multiple of strip_lines is best; the last strip is cut short otherwise.
+    int16_t x;
+    int16_t y;
+    pixel_format_t format;
+    uint16_t strip_lines;
+    uint8_t num_strips;  // In the ring, SCANOUT_MIN_STRIPS .. SCANOUT_MAX_STRIPS.
+    scanout_strip_fn_t render;
+    void* user;
+} scanout_strip_config_t;
+
+#if defined(CORE_CM7)
+
+// Resets the LTDC and sets up its pins, clock gate and interrupt. Scan-out stays off.
+scanout_status_t scanout_init(void);
+// (Re)starts scan-out with the given timing, showing surface with its top-left corner at (x, y)
+// in the active area. Stops any previous scan-out first, so the output glitches once.
+scanout_status_t scanout_start(const video_timing_t* timing, const surface_t* surface, int16_t x,
+                               int16_t y);
+// (Re)starts scan-out in strip mode. buffer (size_b bytes, outside the DTCM) holds the ring;
+// each strip takes width * bytes-per-pixel * strip_lines. The first num_strips strips are
+// rendered before this returns.
+scanout_status_t scanout_start_strips(const video_timing_t* timing,
+                                      const scanout_strip_config_t* config, void* buffer,
+                                      uint32_t size_b);
+scanout_status_t scanout_stop(void);
+bool scanout_running(void);
+
+// Shows surface from the next vertical blanking on. It may differ from the current one in format
+// and size as long as it still fits at the current position. *seq (may be NULL) identifies the
+// flip for scanout_flip_done() and scanout_wait_flip().
+scanout_status_t scanout_flip(const surface_t* surface, uint32_t* seq);
+bool scanout_flip_pending(void);
+bool scanout_flip_done(uint32_t seq);
+// Sleeps until flip seq has been latched, or timeout_us (or FENCE_WAIT_FOREVER) passes.
+scanout_status_t scanout_wait_flip(uint32_t seq, uint32_t timeout_us);
+
+// Strip mode: renders every strip whose buffer is free, in display order, and returns how many.
+// Call from the main loop, often enough to keep ahead of the scan: the line interrupt only frees
+// buffers, and nothing is drawn into them until the next call.
+uint32_t scanout_strip_poll(void);
+
+// Sets count palette entries from first on, as 0x00RRGGBB, from the next vertical blanking on.
+// Updates made before then are latched together. *seq (may be NULL) identifies the update for
+// scanout_palette_done() and scanout_wait_palette(). While scan-out is stopped the entries are
+// simply stored, and loaded when it starts. The palette starts as a grey ramp.
+scanout_status_t scanout_set_palette(const uint32_t* rgb, uint16_t first, uint16_t count,
+                                     uint32_t* seq);
+// Colour cycling: moves entries first .. first + count - 1 up by step places (down if negative),
+// wrapping around within the range, latched like scanout_set_palette().
+scanout_status_t scanout_rotate_palette(uint16_t first, uint16_t count, int16_t step,
+                                        uint32_t* seq);
+bool scanout_palette_done(uint32_t seq);
+scanout_status_t scanout_wait_palette(uint32_t seq, uint32_t timeout_us);
+
+void scanout_get_stats(scanout_stats_t* stats);
+
+// Call from LTDC_IRQHandler().
+void scanout_irq(void);
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "boot.h"
+#include "buffer_queue.h"
+#include "hsem_lock.h"
+#include "ipc.h"
+#include "mem_map.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "tile_sched.h"
+#include "trace.h"
+
+#include <stdint.h>
+
+// Inter-core shared region.
+//
+// Exactly one object, shared_mem, lives in the .shared section (D3 SRAM4). Both images are built
+// from the same definition, so every field has the same address on both cores without anything
+// being hard-coded. Subsystems that need cross-core state add a cache-line-aligned member to
+// shared_mem_t and bump SHARED_MEM_VERSION; the boot handshake refuses to run two images that
+// disagree on version or layout size.
+//
+// The region is uncached on the CM7 (see mem_attr.h) and the CM4 has no data cache, so plain
+// loads/stores plus barriers are enough to communicate through it.
+
+#define SHARED_MEM_MAGIC 0x43475757UL  // "WWGC"
+#define SHARED_MEM_VERSION 13
+
+typedef enum {
+    SHARED_MEM_STATUS_OK,
+    SHARED_MEM_STATUS_BAD_MAGIC,
+    SHARED_MEM_STATUS_BAD_VERSION,
+    SHARED_MEM_STATUS_BAD_LAYOUT,
+    SHARED_MEM_STATUS_TIMEOUT
+} shared_mem_status_t;
+
+// Per-core handshake state. The CM7 zeroes the region before publishing the header, so stale
+// values from before a reset can never look valid.
+typedef enum {
+    SHARED_MEM_CORE_OFF = 0x00000000,
+    SHARED_MEM_CORE_READY = 0x52454459,  // "REDY"
+    SHARED_MEM_CORE_FAILED = 0x4641494C  // "FAIL"
+} shared_mem_core_state_t;
+
+typedef struct SHARED_ALIGNED {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t _reserved;
+    uint32_t size_b;     // sizeof(shared_mem_t) as compiled into the CM7 image.
+    uintptr_t address;   // &shared_mem as linked into the CM7 image.
+    volatile uint32_t cm7_state;
+    volatile uint32_t cm4_state;
+} shared_mem_header_t;
+
+typedef struct {
+    shared_mem_header_t header;
+    boot_shared_t boot;
+    hsem_lock_shared_t hsem_lock;
+    ipc_shared_t ipc;
+    tile_sched_shared_t tile_sched;
+    pipeline_shared_t pipeline;
+    buffer_queue_shared_t buffer_queue;
+    pool_shared_t pool;
+    trace_shared_t trace;
+} shared_mem_t;
+
+extern shared_mem_t shared_mem;
+
+// CM7, before releasing the CM4: clears the region and publishes the header.
+shared_mem_status_t shared_mem_init(void);
+// CM4, after wake-up: validates the header against its own build and acknowledges.
+shared_mem_status_t shared_mem_attach(void);
+// CM7: waits for the CM4's acknowledgement.
+shared_mem_status_t shared_mem_wait_attached(uint32_t timeout_ms);
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "stm32h7xx_hal.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -22,8 +24,8 @@ typedef enum {
 	SII1136_TPI_STATUS_READY, SII1136_TPI_STATUS_BAD_ID, SII1136_TPI_STATUS_I2C_ERR
 } sii1136_tpi_status_t;
 
-const uint8_t SII1136_TPI_ADDR_LOW = 0x72;  // I2C address if CI2CA is held low.
-const uint8_t SII1136_TPI_ADDR_HIGH = 0x76; // I2C address if CI2CA is held high.
+static const uint8_t SII1136_TPI_ADDR_LOW = 0x72;  // I2C address if CI2CA is held low.
+static const uint8_t SII1136_TPI_ADDR_HIGH = 0x76; // I2C address if CI2CA is held high.
 
 /***************************
  ***** REGISTER VALUES *****
@@ -442,14 +444,17 @@ sii1136_status_t sii1136_set_int_en_flags(sii1136_t* self, bool auth_change_int_
 
 sii1136_status_t sii1136_get_auth_chg_pending(sii1136_t* self, bool* auth_change_pending);
 sii1136_status_t sii1136_get_sec_chg_pending(sii1136_t* self, bool* security_change_pending);
-sii1136_status_t sii1136_get_audio_err_pending(sii1136_t* self, bool* auth_change_pending);
-sii1136_status_t sii1136_get_rx_sns_detected(sii1136_t* self, bool* auth_change_pending);
-sii1136_status_t sii1136_get_cpi_event_pending(sii1136_t* self, bool* auth_change_pending);
-sii1136_status_t sii1136_get_hot_plug_state(sii1136_t* self, bool* auth_change_pending);
+sii1136_status_t sii1136_get_audio_err_pending(sii1136_t* self, bool* audio_err_pending);
+sii1136_status_t sii1136_get_rx_sns_detected(sii1136_t* self, bool* rx_sense_detected);
+sii1136_status_t sii1136_get_cpi_event_pending(sii1136_t* self, bool* cpi_event_pending);
+sii1136_status_t sii1136_get_hot_plug_state(sii1136_t* self, bool* hot_plug_state);
 sii1136_status_t sii1136_get_ctrl_bus_pending(sii1136_t* self, bool* ctrl_bus_event_pending);
-sii1136_status_t sii1136_get_rx_sns_event_pending(sii1136_t* self, bool* auth_change_pending);
-sii1136_status_t sii1136_get_ctrl_bus_err_pending(sii1136_t* self, bool* auth_change_pending);
-sii1136_status_t sii1136_get_conn_event_pending(sii1136_t* self, bool* auth_change_pending);
+sii1136_status_t sii1136_get_rx_sns_event_pending(sii1136_t* self, bool* rx_sense_event_pending);
+sii1136_status_t sii1136_get_ctrl_bus_err_pending(sii1136_t* self, bool* ctrl_bus_err_pending);
+sii1136_status_t sii1136_get_conn_event_pending(sii1136_t* self, bool* conn_event_pending);
+
+sii1136_status_t sii1136_clear_rx_sns_event_pending(sii1136_t* self);
+sii1136_status_t sii1136_clear_conn_event_pending(sii1136_t* self);
 
 /***** POWER STATE REGISTER *****/
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pixel formats. Values match the DMA2D colour mode and LTDC pixel format encodings so they can
+// be written to either peripheral directly.
+typedef enum {
+    PIXEL_FORMAT_ARGB8888 = 0x00,
+    PIXEL_FORMAT_RGB888 = 0x01,
+    PIXEL_FORMAT_RGB565 = 0x02,
+    PIXEL_FORMAT_ARGB1555 = 0x03,
+    PIXEL_FORMAT_ARGB4444 = 0x04,
+    PIXEL_FORMAT_L8 = 0x05,
+    PIXEL_FORMAT_AL44 = 0x06,
+    PIXEL_FORMAT_AL88 = 0x07,
+    PIXEL_FORMAT_A8 = 0x09
+} pixel_format_t;
+
+// Axis-aligned rectangle, half-open: covers x0 <= x < x1, y0 <= y < y1.
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} rect_t;
+
+// A 2D pixel buffer. The stride may be larger than width * bytes-per-pixel.
+typedef struct {
+    uint8_t* pixels;
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride_b;
+    pixel_format_t format;
+} surface_t;
+
+static inline uint8_t pixel_format_bytes(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return 4;
+        case PIXEL_FORMAT_RGB888:
+            return 3;
+        case PIXEL_FORMAT_RGB565:
+        case PIXEL_FORMAT_ARGB1555:
+        case PIXEL_FORMAT_ARGB4444:
+        case PIXEL_FORMAT_AL88:
+            return 2;
+        case PIXEL_FORMAT_L8:
+        case PIXEL_FORMAT_AL44:
+        case PIXEL_FORMAT_A8:
+            return 1;
+    }
+    return 0;
+}
+
+static inline uint8_t* surface_pixel_addr(const surface_t* surface, int16_t x, int16_t y) {
+    return surface->pixels + (uint32_t)y * surface->stride_b +
+           (uint32_t)x * pixel_format_bytes(surface->format);
+}
+
+static inline rect_t surface_bounds(const surface_t* surface) {
+    rect_t bounds = {0, 0, (int16_t)surface->width, (int16_t)surface->height};
+    return bounds;
+}
+
+static inline bool rect_is_empty(const rect_t* rect) {
+    return rect->x1 <= rect->x0 || rect->y1 <= rect->y0;
+}
+
+static inline uint32_t rect_area(const rect_t* rect) {
+    return rect_is_empty(rect) ? 0 : (uint32_t)(rect->x1 - rect->x0) * (uint32_t)(rect->y1 - rect->y0);
+}
+
+static inline rect_t rect_intersect(const rect_t* a, const rect_t* b) {
+    rect_t r = {a->x0 > b->x0 ? a->x0 : b->x0, a->y0 > b->y0 ? a->y0 : b->y0,
+                a->x1 < b->x1 ? a->x1 : b->x1, a->y1 < b->y1 ? a->y1 : b->y1};
+    return r;
+}
+
+// Smallest rectangle covering both. An empty input does not widen the result.
+static inline rect_t rect_union(const rect_t* a, const rect_t* b) {
+    if (rect_is_empty(a)) {
+        return *b;
+    } else if (rect_is_empty(b)) {
+        return *a;
+    }
+    rect_t r = {a->x0 < b->x0 ? a->x0 : b->x0, a->y0 < b->y0 ? a->y0 : b->y0,
+                a->x1 > b->x1 ? a->x1 : b->x1, a->y1 > b->y1 ? a->y1 : b->y1};
+    return r;
+}
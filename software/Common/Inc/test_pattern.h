@@ -0,0 +1,18 @@
+#pragma once
+
+#include "surface.h"
+
+#include <stdint.h>
+
+// Bring-up picture: eight colour bars (white, yellow, cyan, green, magenta, red, blue, black)
+// across the target, scrolling left by TEST_PATTERN_SPEED_PX each frame. Any part of a frame can
+// be drawn on its own and lines up with the rest, so strips and tiles need no shared state.
+// Drawn with blit_fill(), so it works in every format the blitter fills.
+
+#define TEST_PATTERN_BARS 8
+#define TEST_PATTERN_SPEED_PX 2
+
+// Draws rect of frame into target. Bars are target->width / TEST_PATTERN_BARS wide.
+void test_pattern_draw(const surface_t* target, const rect_t* rect, uint32_t frame);
+// The same as a tile_sched_render_fn_t, with arg the frame number; register it on both cores.
+void test_pattern_tile(const surface_t* target, const rect_t* tile, uint32_t arg, void* user);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core_id.h"
+#include "fence.h"
+#include "ipc.h"
+#include "mem_map.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tile scheduler shared by both cores.
+//
+// Each frame the target surface is cut into tiles, numbered in raster order. The CM7 takes tiles
+// from the front of the range and the CM4 from the back, so the two only ever compete for the
+// last tile. Each side publishes its own index and then reads the other's (the THE protocol used
+// by work-stealing deques). Only when the indices meet does a core fall back to the
+// HSEM_ID_TILE_SCHED lock to settle who gets the last tile. Neither core idles while a tile is
+// left, and the faster core takes more of them.
+//
+// The frame ends with a barrier: the CM7 does not return from tile_sched_render_frame() until the
+// CM4 has finished its last tile, so the caller can present straight away. The CM4 joins a frame
+// under the lock and the CM7 closes it under the same lock. If the CM4 is still busy with something
+// else when the CM7 runs out of tiles, the CM7 closes the frame and does not wait for it. Nor does
+// the CM7 wait to invite it: if the CM4's ring is full (it is stuck on I2C, say), the CM7 renders
+// the whole frame itself and returns TILE_SCHED_STATUS_SOLO.
+//
+// Tiles must cover whole cache lines. The CM7 cleans each tile as soon as it is rendered, and a
+// line shared with a CM4 tile could otherwise be written back over the CM4's pixels.
+
+#define TILE_SCHED_MAX_TILES 4096
+
+typedef enum {
+    TILE_SCHED_STATUS_OK,
+    TILE_SCHED_STATUS_NULL_ARG,
+    TILE_SCHED_STATUS_BAD_LAYOUT,  // Tiles would split a cache line, or there are too many.
+    TILE_SCHED_STATUS_IPC_ERR,
+    TILE_SCHED_STATUS_SOLO         // Rendered, but by the CM7 alone: the IPC ring was full.
+} tile_sched_status_t;
+
+// Renders one tile. Runs on whichever core claimed it; each core registers its own.
+typedef void (*tile_sched_render_fn_t)(const surface_t* target, const rect_t* tile, uint32_t arg,
+                                       void* user);
+
+// Per-core counters, written only by their own core. Cycles are in that core's own clock.
+typedef struct SHARED_ALIGNED {
+    uint32_t frames;
+    uint32_t tiles;           // Total tiles rendered.
+    uint32_t last_tiles;      // Tiles rendered in the last frame.
+    uint32_t lock_fallbacks;  // Claims that had to take the HSEM lock.
+    uint32_t busy_cycles;     // Rendering, in the last frame.
+    uint32_t idle_cycles;     // CM7: waiting at the barrier. CM4: between frames. Last frame.
+    uint32_t cycles_per_s;
+} tile_sched_core_stats_t;
+
+// Member of shared_mem_t. front and back are reset by the CM7 before a frame is opened; after
+// that the CM7 only writes front and the CM4 only writes back.
+typedef struct {
+    volatile uint32_t front SHARED_ALIGNED;       // Next tile for the CM7.
+    volatile uint32_t back SHARED_ALIGNED;        // One past the next tile for the CM4.
+    volatile uint32_t open_frame SHARED_ALIGNED;  // Frame the CM4 may still join; 0 once closed.
+    volatile uint32_t joined SHARED_ALIGNED;      // Last frame the CM4 joined.
+    fence_t done;                                 // Last frame the CM4 finished.
+    struct SHARED_ALIGNED {                       // Frame description, written by the CM7.
+        uint32_t frame;
+        surface_t target;
+        uint16_t tile_w;
+        uint16_t tile_h;
+        uint16_t cols;
+        uint16_t num_tiles;
+        uint32_t arg;
+    } job;
+    tile_sched_core_stats_t stats[CORE_ID_COUNT];
+} tile_sched_shared_t;
+
+// Registers this core's tile renderer. Call on both cores after ipc_init().
+void tile_sched_init(tile_sched_render_fn_t render, void* user);
+
+#if defined(CORE_CM7)
+// Renders a whole frame across both cores and returns once every tile is finished. arg is passed
+// to the renderers unchanged (e.g. a scene or display list index).
+tile_sched_status_t tile_sched_render_frame(const surface_t* target, uint16_t tile_w,
+                                            uint16_t tile_h, uint32_t arg);
+#endif
+
+// CM4: joins the frame announced by msg. Returns false for messages that are not for the scheduler.
+bool tile_sched_handle(const ipc_msg_t* msg);
+
+void tile_sched_get_stats(core_id_t core, tile_sched_core_stats_t* stats);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+// Microsecond timebase shared by both cores.
+//
+// Unlike cycles.h, whose counters are private to each core, this reads TIM2: a 32-bit timer in
+// D2 that both cores can see. The CM7 starts it as soon as the CM4 has parked itself in stop (not
+// before, or D2 could not enter DStop), so readings are also time since boot to within a few
+// microseconds, and retunes it after any clock change; the CM4 only reads it. Timestamps from
+// the two cores can therefore be compared directly, and wrap after about 71 minutes, so compare
+// them with timebase_elapsed_us().
+
+#define TIMEBASE_HZ 1000000UL
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+
+#include "stm32h7xx_hal.h"
+
+#if defined(CORE_CM7)
+static inline void timebase_load_prescaler(void) {
+    // APB1 timers run at twice PCLK1 whenever the APB1 prescaler divides (TIMPRE is left clear).
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+    uint32_t timer_hz = (RCC->D2CFGR & RCC_D2CFGR_D2PPRE1_2) != 0 ? pclk1 * 2 : pclk1;
+    TIM2->PSC = timer_hz / TIMEBASE_HZ - 1;
+    TIM2->EGR = TIM_EGR_UG;  // Load the prescaler now rather than at the next overflow.
+}
+
+// Starts TIM2 counting at TIMEBASE_HZ from zero.
+static inline void timebase_init(void) {
+    RCC->APB1LENR |= RCC_APB1LENR_TIM2EN;
+    (void)RCC->APB1LENR;  // Wait for the clock to reach the timer before touching it.
+
+    TIM2->CR1 = 0;
+    TIM2->ARR = 0xFFFFFFFFUL;
+    timebase_load_prescaler();
+    TIM2->CNT = 0;
+    TIM2->CR1 = TIM_CR1_CEN;
+}
+
+// Re-derives the prescaler after PCLK1 changed. Time carries on from where it was, give or take
+// the few cycles this takes.
+static inline void timebase_retune(void) {
+    uint32_t now = TIM2->CNT;
+    timebase_load_prescaler();
+    TIM2->CNT = now;
+}
+#endif
+
+static inline uint32_t timebase_now_us(void) {
+    return TIM2->CNT;
+}
+
+#else
+
+#include <time.h>
+
+static inline void timebase_init(void) {}
+static inline void timebase_retune(void) {}
+
+static inline uint32_t timebase_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000);
+}
+
+#endif
+
+static inline uint32_t timebase_elapsed_us(uint32_t since_us) {
+    return timebase_now_us() - since_us;
+}
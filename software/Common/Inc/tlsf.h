@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Two-Level Segregated Fit allocator. malloc() and free() are O(1) with a bounded worst case,
+// which makes it suitable for long-lived but dynamic assets in SDRAM. It has no hardware
+// dependencies, so the same file builds on the host for replaying allocation traces.
+
+// All payloads are aligned to (and all blocks sized in multiples of) one D-cache line so that
+// allocations can be handed straight to DMA2D/MDMA and cleaned/invalidated without sharing lines.
+#define TLSF_ALIGN_SIZE_LOG2 5
+#define TLSF_ALIGN_SIZE (1U << TLSF_ALIGN_SIZE_LOG2)
+
+// Each first-level (power of two) class is split into 2^TLSF_SL_INDEX_COUNT_LOG2 linear classes.
+#define TLSF_SL_INDEX_COUNT_LOG2 5
+#define TLSF_SL_INDEX_COUNT (1U << TLSF_SL_INDEX_COUNT_LOG2)
+
+// Blocks below this size are all kept in first-level class 0, split linearly by alignment.
+#define TLSF_FL_INDEX_SHIFT (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_SMALL_BLOCK_SIZE (1U << TLSF_FL_INDEX_SHIFT)
+
+// Largest block is just under 2^TLSF_FL_INDEX_MAX bytes (128 MB), enough for all of SDRAM.
+#define TLSF_FL_INDEX_MAX 27
+#define TLSF_FL_INDEX_COUNT (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+typedef struct tlsf_block tlsf_block_t;
+
+// State struct. Lives outside the pool so the pool itself can sit in uncached or slow memory.
+typedef struct {
+    uint32_t _fl_bitmap;
+    uint32_t _sl_bitmap[TLSF_FL_INDEX_COUNT];
+    tlsf_block_t* _free_lists[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+    tlsf_block_t* _first;
+
+    size_t _total_b;
+    size_t _free_b;
+    size_t _peak_used_b;
+    uint32_t _free_blocks;
+    uint32_t _used_blocks;
+} tlsf_t;
+
+typedef enum {
+    TLSF_STATUS_OK,
+    TLSF_STATUS_NULL_ARG,
+    TLSF_STATUS_POOL_TOO_SMALL,
+    TLSF_STATUS_POOL_TOO_LARGE,
+    TLSF_STATUS_CORRUPT
+} tlsf_status_t;
+
+// Snapshot of heap usage. Sizes include block headers.
+typedef struct {
+    size_t total_b;
+    size_t free_b;
+    size_t used_b;
+    size_t peak_used_b;
+    // Largest tlsf_malloc() that would currently succeed. Up to 1/32 less than the largest free
+    // block, since requests are rounded up to the next size class before the search.
+    size_t largest_free_b;
+    uint32_t free_blocks;
+    uint32_t used_blocks;
+    uint16_t fragmentation_pm;  // 1000 * (1 - largest free block / free), in permille.
+} tlsf_stats_t;
+
+// Called once per physical block by tlsf_walk(), in address order.
+typedef void (*tlsf_walk_cb_t)(void* ptr, size_t size_b, bool used, void* user);
+
+tlsf_status_t tlsf_init(tlsf_t* self, void* mem, size_t size_b);
+
+void* tlsf_malloc(tlsf_t* self, size_t size_b);
+void* tlsf_memalign(tlsf_t* self, size_t align, size_t size_b);
+void tlsf_free(tlsf_t* self, void* ptr);
+size_t tlsf_usable_size(void* ptr);
+
+tlsf_status_t tlsf_get_stats(tlsf_t* self, tlsf_stats_t* stats);
+tlsf_status_t tlsf_check(tlsf_t* self);
+tlsf_status_t tlsf_walk(tlsf_t* self, tlsf_walk_cb_t cb, void* user);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core_id.h"
+#include "mem_map.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Dual-core trace timeline.
+//
+// Each core appends compact records to its own ring in shared memory, stamped with the shared
+// timebase, so the two rings merge into one timeline. The rings are flight recorders: once full,
+// the oldest records are overwritten. Nothing on target reads them; dump shared_mem.trace from a
+// debugger and feed it to Tools/trace_merge, which writes Chrome trace JSON (also accepted by
+// Perfetto).
+//
+// Recording is a handful of stores with interrupts masked, and compiles out entirely with
+// TRACE_ENABLED set to 0.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_MAGIC 0x45435254UL  // "TRCE"
+#define TRACE_RING_RECORDS 1024   // Per core; a power of two.
+
+// New events go at the end; Tools/trace_merge.c has a name for each.
+typedef enum {
+    TRACE_EVENT_FRAME,           // arg: frame number (low 16 bits).
+    TRACE_EVENT_TILE,            // arg: tile index.
+    TRACE_EVENT_GEOMETRY,        // CM4 building a display list. arg: frame number.
+    TRACE_EVENT_DMA,             // Submit to completion, async. arg: job id.
+    TRACE_EVENT_I2C,             // arg: 8-bit device address << 8 | register.
+    TRACE_EVENT_FENCE_WAIT,      // arg: awaited value (low 16 bits).
+    TRACE_EVENT_LOCK_WAIT,       // Contended HSEM lock. arg: HSEM ID.
+    TRACE_EVENT_IPC_SEND,        // arg: message type.
+    TRACE_EVENT_BUFFER_QUEUE,    // Producer queued a buffer. arg: buffer index.
+    TRACE_EVENT_BUFFER_PRESENT,  // Consumer took it. arg: buffer index.
+    TRACE_EVENT_BOOT,            // Boot milestone; the timestamp is time since reset. arg: mark.
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+typedef enum {
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END,
+    TRACE_PHASE_INSTANT,
+    TRACE_PHASE_ASYNC_BEGIN,  // May end in another context, matched by arg.
+    TRACE_PHASE_ASYNC_END
+} trace_phase_t;
+
+typedef struct {
+    uint32_t time_us;
+    uint8_t event;
+    uint8_t phase;
+    uint16_t arg;
+} trace_record_t;
+
+typedef struct {
+    volatile uint32_t head SHARED_ALIGNED;  // Records ever written; the newest is head - 1.
+    trace_record_t records[TRACE_RING_RECORDS];
+} trace_ring_t;
+
+// Member of shared_mem_t.
+typedef struct {
+    uint32_t magic SHARED_ALIGNED;  // TRACE_MAGIC once trace_init() has run.
+    volatile uint32_t enabled;
+    trace_ring_t rings[CORE_ID_COUNT];
+} trace_shared_t;
+
+#if defined(CORE_CM7)
+// Clears both rings and starts recording.
+void trace_init(void);
+#endif
+void trace_set_enabled(bool enabled);
+void trace_record(trace_event_t event, trace_phase_t phase, uint16_t arg);
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(event, arg) trace_record((event), TRACE_PHASE_BEGIN, (uint16_t)(arg))
+#define TRACE_END(event, arg) trace_record((event), TRACE_PHASE_END, (uint16_t)(arg))
+#define TRACE_INSTANT(event, arg) trace_record((event), TRACE_PHASE_INSTANT, (uint16_t)(arg))
+#define TRACE_ASYNC_BEGIN(event, arg) trace_record((event), TRACE_PHASE_ASYNC_BEGIN, (uint16_t)(arg))
+#define TRACE_ASYNC_END(event, arg) trace_record((event), TRACE_PHASE_ASYNC_END, (uint16_t)(arg))
+#else
+#define TRACE_BEGIN(event, arg) ((void)(arg))
+#define TRACE_END(event, arg) ((void)(arg))
+#define TRACE_INSTANT(event, arg) ((void)(arg))
+#define TRACE_ASYNC_BEGIN(event, arg) ((void)(arg))
+#define TRACE_ASYNC_END(event, arg) ((void)(arg))
+#endif
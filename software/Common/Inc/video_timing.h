@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Video mode timing, in the form both the EDID detailed timing descriptors and the LTDC use:
+// active, front porch, sync and back porch for each axis.
+
+#define VIDEO_TIMING_FLAG_HSYNC_POS 0x01  // Positive horizontal sync.
+#define VIDEO_TIMING_FLAG_VSYNC_POS 0x02  // Positive vertical sync.
+#define VIDEO_TIMING_FLAG_INTERLACED 0x04
+
+typedef struct {
+    uint32_t pixel_clock_khz;  // Zero means "no mode".
+    uint16_t h_active;
+    uint16_t h_front_porch;
+    uint16_t h_sync;
+    uint16_t h_back_porch;
+    uint16_t v_active;
+    uint16_t v_front_porch;
+    uint16_t v_sync;
+    uint16_t v_back_porch;
+    uint8_t flags;
+} video_timing_t;
+
+static inline uint32_t video_timing_h_total(const video_timing_t* timing) {
+    return (uint32_t)timing->h_active + timing->h_front_porch + timing->h_sync +
+           timing->h_back_porch;
+}
+
+static inline uint32_t video_timing_v_total(const video_timing_t* timing) {
+    return (uint32_t)timing->v_active + timing->v_front_porch + timing->v_sync +
+           timing->v_back_porch;
+}
+
+// Refresh rate in hundredths of a hertz (the unit the SiI1136 wants).
+static inline uint32_t video_timing_refresh_chz(const video_timing_t* timing) {
+    uint32_t pixels = video_timing_h_total(timing) * video_timing_v_total(timing);
+    return pixels == 0 ? 0 : (uint32_t)((uint64_t)timing->pixel_clock_khz * 100000 / pixels);
+}
@@ -0,0 +1,293 @@
+#include "blend.h"
+
+#include "blit.h"
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include "stm32h7xx.h"
+#endif
+
+#include <stddef.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define blend_qadd8 __UQADD8
+#else
+static inline uint32_t blend_qadd8(uint32_t a, uint32_t b) {
+    uint32_t out = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF);
+        out |= (sum > 0xFF ? 0xFF : sum) << shift;
+    }
+    return out;
+}
+#endif
+
+// Indices into the span table.
+#define BLEND_DST_ARGB8888 0
+#define BLEND_DST_RGB565 1
+#define BLEND_DST_COUNT 2
+#define BLEND_SRC_ARGB8888 0
+#define BLEND_SRC_RGB565 1
+#define BLEND_SRC_A8 2
+#define BLEND_SRC_COUNT 3
+
+/***** ARITHMETIC *****/
+
+// a * b / 255, rounded, for a and b up to 255.
+static inline uint32_t blend_mul(uint32_t a, uint32_t b) {
+    uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// blend_mul()'s division on both 16-bit lanes of x, each at most 255 * 255.
+static inline uint32_t blend_div255_lanes(uint32_t x) {
+    uint32_t t = x + 0x00800080UL;
+    return ((t + ((t >> 8) & 0x00FF00FFUL)) >> 8) & 0x00FF00FFUL;
+}
+
+static inline uint32_t blend_min(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+// Colour channels scaled by alpha, which replaces the alpha channel.
+static inline uint32_t blend_premultiply(uint32_t argb, uint32_t alpha) {
+    uint32_t rb = blend_div255_lanes((argb & 0x00FF00FFUL) * alpha);
+    uint32_t g = blend_mul((argb >> 8) & 0xFF, alpha);
+    return (alpha << 24) | rb | (g << 8);
+}
+
+// Divides the channel sums by the total weight they were built from, rounding. Destinations
+// without alpha keep the premultiplied colour, whose total is at most 255.
+static inline uint32_t blend_resolve(uint32_t sum_rb, uint32_t sum_g, uint32_t total,
+                                     bool dst_alpha) {
+    if (!dst_alpha || total == 255) {
+        return 0xFF000000UL | blend_div255_lanes(sum_rb) | (blend_div255_lanes(sum_g) << 8);
+    } else if (total == 0) {
+        return 0;
+    }
+    uint32_t half = total / 2;
+    uint32_t r = ((sum_rb >> 16) + half) / total;
+    uint32_t g = (sum_g + half) / total;
+    uint32_t b = ((sum_rb & 0xFFFF) + half) / total;
+    return (total << 24) | (r << 16) | (g << 8) | b;
+}
+
+/***** SPANS *****/
+
+static inline __attribute__((always_inline)) uint32_t blend_load(pixel_format_t format,
+                                                                 const uint8_t* p, uint32_t rgb) {
+    if (format == PIXEL_FORMAT_A8) {
+        return ((uint32_t)*p << 24) | rgb;
+    }
+    return blit_unpack(format, p);
+}
+
+// Source alpha after the alpha source is applied.
+static inline __attribute__((always_inline)) uint32_t blend_src_alpha(blend_alpha_t alpha_source,
+                                                                      uint32_t src,
+                                                                      uint32_t alpha) {
+    switch (alpha_source) {
+        case BLEND_ALPHA_CONST:
+            return alpha;
+        case BLEND_ALPHA_PIXEL_CONST:
+            return blend_mul(src >> 24, alpha);
+        default:
+            return src >> 24;
+    }
+}
+
+// One pixel of mode. With mode and dst_alpha constant, the switches fold away.
+static inline __attribute__((always_inline)) uint32_t blend_pixel(blend_mode_t mode, uint32_t src,
+                                                                  uint32_t a_src, uint32_t dst,
+                                                                  uint32_t a_dst, bool dst_alpha) {
+    if (mode == BLEND_MODE_PLUS) {
+        uint32_t sum = blend_qadd8(blend_premultiply(src, a_src), blend_premultiply(dst, a_dst));
+        uint32_t total = sum >> 24;
+        if (!dst_alpha || total == 255) {
+            return sum | 0xFF000000UL;
+        }
+        // Premultiplied channels cannot exceed their alpha, except by saturating; clamp those.
+        return blend_resolve((blend_min((sum >> 16) & 0xFF, total) * 255 << 16) |
+                                 blend_min(sum & 0xFF, total) * 255,
+                             blend_min((sum >> 8) & 0xFF, total) * 255, total, true);
+    }
+
+    uint32_t f_src;
+    uint32_t f_dst;
+    switch (mode) {
+        case BLEND_MODE_SRC:
+            f_src = 255, f_dst = 0;
+            break;
+        case BLEND_MODE_DST:
+            f_src = 0, f_dst = 255;
+            break;
+        case BLEND_MODE_SRC_OVER:
+            f_src = 255, f_dst = 255 - a_src;
+            break;
+        case BLEND_MODE_DST_OVER:
+            f_src = 255 - a_dst, f_dst = 255;
+            break;
+        case BLEND_MODE_SRC_IN:
+            f_src = a_dst, f_dst = 0;
+            break;
+        case BLEND_MODE_DST_IN:
+            f_src = 0, f_dst = a_src;
+            break;
+        case BLEND_MODE_SRC_OUT:
+            f_src = 255 - a_dst, f_dst = 0;
+            break;
+        case BLEND_MODE_DST_OUT:
+            f_src = 0, f_dst = 255 - a_src;
+            break;
+        case BLEND_MODE_SRC_ATOP:
+            f_src = a_dst, f_dst = 255 - a_src;
+            break;
+        case BLEND_MODE_DST_ATOP:
+            f_src = 255 - a_dst, f_dst = a_src;
+            break;
+        case BLEND_MODE_XOR:
+        case BLEND_MODE_MULTIPLY:
+        case BLEND_MODE_SCREEN:
+            f_src = 255 - a_dst, f_dst = 255 - a_src;
+            break;
+        default:  // CLEAR
+            f_src = 0, f_dst = 0;
+            break;
+    }
+    // Rounding each weight may push the total past 255, which the lane arithmetic cannot take.
+    uint32_t w_src = blend_mul(a_src, f_src);
+    uint32_t w_dst = blend_min(blend_mul(a_dst, f_dst), 255 - w_src);
+    uint32_t sum_rb = (src & 0x00FF00FFUL) * w_src + (dst & 0x00FF00FFUL) * w_dst;
+    uint32_t sum_g = ((src >> 8) & 0xFF) * w_src + ((dst >> 8) & 0xFF) * w_dst;
+    uint32_t total = w_src + w_dst;
+
+    if (mode == BLEND_MODE_MULTIPLY || mode == BLEND_MODE_SCREEN) {
+        // The separable blend term, weighted by a_src * a_dst.
+        uint32_t w_both = blend_min(blend_mul(a_src, a_dst), 255 - total);
+        uint32_t r = blend_mul((src >> 16) & 0xFF, (dst >> 16) & 0xFF);
+        uint32_t g = blend_mul((src >> 8) & 0xFF, (dst >> 8) & 0xFF);
+        uint32_t b = blend_mul(src & 0xFF, dst & 0xFF);
+        if (mode == BLEND_MODE_SCREEN) {
+            r = ((src >> 16) & 0xFF) + ((dst >> 16) & 0xFF) - r;
+            g = ((src >> 8) & 0xFF) + ((dst >> 8) & 0xFF) - g;
+            b = (src & 0xFF) + (dst & 0xFF) - b;
+        }
+        sum_rb += ((r << 16) | b) * w_both;
+        sum_g += g * w_both;
+        total += w_both;
+    }
+    return blend_resolve(sum_rb, sum_g, total, dst_alpha);
+}
+
+// The body every specialization expands. All but the pointers and count are constants.
+static inline __attribute__((always_inline)) void blend_span(blend_mode_t mode,
+                                                             pixel_format_t dst_format,
+                                                             pixel_format_t src_format,
+                                                             blend_alpha_t alpha_source,
+                                                             uint8_t* dst, const uint8_t* src,
+                                                             uint32_t count,
+                                                             const blend_params_t* params) {
+    if (mode == BLEND_MODE_DST) {
+        return;
+    }
+    const bool dst_alpha = dst_format == PIXEL_FORMAT_ARGB8888;
+    const uint8_t dst_bpp = pixel_format_bytes(dst_format);
+    const uint8_t src_bpp = pixel_format_bytes(src_format);
+    const uint32_t alpha = params->alpha;
+    const uint32_t rgb = params->rgb & 0x00FFFFFFUL;
+
+    for (uint32_t i = 0; i < count; i++, dst += dst_bpp, src += src_bpp) {
+        uint32_t s = blend_load(src_format, src, rgb);
+        uint32_t d = blit_unpack(dst_format, dst);
+        uint32_t out = blend_pixel(mode, s, blend_src_alpha(alpha_source, s, alpha), d,
+                                   dst_alpha ? d >> 24 : 255, dst_alpha);
+        blit_pack(dst_format, dst, out);
+    }
+}
+
+// The specializations: every mode x destination x source x alpha source. They stay in flash
+// (and the instruction cache) rather than the ITCM, which could not hold all of them.
+
+#define BLEND_FOR_ALPHA(X, mode, dst, src) \
+    X(mode, dst, src, PIXEL) X(mode, dst, src, CONST) X(mode, dst, src, PIXEL_CONST)
+#define BLEND_FOR_SRC(X, mode, dst)          \
+    BLEND_FOR_ALPHA(X, mode, dst, ARGB8888)  \
+    BLEND_FOR_ALPHA(X, mode, dst, RGB565)    \
+    BLEND_FOR_ALPHA(X, mode, dst, A8)
+#define BLEND_FOR_DST(X, mode) BLEND_FOR_SRC(X, mode, ARGB8888) BLEND_FOR_SRC(X, mode, RGB565)
+#define BLEND_FOR_ALL(X)              \
+    BLEND_FOR_DST(X, CLEAR)           \
+    BLEND_FOR_DST(X, SRC)             \
+    BLEND_FOR_DST(X, DST)             \
+    BLEND_FOR_DST(X, SRC_OVER)        \
+    BLEND_FOR_DST(X, DST_OVER)        \
+    BLEND_FOR_DST(X, SRC_IN)          \
+    BLEND_FOR_DST(X, DST_IN)          \
+    BLEND_FOR_DST(X, SRC_OUT)         \
+    BLEND_FOR_DST(X, DST_OUT)         \
+    BLEND_FOR_DST(X, SRC_ATOP)        \
+    BLEND_FOR_DST(X, DST_ATOP)        \
+    BLEND_FOR_DST(X, XOR)             \
+    BLEND_FOR_DST(X, PLUS)            \
+    BLEND_FOR_DST(X, MULTIPLY)        \
+    BLEND_FOR_DST(X, SCREEN)
+
+#define BLEND_SPAN_NAME(mode, dst, src, alpha) blend_span_##mode##_##dst##_##src##_##alpha
+
+#define BLEND_DEFINE_SPAN(mode, dst, src, alpha)                                             \
+    static void BLEND_SPAN_NAME(mode, dst, src, alpha)(uint8_t * d, const uint8_t* s,         \
+                                                       uint32_t count,                        \
+                                                       const blend_params_t* params) {        \
+        blend_span(BLEND_MODE_##mode, PIXEL_FORMAT_##dst, PIXEL_FORMAT_##src,                 \
+                   BLEND_ALPHA_##alpha, d, s, count, params);                                 \
+    }
+
+#define BLEND_TABLE_ENTRY(mode, dst, src, alpha)                                     \
+    [BLEND_MODE_##mode][BLEND_DST_##dst][BLEND_SRC_##src][BLEND_ALPHA_##alpha] =     \
+        BLEND_SPAN_NAME(mode, dst, src, alpha),
+
+BLEND_FOR_ALL(BLEND_DEFINE_SPAN)
+
+static const blend_span_fn_t
+    blend_spans[BLEND_MODE_COUNT][BLEND_DST_COUNT][BLEND_SRC_COUNT][BLEND_ALPHA_COUNT] = {
+        BLEND_FOR_ALL(BLEND_TABLE_ENTRY)};
+
+/***** PUBLIC API *****/
+
+static int blend_dst_index(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return BLEND_DST_ARGB8888;
+        case PIXEL_FORMAT_RGB565:
+            return BLEND_DST_RGB565;
+        default:
+            return -1;
+    }
+}
+
+static int blend_src_index(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return BLEND_SRC_ARGB8888;
+        case PIXEL_FORMAT_RGB565:
+            return BLEND_SRC_RGB565;
+        case PIXEL_FORMAT_A8:
+            return BLEND_SRC_A8;
+        default:
+            return -1;
+    }
+}
+
+bool blend_supported(pixel_format_t dst_format, pixel_format_t src_format) {
+    return blend_dst_index(dst_format) >= 0 && blend_src_index(src_format) >= 0;
+}
+
+blend_span_fn_t blend_select(pixel_format_t dst_format, pixel_format_t src_format,
+                             const blend_params_t* params) {
+    int dst = blend_dst_index(dst_format);
+    int src = blend_src_index(src_format);
+    if (params == NULL || dst < 0 || src < 0 || params->mode >= BLEND_MODE_COUNT ||
+        params->alpha_source >= BLEND_ALPHA_COUNT) {
+        return NULL;
+    }
+    return blend_spans[params->mode][dst][src][params->alpha_source];
+}
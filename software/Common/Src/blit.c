@@ -0,0 +1,872 @@
+#include "blit.h"
+
+#include "cache_maint.h"
+#include "cycles.h"
+#include "fast_mem.h"
+#include "mem_attr.h"
+#include "mem_map.h"
+#include "pixel_convert.h"
+
+#if defined(CORE_CM7)
+#include "fence.h"
+#include "stm32h7xx_hal.h"
+#include "timebase.h"
+#include "trace.h"
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+// Used until blit_calibrate() has run. Below these sizes, in pixels, software is faster; they
+// are conservative guesses for the 64 MHz clock, where the DMA2D setup and cache maintenance are
+// relatively cheap.
+#define BLIT_DEFAULT_CROSSOVER_FILL 128
+#define BLIT_DEFAULT_CROSSOVER_COPY 256
+#define BLIT_DEFAULT_CROSSOVER_CONVERT 64
+#define BLIT_DEFAULT_CROSSOVER_BLEND 32
+
+#define BLIT_DMA2D_TIMEOUT_US 100000
+#define BLIT_DMA2D_IRQ_PRIORITY 5
+
+// DMA2D_CR.MODE values.
+#define BLIT_DMA2D_MODE_M2M (0UL << DMA2D_CR_MODE_Pos)
+#define BLIT_DMA2D_MODE_M2M_PFC (1UL << DMA2D_CR_MODE_Pos)
+#define BLIT_DMA2D_MODE_M2M_BLEND (2UL << DMA2D_CR_MODE_Pos)
+#define BLIT_DMA2D_MODE_R2M (3UL << DMA2D_CR_MODE_Pos)
+// DMA2D_xPFCCR.AM: multiply the pixel's alpha by the register's.
+#define BLIT_DMA2D_ALPHA_MULTIPLY (2UL << DMA2D_FGPFCCR_AM_Pos)
+
+#define BLIT_DMA2D_IRQ_ENABLES \
+    (DMA2D_CR_TCIE | DMA2D_CR_CTCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE | DMA2D_CR_CAEIE)
+#define BLIT_DMA2D_ERROR_FLAGS (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF | DMA2D_ISR_CAEIF)
+#define BLIT_DMA2D_ALL_FLAGS \
+    (DMA2D_IFCR_CTEIF | DMA2D_IFCR_CTCIF | DMA2D_IFCR_CAECIF | DMA2D_IFCR_CCTCIF | DMA2D_IFCR_CCEIF)
+
+// A blit after clipping: dst_rect on dst, fed from src starting at (src_x, src_y). Surfaces are
+// held by value so queued jobs do not depend on the caller's copies. A job with a CLUT loads it
+// instead of blitting.
+typedef struct {
+    blit_op_t op;
+    surface_t dst;
+    rect_t dst_rect;
+    surface_t src;
+    int16_t src_x;
+    int16_t src_y;
+    uint32_t argb;
+    uint8_t alpha;
+    const uint32_t* clut;
+    uint16_t clut_size;
+} blit_job_t;
+
+typedef struct {
+    blit_engine_t engine;
+    uint32_t crossover[BLIT_OP_COUNT];
+    blit_stats_t stats;
+    const uint32_t* clut;  // Last CLUT loaded, in queue order; used for L8 sources.
+    uint16_t clut_size;
+} blit_state_t;
+
+static blit_state_t blit_state = {
+    .crossover = {BLIT_DEFAULT_CROSSOVER_FILL, BLIT_DEFAULT_CROSSOVER_COPY,
+                  BLIT_DEFAULT_CROSSOVER_CONVERT, BLIT_DEFAULT_CROSSOVER_BLEND},
+};
+
+/***** SOFTWARE *****/
+
+// The reference path. Fill and same-format copy move whole rows; conversion and blending go
+// pixel by pixel through blit_unpack()/blit_pack(), which define the expected output.
+
+static inline uint32_t blit_sw_src(pixel_format_t format, const uint8_t* src) {
+    if (format != PIXEL_FORMAT_L8) {
+        return blit_unpack(format, src);
+    }
+    return *src < blit_state.clut_size ? blit_state.clut[*src] : 0;
+}
+
+FAST_CODE static void blit_sw_fill(const blit_job_t* job) {
+    const surface_t* dst = &job->dst;
+    uint32_t width = (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0);
+    uint8_t bpp = pixel_format_bytes(dst->format);
+    uint8_t packed[4] = {0};
+    blit_pack(dst->format, packed, job->argb);
+    uint32_t word;
+    memcpy(&word, packed, sizeof(word));
+
+    for (int16_t y = job->dst_rect.y0; y < job->dst_rect.y1; y++) {
+        uint8_t* row = surface_pixel_addr(dst, job->dst_rect.x0, y);
+        if (bpp == 4) {
+            uint32_t* p = (uint32_t*)row;
+            for (uint32_t i = 0; i < width; i++) {
+                p[i] = word;
+            }
+        } else if (bpp == 2) {
+            uint16_t* p = (uint16_t*)row;
+            for (uint32_t i = 0; i < width; i++) {
+                p[i] = (uint16_t)word;
+            }
+        } else if (bpp == 1) {
+            memset(row, packed[0], width);
+        } else {
+            for (uint32_t i = 0; i < width; i++) {
+                memcpy(row + i * 3, packed, 3);
+            }
+        }
+    }
+}
+
+FAST_CODE static void blit_sw_copy(const blit_job_t* job) {
+    uint32_t width_b =
+        (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0) * pixel_format_bytes(job->dst.format);
+    int16_t src_y = job->src_y;
+    for (int16_t y = job->dst_rect.y0; y < job->dst_rect.y1; y++, src_y++) {
+        memmove(surface_pixel_addr(&job->dst, job->dst_rect.x0, y),
+                surface_pixel_addr(&job->src, job->src_x, src_y), width_b);
+    }
+}
+
+// Row kernels from pixel_convert, which match blit_unpack()/blit_pack() exactly.
+static void blit_sw_convert(const blit_job_t* job) {
+    pixel_convert_params_t params = {blit_state.clut, blit_state.clut_size, 0};
+    uint32_t width = (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0);
+    int16_t src_y = job->src_y;
+    for (int16_t y = job->dst_rect.y0; y < job->dst_rect.y1; y++, src_y++) {
+        pixel_convert_row(surface_pixel_addr(&job->dst, job->dst_rect.x0, y), job->dst.format,
+                          surface_pixel_addr(&job->src, job->src_x, src_y), job->src.format,
+                          width, &params);
+    }
+}
+
+FAST_CODE static void blit_sw_blend(const blit_job_t* job) {
+    pixel_format_t dst_format = job->dst.format;
+    pixel_format_t src_format = job->src.format;
+    uint8_t dst_bpp = pixel_format_bytes(dst_format);
+    uint8_t src_bpp = pixel_format_bytes(src_format);
+    uint32_t width = (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0);
+    int16_t src_y = job->src_y;
+    for (int16_t y = job->dst_rect.y0; y < job->dst_rect.y1; y++, src_y++) {
+        uint8_t* d = surface_pixel_addr(&job->dst, job->dst_rect.x0, y);
+        const uint8_t* s = surface_pixel_addr(&job->src, job->src_x, src_y);
+        for (uint32_t i = 0; i < width; i++, d += dst_bpp, s += src_bpp) {
+            uint32_t out = blit_blend_pixel(blit_sw_src(src_format, s),
+                                            blit_unpack(dst_format, d), job->alpha);
+            blit_pack(dst_format, d, out);
+        }
+    }
+}
+
+static void blit_sw_run(const blit_job_t* job) {
+    if (job->clut != NULL) {
+        blit_state.clut = job->clut;
+        blit_state.clut_size = job->clut_size;
+        return;
+    }
+    switch (job->op) {
+        case BLIT_OP_FILL:
+            blit_sw_fill(job);
+            break;
+        case BLIT_OP_COPY:
+            blit_sw_copy(job);
+            break;
+        case BLIT_OP_CONVERT:
+            blit_sw_convert(job);
+            break;
+        case BLIT_OP_BLEND:
+            blit_sw_blend(job);
+            break;
+        default:
+            break;
+    }
+}
+
+/***** DMA2D *****/
+
+#if defined(CORE_CM7)
+
+// The DMA2D has no descriptor lists, so queued jobs are chained by hand: the transfer-complete
+// interrupt retires the running job and starts the next one. Only the thread submits and only
+// the interrupt retires, so the ring needs no lock beyond masking the interrupt while a
+// submission decides whether it has to start the engine itself.
+typedef struct {
+    blit_job_t jobs[BLIT_QUEUE_DEPTH];
+    volatile uint32_t submitted;  // Sequence number of the newest job.
+    volatile uint32_t started;    // Sequence number of the job on the engine (or last one run).
+    fence_t retired;              // Sequence number of the newest finished job.
+    volatile bool running;
+    uint32_t job_start_us;
+    uint32_t frame_start_us;
+    blit_frame_stats_t frame;     // Accumulating for the current frame.
+    uint32_t depth_sum;
+    // Sequence number of the job in each slot that the DMA2D reported an error for, 0 if none.
+    volatile uint32_t failed[BLIT_QUEUE_DEPTH];
+    volatile uint32_t failures;   // Since blit_wait_idle() last reported them.
+} blit_queue_t;
+
+static blit_queue_t blit_queue;
+
+static bool blit_dma2d_reachable(uintptr_t addr) {
+    return !(addr >= DTCM_BASE && addr < DTCM_BASE + DTCM_SIZE);
+}
+
+// The DMA2D counts line offsets in pixels, cannot read the DTCM and has no 8-bit output mode.
+static bool blit_dma2d_usable(const blit_job_t* job) {
+    if (job->clut != NULL) {
+        return blit_dma2d_reachable((uintptr_t)job->clut);
+    } else if (job->dst.format == PIXEL_FORMAT_L8) {
+        return false;
+    }
+    uint32_t width = (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0);
+    uint8_t dst_bpp = pixel_format_bytes(job->dst.format);
+    uint32_t dst_offset = job->dst.stride_b / dst_bpp - width;
+    if (!blit_dma2d_reachable((uintptr_t)job->dst.pixels) || job->dst.stride_b % dst_bpp != 0 ||
+        width > (DMA2D_NLR_PL_Msk >> DMA2D_NLR_PL_Pos) || dst_offset > DMA2D_OOR_LO_Msk) {
+        return false;
+    }
+    if (job->op == BLIT_OP_FILL) {
+        return true;
+    }
+    uint8_t src_bpp = pixel_format_bytes(job->src.format);
+    uint32_t src_offset = job->src.stride_b / src_bpp - width;
+    return blit_dma2d_reachable((uintptr_t)job->src.pixels) && job->src.stride_b % src_bpp == 0 &&
+           src_offset <= DMA2D_FGOR_LO_Msk;
+}
+
+// A queued job's destination lines are invalidated when it finishes, long after it was submitted.
+// In a write-back surface that is only safe if no line also holds pixels outside the job, which
+// the CPU may write meanwhile and which a dirty line's eviction could also write back over the
+// DMA2D's output. So every row must start and end on a line boundary.
+static bool blit_dma2d_queueable(const blit_job_t* job) {
+    if (!blit_dma2d_usable(job)) {
+        return false;
+    } else if (job->clut != NULL ||
+               mem_attr_get_policy((uintptr_t)job->dst.pixels) != MEM_ATTR_WRITE_BACK) {
+        return true;
+    }
+    uintptr_t start = (uintptr_t)surface_pixel_addr(&job->dst, job->dst_rect.x0, job->dst_rect.y0);
+    uintptr_t end = (uintptr_t)surface_pixel_addr(&job->dst, job->dst_rect.x1, job->dst_rect.y0);
+    return ((start | end | job->dst.stride_b) & (CACHE_LINE_SIZE_B - 1)) == 0;
+}
+
+// Everything the CPU wrote must be in memory before the DMA2D reads it, and no dirty destination
+// line may be evicted over its output later.
+static void blit_dma2d_prepare(const blit_job_t* job) {
+    if (job->clut != NULL) {
+        uintptr_t start = (uintptr_t)job->clut & ~((uintptr_t)CACHE_LINE_SIZE_B - 1);
+        uintptr_t end = ((uintptr_t)(job->clut + job->clut_size) + CACHE_LINE_SIZE_B - 1) &
+                        ~((uintptr_t)CACHE_LINE_SIZE_B - 1);
+        cache_range_t range = {start, (uint32_t)(end - start)};
+        cache_maint_ranges(&range, 1, CACHE_MAINT_CLEAN);
+        return;
+    }
+    cache_maint_rects(&job->dst, &job->dst_rect, 1, CACHE_MAINT_CLEAN_INVALIDATE);
+    if (job->op != BLIT_OP_FILL) {
+        rect_t src_rect = {job->src_x, job->src_y,
+                           (int16_t)(job->src_x + job->dst_rect.x1 - job->dst_rect.x0),
+                           (int16_t)(job->src_y + job->dst_rect.y1 - job->dst_rect.y0)};
+        cache_maint_rects(&job->src, &src_rect, 1, CACHE_MAINT_CLEAN);
+    }
+}
+
+// Lines the CPU speculatively refetched while the DMA2D was writing are stale.
+static void blit_dma2d_finish(const blit_job_t* job) {
+    if (job->clut == NULL) {
+        cache_maint_rects(&job->dst, &job->dst_rect, 1, CACHE_MAINT_INVALIDATE);
+    }
+}
+
+// Programs the job and starts the engine; irq_enables decides whether completion interrupts.
+static void blit_dma2d_start(const blit_job_t* job, uint32_t irq_enables) {
+    DMA2D->IFCR = BLIT_DMA2D_ALL_FLAGS;
+    if (job->clut != NULL) {
+        DMA2D->CR = irq_enables;
+        DMA2D->FGCMAR = (uint32_t)job->clut;
+        DMA2D->FGPFCCR = PIXEL_FORMAT_L8 | ((job->clut_size - 1UL) << DMA2D_FGPFCCR_CS_Pos) |
+                         DMA2D_FGPFCCR_START;
+        return;
+    }
+
+    const surface_t* dst = &job->dst;
+    uint32_t width = (uint32_t)(job->dst_rect.x1 - job->dst_rect.x0);
+    uint32_t height = (uint32_t)(job->dst_rect.y1 - job->dst_rect.y0);
+    uint32_t dst_offset = dst->stride_b / pixel_format_bytes(dst->format) - width;
+    uint32_t dst_addr = (uint32_t)surface_pixel_addr(dst, job->dst_rect.x0, job->dst_rect.y0);
+    uint32_t mode = BLIT_DMA2D_MODE_M2M;
+
+    if (job->op != BLIT_OP_FILL) {
+        DMA2D->FGMAR = (uint32_t)surface_pixel_addr(&job->src, job->src_x, job->src_y);
+        DMA2D->FGOR = job->src.stride_b / pixel_format_bytes(job->src.format) - width;
+        DMA2D->FGPFCCR = job->src.format;
+    }
+    switch (job->op) {
+        case BLIT_OP_FILL: {
+            uint32_t color = 0;
+            blit_pack(dst->format, (uint8_t*)&color, job->argb);
+            mode = BLIT_DMA2D_MODE_R2M;
+            DMA2D->OCOLR = color;
+            break;
+        }
+        case BLIT_OP_CONVERT:
+            mode = BLIT_DMA2D_MODE_M2M_PFC;
+            break;
+        case BLIT_OP_BLEND:
+            mode = BLIT_DMA2D_MODE_M2M_BLEND;
+            DMA2D->FGPFCCR |=
+                BLIT_DMA2D_ALPHA_MULTIPLY | ((uint32_t)job->alpha << DMA2D_FGPFCCR_ALPHA_Pos);
+            DMA2D->BGMAR = dst_addr;
+            DMA2D->BGOR = dst_offset;
+            DMA2D->BGPFCCR = dst->format;
+            break;
+        default:
+            break;
+    }
+    DMA2D->OPFCCR = dst->format;
+    DMA2D->OMAR = dst_addr;
+    DMA2D->OOR = dst_offset;
+    DMA2D->NLR = (width << DMA2D_NLR_PL_Pos) | height;
+    DMA2D->CR = mode | irq_enables | DMA2D_CR_START;
+}
+
+// Runs one job to completion with interrupts off. The queue must be idle.
+static blit_status_t blit_dma2d_run(const blit_job_t* job) {
+    blit_dma2d_prepare(job);
+    blit_dma2d_start(job, 0);
+
+    uint32_t start_us = timebase_now_us();
+    blit_status_t status = BLIT_STATUS_OK;
+    while ((DMA2D->CR & DMA2D_CR_START) || (DMA2D->FGPFCCR & DMA2D_FGPFCCR_START)) {
+        if ((DMA2D->ISR & BLIT_DMA2D_ERROR_FLAGS) ||
+            timebase_elapsed_us(start_us) > BLIT_DMA2D_TIMEOUT_US) {
+            DMA2D->CR |= DMA2D_CR_ABORT;
+            status = BLIT_STATUS_DMA_ERR;
+            break;
+        }
+    }
+    if (DMA2D->ISR & BLIT_DMA2D_ERROR_FLAGS) {
+        status = BLIT_STATUS_DMA_ERR;
+    }
+    DMA2D->IFCR = BLIT_DMA2D_ALL_FLAGS;
+    blit_dma2d_finish(job);
+    return status;
+}
+
+// Call with the DMA2D interrupt masked, or from it.
+static void blit_queue_start_next(void) {
+    if (blit_queue.started == blit_queue.submitted) {
+        blit_queue.running = false;
+        return;
+    }
+    uint32_t seq = blit_queue.started + 1;
+    blit_queue.started = seq;
+    blit_queue.running = true;
+    blit_queue.job_start_us = timebase_now_us();
+    blit_dma2d_start(&blit_queue.jobs[seq % BLIT_QUEUE_DEPTH], BLIT_DMA2D_IRQ_ENABLES);
+}
+
+static bool blit_queue_idle(void) {
+    return fence_reached(&blit_queue.retired, blit_queue.submitted);
+}
+
+// Blocks until every queued job has finished, so work done directly afterwards lands in
+// submission order.
+static blit_status_t blit_queue_drain(uint32_t timeout_us) {
+    if (fence_wait(&blit_queue.retired, blit_queue.submitted, timeout_us) != FENCE_STATUS_OK) {
+        return BLIT_STATUS_TIMEOUT;
+    }
+    return BLIT_STATUS_OK;
+}
+
+static blit_status_t blit_queue_submit(const blit_job_t* job, uint32_t* seq) {
+    uint32_t next = blit_queue.submitted + 1;
+
+    if (!blit_dma2d_queueable(job)) {
+        // Software cannot overtake the engine, so it waits its turn. With the queue empty the
+        // interrupt cannot fire, so completing the fence from here is safe.
+        if (blit_queue_drain(BLIT_DMA2D_TIMEOUT_US * BLIT_QUEUE_DEPTH) != BLIT_STATUS_OK) {
+            return BLIT_STATUS_TIMEOUT;
+        }
+        blit_sw_run(job);
+        blit_queue.submitted = next;
+        blit_queue.started = next;
+        fence_signal(&blit_queue.retired, next);
+    } else {
+        // Full: wait for the oldest job to retire.
+        if (!fence_reached(&blit_queue.retired, next - BLIT_QUEUE_DEPTH)) {
+            blit_queue.frame.stalls++;
+            if (fence_wait(&blit_queue.retired, next - BLIT_QUEUE_DEPTH,
+                           BLIT_DMA2D_TIMEOUT_US) != FENCE_STATUS_OK) {
+                return BLIT_STATUS_TIMEOUT;
+            }
+        }
+        blit_dma2d_prepare(job);
+        blit_queue.jobs[next % BLIT_QUEUE_DEPTH] = *job;
+        TRACE_ASYNC_BEGIN(TRACE_EVENT_DMA, next);
+
+        HAL_NVIC_DisableIRQ(DMA2D_IRQn);
+        blit_queue.submitted = next;
+        if (!blit_queue.running) {
+            blit_queue_start_next();
+        }
+        uint32_t depth = next - fence_value(&blit_queue.retired);
+        HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+
+        blit_queue.depth_sum += depth;
+        if (depth > blit_queue.frame.max_depth) {
+            blit_queue.frame.max_depth = (uint16_t)depth;
+        }
+    }
+
+    if (job->clut == NULL) {
+        blit_state.stats.blits[job->op]++;
+    }
+    blit_queue.frame.jobs++;
+    if (seq != NULL) {
+        *seq = next;
+    }
+    return BLIT_STATUS_OK;
+}
+
+#endif
+
+/***** DISPATCH *****/
+
+static blit_status_t blit_run(const blit_job_t* job) {
+    uint32_t pixels = rect_area(&job->dst_rect);
+    if (pixels == 0) {
+        return BLIT_STATUS_OK;
+    }
+
+#if defined(CORE_CM7)
+    // Queued work that this blit could depend on (or overwrite) must land first.
+    if (!blit_queue_idle() &&
+        blit_queue_drain(BLIT_DMA2D_TIMEOUT_US * BLIT_QUEUE_DEPTH) != BLIT_STATUS_OK) {
+        return BLIT_STATUS_TIMEOUT;
+    }
+    blit_state.stats.blits[job->op]++;
+    bool use_dma2d =
+        blit_state.engine == BLIT_ENGINE_DMA2D ||
+        (blit_state.engine == BLIT_ENGINE_AUTO && pixels >= blit_state.crossover[job->op]);
+    if (use_dma2d && blit_dma2d_usable(job)) {
+        blit_state.stats.dma2d_blits[job->op]++;
+        blit_status_t status = blit_dma2d_run(job);
+        if (status != BLIT_STATUS_OK) {
+            blit_state.stats.dma2d_errors++;
+        }
+        return status;
+    }
+#else
+    blit_state.stats.blits[job->op]++;
+#endif
+    blit_sw_run(job);
+    return BLIT_STATUS_OK;
+}
+
+// Queued jobs always go to the DMA2D when it can take them: the point is to keep the CPU free,
+// not to finish each job soonest. Elsewhere they simply run now.
+static blit_status_t blit_submit(const blit_job_t* job, uint32_t* seq) {
+    if (job->clut == NULL && rect_is_empty(&job->dst_rect)) {
+        // Nothing to draw; report the newest sequence number so waiting on it still orders.
+#if defined(CORE_CM7)
+        if (seq != NULL) {
+            *seq = blit_queue.submitted;
+        }
+#else
+        if (seq != NULL) {
+            *seq = 0;
+        }
+#endif
+        return BLIT_STATUS_OK;
+    }
+#if defined(CORE_CM7)
+    if (job->clut == NULL && blit_dma2d_queueable(job)) {
+        blit_state.stats.dma2d_blits[job->op]++;
+    }
+    return blit_queue_submit(job, seq);
+#else
+    if (job->clut == NULL) {
+        blit_state.stats.blits[job->op]++;
+    }
+    blit_sw_run(job);
+    if (seq != NULL) {
+        *seq = 0;
+    }
+    return BLIT_STATUS_OK;
+#endif
+}
+
+// Clips the destination at (x, y) and src_rect of src together, so each stays inside its
+// surface and they keep the same size.
+static void blit_clip_src(blit_job_t* job, int16_t x, int16_t y, const rect_t* src_rect) {
+    rect_t src_bounds = surface_bounds(&job->src);
+    rect_t src = rect_intersect(src_rect, &src_bounds);
+    rect_t dst = {(int16_t)(x + src.x0 - src_rect->x0), (int16_t)(y + src.y0 - src_rect->y0), 0,
+                  0};
+    dst.x1 = (int16_t)(dst.x0 + src.x1 - src.x0);
+    dst.y1 = (int16_t)(dst.y0 + src.y1 - src.y0);
+
+    rect_t dst_bounds = surface_bounds(&job->dst);
+    job->dst_rect = rect_intersect(&dst, &dst_bounds);
+    job->src_x = (int16_t)(src.x0 + job->dst_rect.x0 - dst.x0);
+    job->src_y = (int16_t)(src.y0 + job->dst_rect.y0 - dst.y0);
+}
+
+static blit_status_t blit_make_fill(blit_job_t* job, const surface_t* dst, const rect_t* rect,
+                                    uint32_t argb) {
+    if (dst == NULL || rect == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    } else if (!blit_format_supported(dst->format) && dst->format != PIXEL_FORMAT_L8) {
+        return BLIT_STATUS_BAD_FORMAT;
+    }
+    rect_t bounds = surface_bounds(dst);
+    *job = (blit_job_t){.op = BLIT_OP_FILL, .dst = *dst, .argb = argb};
+    job->dst_rect = rect_intersect(rect, &bounds);
+    return BLIT_STATUS_OK;
+}
+
+static blit_status_t blit_make_copy(blit_job_t* job, const surface_t* dst, int16_t x, int16_t y,
+                                    const surface_t* src, const rect_t* src_rect, bool blend,
+                                    uint8_t alpha) {
+    if (dst == NULL || src == NULL || src_rect == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    } else if (!blit_src_format_supported(src->format) ||
+               (dst->format == PIXEL_FORMAT_L8 ? src->format != PIXEL_FORMAT_L8 || blend
+                                               : !blit_format_supported(dst->format))) {
+        // Indexed destinations only take other indexed pixels as they are.
+        return BLIT_STATUS_BAD_FORMAT;
+    }
+    blit_op_t op = blend ? BLIT_OP_BLEND
+                   : dst->format == src->format ? BLIT_OP_COPY
+                                                : BLIT_OP_CONVERT;
+    *job = (blit_job_t){.op = op, .dst = *dst, .src = *src, .alpha = alpha};
+    blit_clip_src(job, x, y, src_rect);
+    return BLIT_STATUS_OK;
+}
+
+/***** PUBLIC API *****/
+
+void blit_init(void) {
+#if defined(CORE_CM7)
+    __HAL_RCC_DMA2D_CLK_ENABLE();
+    __HAL_RCC_DMA2D_FORCE_RESET();
+    __HAL_RCC_DMA2D_RELEASE_RESET();
+
+    blit_queue.submitted = 0;
+    blit_queue.started = 0;
+    blit_queue.running = false;
+    fence_init(&blit_queue.retired, FENCE_NO_DOORBELL);
+    blit_queue.frame = (blit_frame_stats_t){0};
+    blit_queue.depth_sum = 0;
+    memset((void*)blit_queue.failed, 0, sizeof(blit_queue.failed));
+    blit_queue.failures = 0;
+    blit_queue.frame_start_us = timebase_now_us();
+    HAL_NVIC_SetPriority(DMA2D_IRQn, BLIT_DMA2D_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+#endif
+    blit_state.engine = BLIT_ENGINE_AUTO;
+    blit_state.crossover[BLIT_OP_FILL] = BLIT_DEFAULT_CROSSOVER_FILL;
+    blit_state.crossover[BLIT_OP_COPY] = BLIT_DEFAULT_CROSSOVER_COPY;
+    blit_state.crossover[BLIT_OP_CONVERT] = BLIT_DEFAULT_CROSSOVER_CONVERT;
+    blit_state.crossover[BLIT_OP_BLEND] = BLIT_DEFAULT_CROSSOVER_BLEND;
+    blit_state.stats = (blit_stats_t){0};
+    blit_state.clut = NULL;
+    blit_state.clut_size = 0;
+}
+
+blit_status_t blit_fill(const surface_t* dst, const rect_t* rect, uint32_t argb) {
+    blit_job_t job;
+    blit_status_t status = blit_make_fill(&job, dst, rect, argb);
+    return status == BLIT_STATUS_OK ? blit_run(&job) : status;
+}
+
+blit_status_t blit_copy(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                        const rect_t* src_rect) {
+    blit_job_t job;
+    blit_status_t status = blit_make_copy(&job, dst, x, y, src, src_rect, false, 0);
+    return status == BLIT_STATUS_OK ? blit_run(&job) : status;
+}
+
+blit_status_t blit_blend(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                         const rect_t* src_rect, uint8_t alpha) {
+    blit_job_t job;
+    blit_status_t status = blit_make_copy(&job, dst, x, y, src, src_rect, true, alpha);
+    return status == BLIT_STATUS_OK ? blit_run(&job) : status;
+}
+
+blit_status_t blit_composite(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                             const rect_t* src_rect, const blend_params_t* params) {
+    if (dst == NULL || src == NULL || src_rect == NULL || params == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    }
+    // The specialization is chosen once here; the rows below run it without further dispatch.
+    blend_span_fn_t span = blend_select(dst->format, src->format, params);
+    if (span == NULL) {
+        return BLIT_STATUS_BAD_FORMAT;
+    }
+    blit_job_t job = {.op = BLIT_OP_BLEND, .dst = *dst, .src = *src};
+    blit_clip_src(&job, x, y, src_rect);
+    if (rect_is_empty(&job.dst_rect)) {
+        return BLIT_STATUS_OK;
+    }
+#if defined(CORE_CM7)
+    if (!blit_queue_idle() &&
+        blit_queue_drain(BLIT_DMA2D_TIMEOUT_US * BLIT_QUEUE_DEPTH) != BLIT_STATUS_OK) {
+        return BLIT_STATUS_TIMEOUT;
+    }
+#endif
+    uint32_t width = (uint32_t)(job.dst_rect.x1 - job.dst_rect.x0);
+    int16_t src_y = job.src_y;
+    for (int16_t row = job.dst_rect.y0; row < job.dst_rect.y1; row++, src_y++) {
+        span(surface_pixel_addr(&job.dst, job.dst_rect.x0, row),
+             surface_pixel_addr(&job.src, job.src_x, src_y), width, params);
+    }
+    return BLIT_STATUS_OK;
+}
+
+blit_status_t blit_fill_async(const surface_t* dst, const rect_t* rect, uint32_t argb,
+                              uint32_t* seq) {
+    blit_job_t job;
+    blit_status_t status = blit_make_fill(&job, dst, rect, argb);
+    return status == BLIT_STATUS_OK ? blit_submit(&job, seq) : status;
+}
+
+blit_status_t blit_copy_async(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                              const rect_t* src_rect, uint32_t* seq) {
+    blit_job_t job;
+    blit_status_t status = blit_make_copy(&job, dst, x, y, src, src_rect, false, 0);
+    return status == BLIT_STATUS_OK ? blit_submit(&job, seq) : status;
+}
+
+blit_status_t blit_blend_async(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                               const rect_t* src_rect, uint8_t alpha, uint32_t* seq) {
+    blit_job_t job;
+    blit_status_t status = blit_make_copy(&job, dst, x, y, src, src_rect, true, alpha);
+    return status == BLIT_STATUS_OK ? blit_submit(&job, seq) : status;
+}
+
+blit_status_t blit_load_clut_async(const uint32_t* argb, uint16_t count, uint32_t* seq) {
+    if (argb == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    } else if (count == 0 || count > BLIT_CLUT_MAX) {
+        return BLIT_STATUS_BAD_CLUT;
+    }
+#if defined(CORE_CM7)
+    // Later DMA2D jobs read L8 through the engine's copy, which it loads itself.
+    if (!blit_dma2d_reachable((uintptr_t)argb)) {
+        return BLIT_STATUS_BAD_CLUT;
+    }
+#endif
+    blit_job_t job = {.clut = argb, .clut_size = count};
+    return blit_submit(&job, seq);
+}
+
+blit_status_t blit_load_clut(const uint32_t* argb, uint16_t count) {
+    uint32_t seq;
+    blit_status_t status = blit_load_clut_async(argb, count, &seq);
+    return status == BLIT_STATUS_OK ? blit_wait(seq, BLIT_WAIT_FOREVER) : status;
+}
+
+bool blit_done(uint32_t seq) {
+#if defined(CORE_CM7)
+    return fence_reached(&blit_queue.retired, seq);
+#else
+    (void)seq;
+    return true;
+#endif
+}
+
+blit_status_t blit_wait(uint32_t seq, uint32_t timeout_us) {
+#if defined(CORE_CM7)
+    if (fence_wait(&blit_queue.retired, seq, timeout_us) != FENCE_STATUS_OK) {
+        return BLIT_STATUS_TIMEOUT;
+    }
+    return blit_queue.failed[seq % BLIT_QUEUE_DEPTH] == seq ? BLIT_STATUS_DMA_ERR
+                                                           : BLIT_STATUS_OK;
+#else
+    (void)seq;
+    (void)timeout_us;
+    return BLIT_STATUS_OK;
+#endif
+}
+
+blit_status_t blit_wait_idle(uint32_t timeout_us) {
+#if defined(CORE_CM7)
+    blit_status_t status = blit_queue_drain(timeout_us);
+    // Idle, so the interrupt cannot add to the count while it is taken.
+    if (status == BLIT_STATUS_OK && blit_queue.failures != 0) {
+        blit_queue.failures = 0;
+        status = BLIT_STATUS_DMA_ERR;
+    }
+    return status;
+#else
+    (void)timeout_us;
+    return BLIT_STATUS_OK;
+#endif
+}
+
+void blit_frame_stats(blit_frame_stats_t* stats) {
+#if defined(CORE_CM7)
+    HAL_NVIC_DisableIRQ(DMA2D_IRQn);
+    uint32_t now = timebase_now_us();
+    blit_frame_stats_t frame = blit_queue.frame;
+    // A job spanning the boundary counts towards both frames.
+    if (blit_queue.running) {
+        frame.busy_us += now - blit_queue.job_start_us;
+        blit_queue.job_start_us = now;
+    }
+    uint32_t depth_sum = blit_queue.depth_sum;
+    frame.frame_us = now - blit_queue.frame_start_us;
+    blit_queue.frame_start_us = now;
+    blit_queue.frame = (blit_frame_stats_t){0};
+    blit_queue.depth_sum = 0;
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+
+    frame.busy_pct =
+        frame.frame_us == 0 ? 0 : (uint8_t)((uint64_t)frame.busy_us * 100 / frame.frame_us);
+    frame.mean_depth = frame.jobs == 0 ? 0 : (uint16_t)(depth_sum / frame.jobs);
+    if (stats != NULL) {
+        *stats = frame;
+    }
+#else
+    if (stats != NULL) {
+        *stats = (blit_frame_stats_t){0};
+    }
+#endif
+}
+
+void blit_irq(void) {
+#if defined(CORE_CM7)
+    uint32_t isr = DMA2D->ISR;
+    DMA2D->IFCR = BLIT_DMA2D_ALL_FLAGS;
+    if (!blit_queue.running) {
+        return;
+    }
+
+    uint32_t seq = blit_queue.started;
+    const blit_job_t* job = &blit_queue.jobs[seq % BLIT_QUEUE_DEPTH];
+    // The job retires either way, so later ones still run; waiters on it get the error.
+    blit_queue.failed[seq % BLIT_QUEUE_DEPTH] = (isr & BLIT_DMA2D_ERROR_FLAGS) ? seq : 0;
+    if (isr & BLIT_DMA2D_ERROR_FLAGS) {
+        blit_state.stats.dma2d_errors++;
+        blit_queue.failures++;
+    }
+    blit_dma2d_finish(job);
+    if (job->clut != NULL) {
+        blit_state.clut = job->clut;
+        blit_state.clut_size = job->clut_size;
+    }
+    blit_queue.frame.busy_us += timebase_now_us() - blit_queue.job_start_us;
+    TRACE_ASYNC_END(TRACE_EVENT_DMA, seq);
+    fence_signal(&blit_queue.retired, seq);
+
+    blit_queue_start_next();
+#endif
+}
+
+void blit_set_engine(blit_engine_t engine) {
+    blit_state.engine = engine;
+}
+
+void blit_set_crossover(blit_op_t op, uint32_t pixels) {
+    if (op < BLIT_OP_COUNT) {
+        blit_state.crossover[op] = pixels;
+    }
+}
+
+uint32_t blit_get_crossover(blit_op_t op) {
+    return op < BLIT_OP_COUNT ? blit_state.crossover[op] : 0;
+}
+
+void blit_get_stats(blit_stats_t* stats) {
+    if (stats != NULL) {
+        *stats = blit_state.stats;
+    }
+}
+
+/***** CALIBRATION *****/
+
+static const uint32_t blit_calibrate_pixels[BLIT_CALIBRATE_SIZES] = {16, 64, 256, 1024, 2048,
+                                                                     BLIT_CALIBRATE_MAX_PIXELS};
+
+// Deterministic noise, so every run (and both engines) sees the same inputs.
+static void blit_calibrate_pattern(uint8_t* buf, uint32_t size_b, uint32_t seed) {
+    for (uint32_t i = 0; i < size_b; i++) {
+        seed = seed * 1664525UL + 1013904223UL;
+        buf[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+// Runs op on a width x height block of the scratch surfaces with the given engine and returns
+// the cycles taken. The destination is reset first.
+static uint32_t blit_calibrate_run(blit_op_t op, blit_engine_t engine, const surface_t* dst,
+                                   const surface_t* src, const rect_t* rect) {
+    blit_calibrate_pattern(dst->pixels, dst->stride_b * dst->height, 0x5EED0000UL);
+    blit_set_engine(engine);
+    uint32_t start = cycles_now();
+    switch (op) {
+        case BLIT_OP_FILL:
+            blit_fill(dst, rect, 0x80C0FFEEUL);
+            break;
+        case BLIT_OP_COPY:
+        case BLIT_OP_CONVERT:
+            blit_copy(dst, 0, 0, src, rect);
+            break;
+        case BLIT_OP_BLEND:
+            blit_blend(dst, 0, 0, src, rect, 0xC0);
+            break;
+        default:
+            break;
+    }
+    return cycles_now() - start;
+}
+
+blit_status_t blit_calibrate(void* scratch, blit_calibration_t* result) {
+    if (scratch == NULL || result == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    }
+    *result = (blit_calibration_t){0};
+    cycles_init();
+    blit_engine_t engine = blit_state.engine;
+
+    // Everything draws into an RGB565 target, the scan-out format. Sources are RGB565 for the
+    // plain copy and ARGB8888 (with alpha) otherwise.
+    uint8_t* src_pixels = scratch;
+    uint8_t* dst_pixels = src_pixels + BLIT_CALIBRATE_MAX_PIXELS * 4;
+    uint8_t* ref_pixels = dst_pixels + BLIT_CALIBRATE_MAX_PIXELS * 2;
+    blit_calibrate_pattern(src_pixels, BLIT_CALIBRATE_MAX_PIXELS * 4, 0xC0FFEEUL);
+
+    for (blit_op_t op = 0; op < BLIT_OP_COUNT; op++) {
+        pixel_format_t src_format =
+            op == BLIT_OP_COPY ? PIXEL_FORMAT_RGB565 : PIXEL_FORMAT_ARGB8888;
+        result->crossover_pixels[op] = BLIT_CALIBRATE_MAX_PIXELS + 1;
+
+        for (uint32_t i = 0; i < BLIT_CALIBRATE_SIZES; i++) {
+            uint32_t pixels = blit_calibrate_pixels[i];
+            uint16_t width = pixels < 64 ? (uint16_t)pixels : 64;
+            uint16_t height = (uint16_t)(pixels / width);
+            surface_t src = {src_pixels, width, height,
+                             (uint32_t)width * pixel_format_bytes(src_format), src_format};
+            surface_t dst = {dst_pixels, width, height, (uint32_t)width * 2, PIXEL_FORMAT_RGB565};
+            rect_t rect = {0, 0, (int16_t)width, (int16_t)height};
+            result->pixels[i] = pixels;
+
+            result->software_cycles[op][i] =
+                blit_calibrate_run(op, BLIT_ENGINE_SOFTWARE, &dst, &src, &rect);
+            memcpy(ref_pixels, dst_pixels, pixels * 2);
+#if defined(CORE_CM7)
+            result->dma2d_cycles[op][i] =
+                blit_calibrate_run(op, BLIT_ENGINE_DMA2D, &dst, &src, &rect);
+            const uint16_t* got = (const uint16_t*)dst_pixels;
+            const uint16_t* want = (const uint16_t*)ref_pixels;
+            for (uint32_t p = 0; p < pixels; p++) {
+                result->mismatches[op] += got[p] != want[p];
+            }
+            if (result->dma2d_cycles[op][i] < result->software_cycles[op][i] &&
+                result->crossover_pixels[op] > BLIT_CALIBRATE_MAX_PIXELS) {
+                result->crossover_pixels[op] = pixels;
+            }
+#endif
+        }
+        blit_state.crossover[op] = result->crossover_pixels[op];
+    }
+
+    blit_state.engine = engine;
+    return BLIT_STATUS_OK;
+}
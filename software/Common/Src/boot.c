@@ -0,0 +1,18 @@
+#include "boot.h"
+
+#include "shared_mem.h"
+#include "timebase.h"
+#include "trace.h"
+
+void boot_mark(boot_mark_t mark) {
+    if (mark >= BOOT_MARK_COUNT || shared_mem.boot.marks_us[mark] != 0) {
+        return;
+    }
+    uint32_t now = timebase_now_us();
+    shared_mem.boot.marks_us[mark] = now != 0 ? now : 1;
+    TRACE_INSTANT(TRACE_EVENT_BOOT, mark);
+}
+
+uint32_t boot_mark_us(boot_mark_t mark) {
+    return mark < BOOT_MARK_COUNT ? shared_mem.boot.marks_us[mark] : 0;
+}
@@ -0,0 +1,182 @@
+#include "buffer_queue.h"
+
+#include "cache_maint.h"
+#include "shared_mem.h"
+#include "timebase.h"
+#include "trace.h"
+
+#include <stddef.h>
+#include <string.h>
+
+buffer_queue_t* buffer_queue_get(buffer_queue_id_t id) {
+    return id < BUFFER_QUEUE_COUNT ? &shared_mem.buffer_queue.queues[id] : NULL;
+}
+
+buffer_queue_status_t buffer_queue_init(buffer_queue_t* queue, const surface_t* surfaces,
+                                        uint32_t num_buffers, core_id_t producer,
+                                        core_id_t consumer, bool consumer_cpu_reads,
+                                        uint32_t queued_sem_id, uint32_t released_sem_id) {
+    if (queue == NULL || surfaces == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    } else if (num_buffers == 0 || num_buffers > BUFFER_QUEUE_MAX_BUFFERS ||
+               producer >= CORE_ID_COUNT || consumer >= CORE_ID_COUNT) {
+        return BUFFER_QUEUE_STATUS_BAD_CONFIG;
+    }
+
+    memset(queue, 0, sizeof(*queue));
+    queue->config.num_buffers = num_buffers;
+    queue->config.producer_core = (uint8_t)producer;
+    queue->config.consumer_core = (uint8_t)consumer;
+    queue->config.consumer_cpu_reads = consumer_cpu_reads;
+    for (uint32_t i = 0; i < num_buffers; i++) {
+        queue->buffers[i].surface = surfaces[i];
+        queue->buffers[i].state = BUFFER_STATE_FREE;
+        queue->producer.missed[i] = surface_bounds(&surfaces[i]);
+        queue->consumer.free_ring[i] = (uint8_t)i;
+    }
+    if (fence_init(&queue->queued, queued_sem_id) != FENCE_STATUS_OK ||
+        fence_init(&queue->released, released_sem_id) != FENCE_STATUS_OK) {
+        return BUFFER_QUEUE_STATUS_BAD_CONFIG;
+    }
+    // Every buffer starts out released.
+    fence_signal(&queue->released, num_buffers);
+    return BUFFER_QUEUE_STATUS_OK;
+}
+
+buffer_queue_status_t buffer_queue_attach(buffer_queue_t* queue) {
+    if (queue == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    }
+    fence_status_t status = FENCE_STATUS_OK;
+    if (queue->config.producer_core == CORE_ID_SELF) {
+        status = fence_attach(&queue->released);
+    }
+    if (queue->config.consumer_core == CORE_ID_SELF && status == FENCE_STATUS_OK) {
+        status = fence_attach(&queue->queued);
+    }
+    return status == FENCE_STATUS_OK ? BUFFER_QUEUE_STATUS_OK : BUFFER_QUEUE_STATUS_BAD_CONFIG;
+}
+
+/***** PRODUCER *****/
+
+buffer_queue_status_t buffer_queue_acquire(buffer_queue_t* queue, uint32_t timeout_us,
+                                           uint32_t* index, const surface_t** surface) {
+    if (queue == NULL || index == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    } else if (queue->config.producer_core != CORE_ID_SELF) {
+        return BUFFER_QUEUE_STATUS_WRONG_CORE;
+    }
+
+    uint32_t tail = queue->producer.free_tail;
+    if (fence_wait(&queue->released, tail + 1, timeout_us) != FENCE_STATUS_OK) {
+        return BUFFER_QUEUE_STATUS_TIMEOUT;
+    }
+    uint32_t i = queue->consumer.free_ring[tail % BUFFER_QUEUE_MAX_BUFFERS];
+    queue->producer.free_tail = tail + 1;
+    queue->buffers[i].state = BUFFER_STATE_RENDERING;
+
+    *index = i;
+    if (surface != NULL) {
+        *surface = &queue->buffers[i].surface;
+    }
+    return BUFFER_QUEUE_STATUS_OK;
+}
+
+buffer_queue_status_t buffer_queue_queue(buffer_queue_t* queue, uint32_t index,
+                                         const rect_t* damage) {
+    if (queue == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    } else if (queue->config.producer_core != CORE_ID_SELF) {
+        return BUFFER_QUEUE_STATUS_WRONG_CORE;
+    } else if (index >= queue->config.num_buffers ||
+               queue->buffers[index].state != BUFFER_STATE_RENDERING) {
+        return BUFFER_QUEUE_STATUS_NOT_OWNED;
+    }
+
+    buffer_queue_buffer_t* buffer = &queue->buffers[index];
+    rect_t bounds = surface_bounds(&buffer->surface);
+    buffer->damage = damage != NULL ? rect_intersect(damage, &bounds) : bounds;
+    // The damage is relative to the previous frame, but the producer also brought this buffer up
+    // to date with the frames it missed. A no-op on the CM4 and for uncached buffers.
+    rect_t written = rect_union(&queue->producer.missed[index], &buffer->damage);
+    cache_maint_rects(&buffer->surface, &written, 1, CACHE_MAINT_CLEAN);
+    for (uint32_t i = 0; i < queue->config.num_buffers; i++) {
+        queue->producer.missed[i] = i == index ? (rect_t){0, 0, 0, 0}
+                                               : rect_union(&queue->producer.missed[i],
+                                                            &buffer->damage);
+    }
+
+    buffer->frame = ++queue->producer.frames;
+    buffer->queued_us = timebase_now_us();
+    buffer->state = BUFFER_STATE_QUEUED;
+    uint32_t head = fence_value(&queue->queued);
+    queue->producer.queued_ring[head % BUFFER_QUEUE_MAX_BUFFERS] = (uint8_t)index;
+    fence_signal(&queue->queued, head + 1);
+    TRACE_INSTANT(TRACE_EVENT_BUFFER_QUEUE, index);
+    return BUFFER_QUEUE_STATUS_OK;
+}
+
+/***** CONSUMER *****/
+
+static void buffer_queue_push_free(buffer_queue_t* queue, uint32_t index) {
+    queue->buffers[index].state = BUFFER_STATE_FREE;
+    uint32_t head = fence_value(&queue->released);
+    queue->consumer.free_ring[head % BUFFER_QUEUE_MAX_BUFFERS] = (uint8_t)index;
+    fence_signal(&queue->released, head + 1);
+}
+
+buffer_queue_status_t buffer_queue_present(buffer_queue_t* queue, uint32_t* index,
+                                           const buffer_queue_buffer_t** buffer) {
+    if (queue == NULL || index == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    } else if (queue->config.consumer_core != CORE_ID_SELF) {
+        return BUFFER_QUEUE_STATUS_WRONG_CORE;
+    }
+
+    uint32_t tail = queue->consumer.queued_tail;
+    uint32_t head = fence_value(&queue->queued);
+    if (head == tail) {
+        return BUFFER_QUEUE_STATUS_EMPTY;
+    }
+    __DMB();  // Ring entries and buffer fields after the head that published them.
+
+    // Everything but the newest was superseded before it reached the screen.
+    for (; tail + 1 != head; tail++) {
+        uint32_t stale = queue->producer.queued_ring[tail % BUFFER_QUEUE_MAX_BUFFERS];
+        buffer_queue_push_free(queue, stale);
+        queue->consumer.dropped++;
+    }
+    uint32_t i = queue->producer.queued_ring[tail % BUFFER_QUEUE_MAX_BUFFERS];
+    queue->consumer.queued_tail = head;
+
+    buffer_queue_buffer_t* b = &queue->buffers[i];
+    if (queue->config.consumer_cpu_reads) {
+        // Drop lines the CPU may still hold from the last time it read this buffer. The damage
+        // is relative to the previous frame, not to this buffer's old contents, so this has to
+        // cover all of it.
+        rect_t bounds = surface_bounds(&b->surface);
+        cache_maint_rects(&b->surface, &bounds, 1, CACHE_MAINT_INVALIDATE);
+    }
+    b->state = BUFFER_STATE_PRESENTED;
+    queue->consumer.presented++;
+    TRACE_INSTANT(TRACE_EVENT_BUFFER_PRESENT, i);
+
+    *index = i;
+    if (buffer != NULL) {
+        *buffer = b;
+    }
+    return BUFFER_QUEUE_STATUS_OK;
+}
+
+buffer_queue_status_t buffer_queue_release(buffer_queue_t* queue, uint32_t index) {
+    if (queue == NULL) {
+        return BUFFER_QUEUE_STATUS_NULL_ARG;
+    } else if (queue->config.consumer_core != CORE_ID_SELF) {
+        return BUFFER_QUEUE_STATUS_WRONG_CORE;
+    } else if (index >= queue->config.num_buffers ||
+               queue->buffers[index].state != BUFFER_STATE_PRESENTED) {
+        return BUFFER_QUEUE_STATUS_NOT_OWNED;
+    }
+    buffer_queue_push_free(queue, index);
+    return BUFFER_QUEUE_STATUS_OK;
+}
@@ -0,0 +1,201 @@
+#include "cache_maint.h"
+
+#include "mem_attr.h"
+
+#if defined(CORE_CM7)
+#include "stm32h7xx_hal.h"
+#endif
+
+#define CACHE_MAINT_LINE_MASK ((uintptr_t)CACHE_LINE_SIZE_B - 1)
+
+static cache_maint_stats_t cache_maint_stats;
+
+// Appends [start, end) to the range list, which is built in ascending address order. Anything
+// touching the previous range extends it; once the list is full the last range absorbs the rest,
+// which never misses a line but covers the ones in between too, and clears *exact.
+static void cache_maint_emit(cache_range_t* ranges, size_t* num_ranges, size_t max_ranges,
+                             uintptr_t start, uintptr_t end, bool* exact) {
+    start &= ~CACHE_MAINT_LINE_MASK;
+    end = (end + CACHE_MAINT_LINE_MASK) & ~CACHE_MAINT_LINE_MASK;
+
+    if (*num_ranges > 0) {
+        cache_range_t* last = &ranges[*num_ranges - 1];
+        uintptr_t last_end = last->start + last->size_b;
+        if (start > last_end && *num_ranges == max_ranges) {
+            *exact = false;
+        }
+        if (start <= last_end || *num_ranges == max_ranges) {
+            if (end > last_end) {
+                last->size_b = (uint32_t)(end - last->start);
+            }
+            return;
+        }
+    }
+    ranges[*num_ranges].start = start;
+    ranges[*num_ranges].size_b = (uint32_t)(end - start);
+    (*num_ranges)++;
+}
+
+// As cache_maint_rects_to_ranges(); *exact is cleared if the ranges also cover lines outside the
+// rectangles.
+static size_t cache_maint_build_ranges(const surface_t* surface, const rect_t* rects,
+                                       size_t num_rects, cache_range_t* ranges, size_t max_ranges,
+                                       bool* exact) {
+    *exact = true;
+    if (surface == NULL || rects == NULL || ranges == NULL || max_ranges == 0) {
+        return 0;
+    }
+
+    // Clip to the surface and drop empties. Overflowing rectangles merge into the last slot.
+    rect_t clipped[CACHE_MAINT_MAX_RECTS];
+    size_t count = 0;
+    rect_t bounds = surface_bounds(surface);
+    int16_t y_min = INT16_MAX;
+    int16_t y_max = INT16_MIN;
+    for (size_t i = 0; i < num_rects; i++) {
+        rect_t r = rect_intersect(&rects[i], &bounds);
+        if (rect_is_empty(&r)) {
+            continue;
+        }
+        if (count == CACHE_MAINT_MAX_RECTS) {
+            clipped[count - 1] = rect_union(&clipped[count - 1], &r);
+            *exact = false;
+        } else {
+            clipped[count++] = r;
+        }
+        y_min = r.y0 < y_min ? r.y0 : y_min;
+        y_max = r.y1 > y_max ? r.y1 : y_max;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Sort by left edge so each row's spans come out in address order.
+    for (size_t i = 1; i < count; i++) {
+        rect_t r = clipped[i];
+        size_t j = i;
+        for (; j > 0 && clipped[j - 1].x0 > r.x0; j--) {
+            clipped[j] = clipped[j - 1];
+        }
+        clipped[j] = r;
+    }
+
+    // Sweep rows top to bottom. Spans that overlap within a row are merged, and consecutive rows
+    // coalesce automatically when the surface is packed (or the gap rounds away to a cache line).
+    uint8_t bpp = pixel_format_bytes(surface->format);
+    size_t num_ranges = 0;
+    for (int16_t y = y_min; y < y_max; y++) {
+        uintptr_t row = (uintptr_t)surface->pixels + (uint32_t)y * surface->stride_b;
+        bool open = false;
+        int16_t span_x0 = 0;
+        int16_t span_x1 = 0;
+        for (size_t i = 0; i < count; i++) {
+            const rect_t* r = &clipped[i];
+            if (y < r->y0 || y >= r->y1) {
+                continue;
+            }
+            if (open && r->x0 <= span_x1) {
+                span_x1 = r->x1 > span_x1 ? r->x1 : span_x1;
+                continue;
+            }
+            if (open) {
+                cache_maint_emit(ranges, &num_ranges, max_ranges, row + (uint32_t)span_x0 * bpp,
+                                 row + (uint32_t)span_x1 * bpp, exact);
+            }
+            open = true;
+            span_x0 = r->x0;
+            span_x1 = r->x1;
+        }
+        if (open) {
+            cache_maint_emit(ranges, &num_ranges, max_ranges, row + (uint32_t)span_x0 * bpp,
+                             row + (uint32_t)span_x1 * bpp, exact);
+        }
+    }
+    return num_ranges;
+}
+
+size_t cache_maint_rects_to_ranges(const surface_t* surface, const rect_t* rects, size_t num_rects,
+                                   cache_range_t* ranges, size_t max_ranges) {
+    bool exact;
+    return cache_maint_build_ranges(surface, rects, num_rects, ranges, max_ranges, &exact);
+}
+
+void cache_maint_ranges(const cache_range_t* ranges, size_t num_ranges, cache_maint_op_t op) {
+    if (ranges == NULL || num_ranges == 0) {
+        return;
+    }
+
+    uint32_t lines = 0;
+    for (size_t i = 0; i < num_ranges; i++) {
+        lines += ranges[i].size_b / CACHE_LINE_SIZE_B;
+    }
+    cache_maint_stats.calls++;
+    cache_maint_stats.ranges += num_ranges;
+
+#if defined(CORE_CM7)
+    // A whole-cache walk costs the same no matter how much changed; prefer it only once the
+    // by-address work would be larger. Invalidating the whole cache would discard unrelated dirty
+    // lines, so that case cleans as well.
+    if (lines > CACHE_MAINT_FULL_CACHE_LINES) {
+        cache_maint_stats.full_cache_ops++;
+        if (op == CACHE_MAINT_CLEAN) {
+            SCB_CleanDCache();
+        } else {
+            SCB_CleanInvalidateDCache();
+        }
+        return;
+    }
+
+    // Same as SCB_*DCache_by_Addr() per range, but with a single barrier for the whole batch.
+    volatile uint32_t* reg = op == CACHE_MAINT_CLEAN        ? &SCB->DCCMVAC
+                             : op == CACHE_MAINT_INVALIDATE ? &SCB->DCIMVAC
+                                                            : &SCB->DCCIMVAC;
+    __DSB();
+    for (size_t i = 0; i < num_ranges; i++) {
+        uintptr_t end = ranges[i].start + ranges[i].size_b;
+        for (uintptr_t addr = ranges[i].start; addr < end; addr += CACHE_LINE_SIZE_B) {
+            *reg = (uint32_t)addr;
+        }
+    }
+    __DSB();
+    __ISB();
+#else
+    (void)op;
+#endif
+    cache_maint_stats.lines += lines;
+}
+
+void cache_maint_rects(const surface_t* surface, const rect_t* rects, size_t num_rects,
+                       cache_maint_op_t op) {
+    if (surface == NULL || rects == NULL || num_rects == 0) {
+        return;
+    }
+
+    // Uncached memory never needs maintenance, and write-through memory is never dirty.
+    mem_attr_policy_t policy = mem_attr_get_policy((uintptr_t)surface->pixels);
+    if (policy == MEM_ATTR_UNCACHED || policy == MEM_ATTR_UNCACHED_SHARED ||
+        (policy == MEM_ATTR_WRITE_THROUGH && op == CACHE_MAINT_CLEAN)) {
+        cache_maint_stats.skipped++;
+        return;
+    }
+
+    cache_range_t ranges[CACHE_MAINT_MAX_RECTS];
+    bool exact;
+    size_t num_ranges = cache_maint_build_ranges(surface, rects, num_rects, ranges,
+                                                 CACHE_MAINT_MAX_RECTS, &exact);
+    // Lines between the rectangles may hold unrelated CPU writes, which must not be dropped.
+    if (!exact && op == CACHE_MAINT_INVALIDATE) {
+        op = CACHE_MAINT_CLEAN_INVALIDATE;
+    }
+    cache_maint_ranges(ranges, num_ranges, op);
+}
+
+void cache_maint_get_stats(cache_maint_stats_t* stats) {
+    if (stats != NULL) {
+        *stats = cache_maint_stats;
+    }
+}
+
+void cache_maint_reset_stats(void) {
+    cache_maint_stats = (cache_maint_stats_t){0};
+}
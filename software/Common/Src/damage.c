@@ -0,0 +1,217 @@
+#include "damage.h"
+
+#include <stddef.h>
+
+/***** REGIONS *****/
+
+static bool damage_rect_contains(const rect_t* outer, const rect_t* inner) {
+    return inner->x0 >= outer->x0 && inner->y0 >= outer->y0 && inner->x1 <= outer->x1 &&
+           inner->y1 <= outer->y1;
+}
+
+// Extra pixels drawn by replacing a and b with their bounds, less the per-rectangle cost saved.
+static int32_t damage_merge_cost(const rect_t* a, const rect_t* b) {
+    rect_t u = rect_union(a, b);
+    return (int32_t)rect_area(&u) - (int32_t)rect_area(a) - (int32_t)rect_area(b) -
+           DAMAGE_RECT_COST_PX;
+}
+
+static void damage_region_remove(damage_region_t* region, uint8_t i) {
+    region->rects[i] = region->rects[--region->count];
+}
+
+// Folds rects[i] into any rectangle it is cheaper to merge with, repeating for the result.
+static uint32_t damage_region_settle(damage_region_t* region, uint8_t i) {
+    uint32_t merges = 0;
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t j = 0; j < region->count; j++) {
+            if (j == i || damage_merge_cost(&region->rects[i], &region->rects[j]) > 0) {
+                continue;
+            }
+            region->rects[i] = rect_union(&region->rects[i], &region->rects[j]);
+            damage_region_remove(region, j);
+            if (i == region->count) {
+                i = j;  // rects[i] was the one moved into the gap.
+            }
+            merges++;
+            merged = true;
+            break;
+        }
+    }
+    return merges;
+}
+
+static uint32_t damage_region_add_counted(damage_region_t* region, const rect_t* rect) {
+    if (rect_is_empty(rect)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < region->count; i++) {
+        if (damage_rect_contains(&region->rects[i], rect)) {
+            return 0;
+        }
+    }
+    if (region->count == DAMAGE_MAX_RECTS) {
+        // Full: fold the new rectangle into whichever existing one grows least.
+        uint8_t best = 0;
+        int32_t best_cost = INT32_MAX;
+        for (uint8_t i = 0; i < region->count; i++) {
+            int32_t cost = damage_merge_cost(&region->rects[i], rect);
+            if (cost < best_cost) {
+                best = i;
+                best_cost = cost;
+            }
+        }
+        region->rects[best] = rect_union(&region->rects[best], rect);
+        return 1 + damage_region_settle(region, best);
+    }
+    region->rects[region->count++] = *rect;
+    return damage_region_settle(region, (uint8_t)(region->count - 1));
+}
+
+void damage_region_clear(damage_region_t* region) {
+    region->count = 0;
+}
+
+void damage_region_add(damage_region_t* region, const rect_t* rect) {
+    damage_region_add_counted(region, rect);
+}
+
+uint32_t damage_region_area(const damage_region_t* region) {
+    uint32_t area = 0;
+    for (uint8_t i = 0; i < region->count; i++) {
+        area += rect_area(&region->rects[i]);
+    }
+    return area;
+}
+
+/***** TRACKER *****/
+
+damage_status_t damage_init(damage_tracker_t* tracker, uint16_t width, uint16_t height,
+                            uint8_t num_buffers) {
+    if (tracker == NULL) {
+        return DAMAGE_STATUS_NULL_ARG;
+    } else if (num_buffers == 0 || num_buffers > DAMAGE_MAX_BUFFERS || width == 0 ||
+               height == 0 || width > INT16_MAX || height > INT16_MAX) {
+        return DAMAGE_STATUS_BAD_CONFIG;
+    }
+    *tracker = (damage_tracker_t){
+        .bounds = {0, 0, (int16_t)width, (int16_t)height},
+        .num_buffers = num_buffers,
+        .front = -1,
+    };
+    return DAMAGE_STATUS_OK;
+}
+
+void damage_add(damage_tracker_t* tracker, const rect_t* rect) {
+    if (tracker == NULL || rect == NULL) {
+        return;
+    }
+    rect_t clipped = rect_intersect(rect, &tracker->bounds);
+    tracker->stats.merges += damage_region_add_counted(&tracker->pending, &clipped);
+}
+
+void damage_add_all(damage_tracker_t* tracker) {
+    if (tracker == NULL) {
+        return;
+    }
+    tracker->pending.count = 1;
+    tracker->pending.rects[0] = tracker->bounds;
+}
+
+void damage_set_full_repaint(damage_tracker_t* tracker, bool full_repaint) {
+    if (tracker != NULL) {
+        tracker->full_repaint = full_repaint;
+    }
+}
+
+damage_status_t damage_begin(damage_tracker_t* tracker, uint8_t index, damage_frame_t* frame) {
+    if (tracker == NULL || frame == NULL) {
+        return DAMAGE_STATUS_NULL_ARG;
+    } else if (index >= tracker->num_buffers) {
+        return DAMAGE_STATUS_BAD_INDEX;
+    }
+    uint32_t held = tracker->buffer_frame[index];
+    uint32_t age = held == 0 ? 0 : tracker->frame - held + 1;
+    *frame = (damage_frame_t){.age = (uint8_t)(age > UINT8_MAX ? UINT8_MAX : age)};
+
+    if (tracker->full_repaint || age == 0 || age > DAMAGE_HISTORY) {
+        frame->full = true;
+        frame->render.count = 1;
+        frame->render.rects[0] = tracker->bounds;
+        return DAMAGE_STATUS_OK;
+    }
+    frame->render = tracker->pending;
+    // Frames held + 1 .. frame changed the front buffer but not this one. Whatever this frame
+    // redraws anyway need not be copied.
+    for (uint32_t n = held + 1; n <= tracker->frame; n++) {
+        const damage_region_t* missed = &tracker->history[n % DAMAGE_HISTORY];
+        for (uint8_t i = 0; i < missed->count; i++) {
+            bool redrawn = false;
+            for (uint8_t j = 0; j < frame->render.count && !redrawn; j++) {
+                redrawn = damage_rect_contains(&frame->render.rects[j], &missed->rects[i]);
+            }
+            if (!redrawn) {
+                tracker->stats.merges +=
+                    damage_region_add_counted(&frame->repair, &missed->rects[i]);
+            }
+        }
+    }
+    tracker->stats.repaired_px += damage_region_area(&frame->repair);
+    return DAMAGE_STATUS_OK;
+}
+
+blit_status_t damage_repair(const damage_frame_t* frame, const surface_t* back,
+                            const surface_t* front, uint32_t* seq) {
+    if (frame == NULL || back == NULL || front == NULL) {
+        return BLIT_STATUS_NULL_ARG;
+    }
+    blit_status_t status = BLIT_STATUS_OK;
+    for (uint8_t i = 0; i < frame->repair.count && status == BLIT_STATUS_OK; i++) {
+        const rect_t* rect = &frame->repair.rects[i];
+        status = blit_copy_async(back, rect->x0, rect->y0, front, rect, seq);
+    }
+    if (frame->repair.count == 0 && seq != NULL) {
+        // Nothing queued; any sequence number already retired will do.
+        status = blit_copy_async(back, 0, 0, front, &(rect_t){0, 0, 0, 0}, seq);
+    }
+    return status;
+}
+
+damage_status_t damage_end(damage_tracker_t* tracker, uint8_t index) {
+    if (tracker == NULL) {
+        return DAMAGE_STATUS_NULL_ARG;
+    } else if (index >= tracker->num_buffers) {
+        return DAMAGE_STATUS_BAD_INDEX;
+    }
+    uint32_t held = tracker->buffer_frame[index];
+    uint32_t age = held == 0 ? 0 : tracker->frame - held + 1;
+    bool full = tracker->full_repaint || age == 0 || age > DAMAGE_HISTORY;
+
+    tracker->frame++;
+    tracker->stats.frames++;
+    if (full) {
+        tracker->stats.full_frames++;
+        tracker->stats.rendered_px += rect_area(&tracker->bounds);
+    } else {
+        tracker->stats.rendered_px += damage_region_area(&tracker->pending);
+    }
+    // Record what actually changed even when the whole buffer was drawn, so older buffers
+    // still catch up correctly.
+    tracker->history[tracker->frame % DAMAGE_HISTORY] = tracker->pending;
+    tracker->buffer_frame[index] = tracker->frame;
+    tracker->front = (int8_t)index;
+    damage_region_clear(&tracker->pending);
+    return DAMAGE_STATUS_OK;
+}
+
+int8_t damage_front(const damage_tracker_t* tracker) {
+    return tracker != NULL ? tracker->front : -1;
+}
+
+void damage_get_stats(const damage_tracker_t* tracker, damage_stats_t* stats) {
+    if (tracker != NULL && stats != NULL) {
+        *stats = tracker->stats;
+    }
+}
@@ -0,0 +1,119 @@
+#include "display_service.h"
+
+#if defined(CORE_CM7)
+
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    bool in_use;
+    uint16_t seq;
+    display_response_callback_t callback;
+    void* user;
+} display_pending_t;
+
+typedef struct {
+    uint16_t next_seq;
+    display_pending_t pending[DISPLAY_CLIENT_MAX_PENDING];
+    display_event_callback_t event_callback;
+    void* event_user;
+    bool connected;
+    video_timing_t mode;
+} display_client_t;
+
+static display_client_t display_client;
+
+display_status_t display_client_request(display_op_t op, uint8_t arg, const video_timing_t* timing,
+                                        display_response_callback_t callback, void* user) {
+    if (op == DISPLAY_OP_SET_MODE && timing == NULL) {
+        return DISPLAY_STATUS_NULL_ARG;
+    }
+
+    display_pending_t* slot = NULL;
+    for (size_t i = 0; i < DISPLAY_CLIENT_MAX_PENDING; i++) {
+        if (!display_client.pending[i].in_use) {
+            slot = &display_client.pending[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return DISPLAY_STATUS_BUSY;
+    }
+
+    display_request_t request = {.seq = display_client.next_seq, .op = op, .arg = arg};
+    if (timing != NULL) {
+        request.timing = *timing;
+    }
+    if (ipc_send(IPC_MSG_DISPLAY_REQUEST, &request, sizeof(request)) != IPC_STATUS_OK) {
+        return DISPLAY_STATUS_BUSY;
+    }
+
+    slot->in_use = true;
+    slot->seq = display_client.next_seq++;
+    slot->callback = callback;
+    slot->user = user;
+    return DISPLAY_STATUS_OK;
+}
+
+static void display_client_handle_response(const display_response_t* response) {
+    // Every response carries the mode the CM4 has programmed, so keep ours current.
+    if (response->status != DISPLAY_STATUS_NO_SINK) {
+        display_client.mode = response->mode;
+    }
+
+    for (size_t i = 0; i < DISPLAY_CLIENT_MAX_PENDING; i++) {
+        display_pending_t* slot = &display_client.pending[i];
+        if (slot->in_use && slot->seq == response->seq) {
+            slot->in_use = false;
+            if (slot->callback != NULL) {
+                slot->callback(response, slot->user);
+            }
+            return;
+        }
+    }
+}
+
+static void display_client_handle_event(const display_event_t* event) {
+    display_client.connected = event->event == DISPLAY_EVENT_CONNECTED;
+    display_client.mode = event->mode;
+    if (display_client.event_callback != NULL) {
+        display_client.event_callback(event, display_client.event_user);
+    }
+}
+
+bool display_client_handle(const ipc_msg_t* msg) {
+    if (msg == NULL) {
+        return false;
+    }
+
+    switch (msg->type) {
+        case IPC_MSG_DISPLAY_RESPONSE: {
+            display_response_t response;
+            memcpy(&response, msg->payload, sizeof(response));
+            display_client_handle_response(&response);
+            return true;
+        }
+        case IPC_MSG_DISPLAY_EVENT: {
+            display_event_t event;
+            memcpy(&event, msg->payload, sizeof(event));
+            display_client_handle_event(&event);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void display_client_set_event_callback(display_event_callback_t callback, void* user) {
+    display_client.event_callback = callback;
+    display_client.event_user = user;
+}
+
+bool display_client_get_mode(video_timing_t* mode) {
+    if (mode != NULL) {
+        *mode = display_client.mode;
+    }
+    return display_client.connected;
+}
+
+#endif
@@ -0,0 +1,395 @@
+#include "display_service.h"
+
+#if defined(CORE_CM4)
+
+#include "edid.h"
+#include "sii1136.h"
+#include "trace.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define DISPLAY_I2C_TIMEOUT_MS 50
+#define DISPLAY_DDC_TIMEOUT_MS 50
+#define DISPLAY_TPI_READY_TIMEOUT_MS 100
+#define DISPLAY_EDID_I2C_ADDR 0xA0
+
+// VESA DMT timings for the established-timing bits we are able to drive.
+typedef struct {
+    uint32_t bit;
+    video_timing_t timing;
+} display_established_mode_t;
+
+static const display_established_mode_t display_established_modes[] = {
+    {1UL << 21, {25175, 640, 16, 96, 48, 480, 10, 2, 33, 0}},        // 640x480 @ 60 Hz
+    {1UL << 16, {40000, 800, 40, 128, 88, 600, 1, 4, 23,
+                 VIDEO_TIMING_FLAG_HSYNC_POS | VIDEO_TIMING_FLAG_VSYNC_POS}},  // 800x600 @ 60 Hz
+    {1UL << 11, {65000, 1024, 24, 136, 160, 768, 3, 6, 29, 0}},      // 1024x768 @ 60 Hz
+};
+
+#define DISPLAY_NUM_ESTABLISHED_MODES \
+    (sizeof(display_established_modes) / sizeof(display_established_modes[0]))
+#define DISPLAY_NUM_CANDIDATES (EDID_NUM_DETAILED_TIMINGS + DISPLAY_NUM_ESTABLISHED_MODES)
+
+// Every sink must accept 640x480 @ 60 Hz, so it is used when the EDID cannot be read.
+#define DISPLAY_FALLBACK_MODE (display_established_modes[0].timing)
+
+typedef struct {
+    sii1136_t sii1136;
+    bool initialized;
+    bool connected;       // Last hot-plug state reported to the CM7.
+    bool hpd_pending;     // HPD changed and is waiting out the settle time.
+    uint32_t hpd_tick;
+    uint32_t poll_tick;
+    volatile bool irq_pending;
+    uint8_t edid_buf[EDID_BASIC_SIZE_B];
+    video_timing_t mode;  // Programmed mode; pixel_clock_khz == 0 if none.
+    // Messages held back by a full ring, sent from display_service_poll() once it drains. The
+    // client never has more than DISPLAY_CLIENT_MAX_PENDING requests in flight, and only the
+    // latest event matters.
+    display_response_t unsent_responses[DISPLAY_CLIENT_MAX_PENDING];  // Oldest first.
+    uint8_t num_unsent_responses;
+    display_event_t unsent_event;
+    bool event_unsent;
+} display_service_t;
+
+static display_service_t display_service;
+
+/***** SII1136 HELPERS *****/
+
+static display_status_t display_program_mode(const video_timing_t* mode) {
+    sii1136_t* sii = &display_service.sii1136;
+    sii1136_status_t status = SII1136_STATUS_OK;
+    status |= sii1136_set_pixel_clock(sii, mode->pixel_clock_khz * 1000);
+    status |= sii1136_set_vert_freq(sii, (uint16_t)video_timing_refresh_chz(mode));
+    status |= sii1136_set_horiz_res(sii, (uint16_t)video_timing_h_total(mode));
+    status |= sii1136_set_vert_res(sii, (uint16_t)video_timing_v_total(mode));
+    status |= sii1136_set_input_format(sii, SII1136_TMDS_CLK_RATIO_1, SII1136_BUS_PXL_WIDTH_FULL,
+                                       SII1136_VIDEO_CLK_EDGE_RISING, SII1136_PXL_REPETITION_NONE);
+    status |= sii1136_set_in_color_format(sii, SII1136_IN_COLOR_DEPTH_8,
+                                          SII1136_VIDEO_RANGE_EXP_AUTO, SII1136_IN_COLOR_SPACE_RGB);
+    status |= sii1136_set_out_color_format(sii, SII1136_OUT_COLOR_STD_BT709,
+                                           SII1136_VIDEO_RNG_COMP_AUTO, SII1136_OUT_COLOR_SPACE_RGB);
+    if (status != SII1136_STATUS_OK) {
+        return DISPLAY_STATUS_I2C_ERR;
+    }
+    display_service.mode = *mode;
+    return DISPLAY_STATUS_OK;
+}
+
+static display_status_t display_set_output(bool enabled) {
+    sii1136_status_t status = sii1136_set_tmds_output_control(
+        &display_service.sii1136,
+        enabled ? SII1136_TMDS_OUT_CNTL_ACTIVE : SII1136_TMDS_OUT_CNTL_OFF);
+    if (status != SII1136_STATUS_OK) {
+        return DISPLAY_STATUS_I2C_ERR;
+    }
+    return DISPLAY_STATUS_OK;
+}
+
+static bool display_wait_ddc_granted(bool granted) {
+    uint32_t start = HAL_GetTick();
+    bool state = !granted;
+    while (sii1136_get_ddc_bus_granted(&display_service.sii1136, &state) == SII1136_STATUS_OK) {
+        if (state == granted) {
+            return true;
+        } else if (HAL_GetTick() - start > DISPLAY_DDC_TIMEOUT_MS) {
+            break;
+        }
+    }
+    return false;
+}
+
+// The sink's DDC bus sits behind the SiI1136. Once the TPI grants it and the pass-through switch
+// is closed, the EEPROM appears on our own I2C bus until the switch is opened again.
+static display_status_t display_read_edid(void) {
+    sii1136_t* sii = &display_service.sii1136;
+    display_status_t status = DISPLAY_STATUS_OK;
+
+    if (sii1136_set_ddc_bus_requested(sii, true) != SII1136_STATUS_OK ||
+        !display_wait_ddc_granted(true) ||
+        sii1136_set_force_ddc_access(sii, true) != SII1136_STATUS_OK) {
+        status = DISPLAY_STATUS_I2C_ERR;
+    } else {
+        TRACE_BEGIN(TRACE_EVENT_I2C, DISPLAY_EDID_I2C_ADDR << 8);
+        if (HAL_I2C_Mem_Read(sii->_i2c_handle, DISPLAY_EDID_I2C_ADDR, 0x00, 1,
+                             display_service.edid_buf, EDID_BASIC_SIZE_B,
+                             DISPLAY_I2C_TIMEOUT_MS) != HAL_OK) {
+            status = DISPLAY_STATUS_EDID_ERR;
+        }
+        TRACE_END(TRACE_EVENT_I2C, DISPLAY_EDID_I2C_ADDR << 8);
+    }
+
+    // Always hand the bus back, or the TPI stays unreachable.
+    sii1136_set_force_ddc_access(sii, false);
+    sii1136_set_ddc_bus_requested(sii, false);
+    if (!display_wait_ddc_granted(false) && status == DISPLAY_STATUS_OK) {
+        status = DISPLAY_STATUS_I2C_ERR;
+    }
+    return status;
+}
+
+/***** MODE SELECTION *****/
+
+static bool display_mode_supported(const video_timing_t* mode) {
+    return mode->pixel_clock_khz >= DISPLAY_MIN_PIXEL_CLOCK_KHZ &&
+           mode->pixel_clock_khz <= DISPLAY_MAX_PIXEL_CLOCK_KHZ &&
+           (mode->flags & VIDEO_TIMING_FLAG_INTERLACED) == 0;
+}
+
+// The first detailed timing is the sink's preferred mode; use it if we can drive it. Otherwise
+// take the largest supported mode, breaking ties on refresh rate.
+static display_status_t display_select_mode(video_timing_t* mode) {
+    *mode = DISPLAY_FALLBACK_MODE;
+
+    edid_t* edid = (edid_t*)display_service.edid_buf;
+    if (edid_verify(edid) != EDID_STATUS_OK) {
+        return DISPLAY_STATUS_EDID_ERR;
+    }
+
+    video_timing_t candidates[DISPLAY_NUM_CANDIDATES];
+    size_t count = 0;
+    for (uint8_t i = 0; i < EDID_NUM_DETAILED_TIMINGS; i++) {
+        if (edid_get_detailed_timing(edid, i, &candidates[count]) == EDID_STATUS_OK &&
+            display_mode_supported(&candidates[count])) {
+            if (i == 0) {
+                *mode = candidates[0];
+                return DISPLAY_STATUS_OK;
+            }
+            count++;
+        }
+    }
+    uint32_t established = 0;
+    edid_get_established_timings(edid, &established);
+    for (size_t i = 0; i < DISPLAY_NUM_ESTABLISHED_MODES; i++) {
+        if (established & display_established_modes[i].bit) {
+            candidates[count++] = display_established_modes[i].timing;
+        }
+    }
+
+    uint32_t best_area = 0;
+    uint32_t best_refresh = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t area = (uint32_t)candidates[i].h_active * candidates[i].v_active;
+        uint32_t refresh = video_timing_refresh_chz(&candidates[i]);
+        if (area > best_area || (area == best_area && refresh > best_refresh)) {
+            *mode = candidates[i];
+            best_area = area;
+            best_refresh = refresh;
+        }
+    }
+    return DISPLAY_STATUS_OK;
+}
+
+// Reads the EDID, selects and programs a mode, and turns the TMDS output on. Falls back to
+// 640x480 if the EDID is unusable, and reports that in the returned status.
+static display_status_t display_configure(void) {
+    video_timing_t mode;
+    display_status_t edid_status = display_read_edid();
+    if (edid_status == DISPLAY_STATUS_I2C_ERR) {
+        return edid_status;
+    } else if (edid_status == DISPLAY_STATUS_OK) {
+        edid_status = display_select_mode(&mode);
+    } else {
+        mode = DISPLAY_FALLBACK_MODE;
+    }
+
+    display_status_t status = display_program_mode(&mode);
+    if (status == DISPLAY_STATUS_OK) {
+        status = display_set_output(true);
+    }
+    return status != DISPLAY_STATUS_OK ? status : edid_status;
+}
+
+/***** MESSAGING *****/
+
+// Sends whatever a full ring held back, oldest response first. Never waits for the CM7: a stalled
+// consumer must not hold up hot-plug handling. Returns DISPLAY_STATUS_BUSY if some is still held.
+static display_status_t display_flush(void) {
+    display_service_t* ds = &display_service;
+    while (ds->num_unsent_responses > 0) {
+        if (ipc_send(IPC_MSG_DISPLAY_RESPONSE, &ds->unsent_responses[0],
+                     sizeof(ds->unsent_responses[0])) != IPC_STATUS_OK) {
+            return DISPLAY_STATUS_BUSY;
+        }
+        ds->num_unsent_responses--;
+        memmove(&ds->unsent_responses[0], &ds->unsent_responses[1],
+                ds->num_unsent_responses * sizeof(ds->unsent_responses[0]));
+    }
+    if (ds->event_unsent) {
+        if (ipc_send(IPC_MSG_DISPLAY_EVENT, &ds->unsent_event, sizeof(ds->unsent_event)) !=
+            IPC_STATUS_OK) {
+            return DISPLAY_STATUS_BUSY;
+        }
+        ds->event_unsent = false;
+    }
+    return DISPLAY_STATUS_OK;
+}
+
+// Replaces any event not yet sent: the CM7 only needs the latest state.
+static display_status_t display_send_event(display_event_type_t type, display_status_t status) {
+    display_service.unsent_event =
+        (display_event_t){.event = type, .status = status, .mode = display_service.mode};
+    display_service.event_unsent = true;
+    return display_flush();
+}
+
+// Drops the response only if the client has broken its DISPLAY_CLIENT_MAX_PENDING limit.
+static display_status_t display_send_response(const display_response_t* response) {
+    if (display_service.num_unsent_responses == DISPLAY_CLIENT_MAX_PENDING) {
+        return DISPLAY_STATUS_BUSY;
+    }
+    display_service.unsent_responses[display_service.num_unsent_responses++] = *response;
+    return display_flush();
+}
+
+/***** PUBLIC API *****/
+
+display_status_t display_service_init(I2C_HandleTypeDef* i2c) {
+    if (i2c == NULL) {
+        return DISPLAY_STATUS_NULL_ARG;
+    }
+
+    memset(&display_service, 0, sizeof(display_service));
+    sii1136_t* sii = &display_service.sii1136;
+    sii1136_configure_i2c(sii, i2c, DISPLAY_I2C_TIMEOUT_MS, SII1136_TPI_ADDR_LOW);
+
+    if (sii1136_init_tpi(sii) != SII1136_STATUS_OK) {
+        return DISPLAY_STATUS_I2C_ERR;
+    }
+    uint32_t start = HAL_GetTick();
+    sii1136_tpi_status_t tpi_status = SII1136_TPI_STATUS_I2C_ERR;
+    while (sii1136_tpi_ready(sii, &tpi_status) != SII1136_STATUS_OK ||
+           tpi_status != SII1136_TPI_STATUS_READY) {
+        if (HAL_GetTick() - start > DISPLAY_TPI_READY_TIMEOUT_MS) {
+            return DISPLAY_STATUS_I2C_ERR;
+        }
+    }
+
+    if (sii1136_set_tmds_output_control(sii, SII1136_TMDS_OUT_CNTL_OFF) != SII1136_STATUS_OK ||
+        sii1136_set_hot_plug_int_en(sii, true) != SII1136_STATUS_OK ||
+        sii1136_clear_conn_event_pending(sii) != SII1136_STATUS_OK) {
+        return DISPLAY_STATUS_I2C_ERR;
+    }
+
+    display_service.initialized = true;
+    display_service.poll_tick = HAL_GetTick();
+
+    // A sink that is present at reset has been plugged in for longer than the settle time, so
+    // read its EDID and program a mode now, while the CM7 is still busy with its own setup,
+    // rather than after the first poll plus the settle time. The CM7 gets the usual event.
+    bool hot_plug = false;
+    if (sii1136_get_hot_plug_state(sii, &hot_plug) != SII1136_STATUS_OK) {
+        return DISPLAY_STATUS_I2C_ERR;
+    }
+    if (hot_plug) {
+        display_service.connected = true;
+        display_send_event(DISPLAY_EVENT_CONNECTED, display_configure());
+    }
+    return DISPLAY_STATUS_OK;
+}
+
+bool display_service_handle(const ipc_msg_t* msg) {
+    if (msg == NULL || msg->type != IPC_MSG_DISPLAY_REQUEST) {
+        return false;
+    }
+
+    display_request_t request;
+    memcpy(&request, msg->payload, sizeof(request));
+    display_response_t response = {.seq = request.seq, .op = request.op};
+
+    if (!display_service.initialized) {
+        response.status = DISPLAY_STATUS_I2C_ERR;
+    } else if (!display_service.connected && request.op != DISPLAY_OP_GET_STATE) {
+        response.status = DISPLAY_STATUS_NO_SINK;
+    } else {
+        switch (request.op) {
+            case DISPLAY_OP_GET_STATE:
+                response.status =
+                    display_service.connected ? DISPLAY_STATUS_OK : DISPLAY_STATUS_NO_SINK;
+                break;
+            case DISPLAY_OP_SET_MODE:
+                if (request.timing.pixel_clock_khz == 0) {
+                    video_timing_t mode;
+                    display_status_t status = display_select_mode(&mode);
+                    response.status = display_program_mode(&mode);
+                    response.status =
+                        response.status == DISPLAY_STATUS_OK ? status : response.status;
+                } else if (!display_mode_supported(&request.timing)) {
+                    response.status = DISPLAY_STATUS_MODE_UNSUPPORTED;
+                } else {
+                    response.status = display_program_mode(&request.timing);
+                }
+                break;
+            case DISPLAY_OP_SET_OUTPUT:
+                response.status = display_set_output(request.arg != 0);
+                break;
+            case DISPLAY_OP_RESCAN:
+                response.status = display_configure();
+                break;
+            default:
+                response.status = DISPLAY_STATUS_BAD_REQUEST;
+                break;
+        }
+    }
+    response.mode = display_service.mode;
+    display_send_response(&response);
+    return true;
+}
+
+void display_service_poll(void) {
+    if (!display_service.initialized) {
+        return;
+    }
+    display_flush();
+
+    // The interrupt only says "something changed"; the TPI status register says what.
+    uint32_t now = HAL_GetTick();
+    if (display_service.irq_pending || now - display_service.poll_tick >= DISPLAY_SERVICE_POLL_MS) {
+        display_service.irq_pending = false;
+        display_service.poll_tick = now;
+
+        sii1136_t* sii = &display_service.sii1136;
+        bool event_pending = false;
+        bool hot_plug = false;
+        if (sii1136_get_conn_event_pending(sii, &event_pending) != SII1136_STATUS_OK ||
+            sii1136_get_hot_plug_state(sii, &hot_plug) != SII1136_STATUS_OK) {
+            return;
+        }
+        if (event_pending) {
+            sii1136_clear_conn_event_pending(sii);
+        }
+        if (hot_plug != display_service.connected && !display_service.hpd_pending) {
+            display_service.hpd_pending = true;
+            display_service.hpd_tick = now;
+        }
+    }
+
+    // Act on HPD only once it has been stable for the settle time.
+    if (!display_service.hpd_pending ||
+        now - display_service.hpd_tick < DISPLAY_SERVICE_HPD_SETTLE_MS) {
+        return;
+    }
+    display_service.hpd_pending = false;
+
+    bool hot_plug = false;
+    if (sii1136_get_hot_plug_state(&display_service.sii1136, &hot_plug) != SII1136_STATUS_OK ||
+        hot_plug == display_service.connected) {
+        return;
+    }
+
+    display_service.connected = hot_plug;
+    if (hot_plug) {
+        display_send_event(DISPLAY_EVENT_CONNECTED, display_configure());
+    } else {
+        display_set_output(false);
+        display_service.mode = (video_timing_t){0};
+        display_send_event(DISPLAY_EVENT_DISCONNECTED, DISPLAY_STATUS_NO_SINK);
+    }
+}
+
+void display_service_irq(void) {
+    display_service.irq_pending = true;
+}
+
+#endif
@@ -22,6 +22,9 @@ static const uint8_t EDID_HORIZ_DIMENSION_OFFSET = 0x15;
 static const uint8_t EDID_VERT_DIMENSION_OFFSET = 0x16;
 static const uint8_t EDID_GAMMA_OFFSET = 0x17;
 static const uint8_t EDID_FEAT_SUPPORT_OFFSET = 0x18;
+static const uint8_t EDID_ESTABLISHED_TIMINGS_OFFSET = 0x23;
+static const uint8_t EDID_DETAILED_TIMING_OFFSET = 0x36;
+static const uint8_t EDID_DETAILED_TIMING_SIZE_B = 18;
 
 static const uint16_t EDID_YEAR_ZERO = 1990;
 
@@ -47,7 +50,16 @@ edid_status_t edid_verify(edid_t* edid) {
 
     // Ensure the EDID header is correct.
     static const uint8_t EDID_HEADER[] = {0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
-    if (!memcmp(edid, EDID_HEADER, sizeof(EDID_HEADER))) {
+    if (memcmp(&edid->_data[EDID_HEADER_OFFSET], EDID_HEADER, sizeof(EDID_HEADER)) != 0) {
+        return EDID_STATUS_CORRUPT;
+    }
+
+    // All 128 bytes, including the final checksum byte, must sum to zero.
+    uint8_t sum = 0;
+    for (size_t i = 0; i < EDID_BASIC_SIZE_B; i++) {
+        sum += edid->_data[i];
+    }
+    if (sum != 0) {
         return EDID_STATUS_CORRUPT;
     }
     return EDID_STATUS_OK;
@@ -415,7 +427,83 @@ edid_status_t edid_get_gamma(edid_t* edid, float* gamma) {
     return EDID_STATUS_OK;
 }
 
+edid_status_t edid_get_established_timings(edid_t* edid, uint32_t* timings) {
+    if (edid == NULL || timings == NULL) {
+        return EDID_STATUS_NULL_ARG;
+    } else if (edid->_data == NULL) {
+        return EDID_STATUS_NULL_DATA;
+    }
+
+    // Three bitmap bytes; the first byte ends up in bits 23:16.
+    const uint8_t* data = &edid->_data[EDID_ESTABLISHED_TIMINGS_OFFSET];
+    *timings = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+
+    return EDID_STATUS_OK;
+}
+
+edid_status_t edid_get_detailed_timing(edid_t* edid, uint8_t index, video_timing_t* timing) {
+    if (edid == NULL || timing == NULL) {
+        return EDID_STATUS_NULL_ARG;
+    } else if (edid->_data == NULL) {
+        return EDID_STATUS_NULL_DATA;
+    } else if (index >= EDID_NUM_DETAILED_TIMINGS) {
+        return EDID_STATUS_BAD_FIELD;
+    }
+
+    const uint8_t* data =
+        &edid->_data[EDID_DETAILED_TIMING_OFFSET + index * EDID_DETAILED_TIMING_SIZE_B];
+
+    // Descriptors with a zero pixel clock hold a name, serial number, range limits, etc.
+    uint16_t pixel_clock_10khz = data[0] | (data[1] << 8);
+    if (pixel_clock_10khz == 0) {
+        return EDID_STATUS_OPT_FIELD_BLANK;
+    }
+
+    uint16_t h_blank = data[3] | ((data[4] & 0x0F) << 8);
+    uint16_t v_blank = data[6] | ((data[7] & 0x0F) << 8);
+    timing->pixel_clock_khz = pixel_clock_10khz * 10UL;
+    timing->h_active = data[2] | ((data[4] & 0xF0) << 4);
+    timing->v_active = data[5] | ((data[7] & 0xF0) << 4);
+    timing->h_front_porch = data[8] | ((data[11] & 0xC0) << 2);
+    timing->h_sync = data[9] | ((data[11] & 0x30) << 4);
+    timing->v_front_porch = (data[10] >> 4) | ((data[11] & 0x0C) << 2);
+    timing->v_sync = (data[10] & 0x0F) | ((data[11] & 0x03) << 4);
+    if (timing->h_front_porch + timing->h_sync > h_blank ||
+        timing->v_front_porch + timing->v_sync > v_blank) {
+        return EDID_STATUS_CORRUPT;
+    }
+    timing->h_back_porch = h_blank - timing->h_front_porch - timing->h_sync;
+    timing->v_back_porch = v_blank - timing->v_front_porch - timing->v_sync;
+
+    // Sync polarities are only defined for digital separate sync (bits 4:3 = 11).
+    uint8_t features = data[17];
+    timing->flags = 0;
+    if (features & 0x80) {
+        timing->flags |= VIDEO_TIMING_FLAG_INTERLACED;
+    }
+    if ((features & 0x18) == 0x18) {
+        timing->flags |= (features & 0x04) ? VIDEO_TIMING_FLAG_VSYNC_POS : 0;
+        timing->flags |= (features & 0x02) ? VIDEO_TIMING_FLAG_HSYNC_POS : 0;
+    }
+
+    return EDID_STATUS_OK;
+}
+
+#if defined(EDID_TEST_MAIN)
+
+uint8_t edid_buf[EDID_BASIC_SIZE_B] = {
+    0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x10, 0xac, 0x34, 0x12, 0x66, 0x2e, 0x4b, 0x42,
+    0x0e, 0x14, 0x01, 0x03, 0x80, 0x33, 0x1d, 0x78, 0x2a, 0x81, 0xf1, 0xa3, 0x57, 0x53, 0x9f, 0x27,
+    0x0a, 0x50, 0x54, 0xbf, 0xef, 0x80, 0x81, 0x00, 0x95, 0x00, 0xb3, 0x00, 0x81, 0x40, 0x71, 0x4f,
+    0x81, 0x80, 0xa9, 0x40, 0x95, 0x0f, 0x02, 0x3a, 0x80, 0x18, 0x71, 0x38, 0x2d, 0x40, 0x58, 0x2c,
+    0x45, 0x00, 0xfe, 0x1f, 0x11, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x38, 0x4b, 0x1e,
+    0x51, 0x11, 0x00, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0xfc, 0x00, 0x53,
+    0x4d, 0x58, 0x4c, 0x32, 0x33, 0x37, 0x30, 0x48, 0x44, 0x0a, 0x20, 0x20, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x48, 0x31, 0x41, 0x4b, 0x35, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0a, 0x20, 0x20, 0x00, 0xa1};
+
 int main() {
     edid_t my_edid;
     edid_init(&my_edid, edid_buf);
 }
+
+#endif
@@ -0,0 +1,124 @@
+#include "fence.h"
+
+#include "hsem_ids.h"
+#include "hsem_notify.h"
+#include "stm32h7xx_hal.h"
+#include "timebase.h"
+#include "trace.h"
+
+#include <stddef.h>
+
+// Only has to end the waiter's WFE.
+static void fence_doorbell(uint32_t sem_id, void* user) {
+    (void)sem_id;
+    (void)user;
+}
+
+fence_status_t fence_init(fence_t* fence, uint32_t sem_id) {
+    if (fence == NULL) {
+        return FENCE_STATUS_NULL_ARG;
+    } else if (sem_id != FENCE_NO_DOORBELL && sem_id >= HSEM_ID_COUNT) {
+        return FENCE_STATUS_BAD_ID;
+    }
+
+    fence->value = 0;
+    fence->signals = 0;
+    fence->sem_id = sem_id;
+    __DMB();
+    return FENCE_STATUS_OK;
+}
+
+fence_status_t fence_attach(const fence_t* fence) {
+    if (fence == NULL) {
+        return FENCE_STATUS_NULL_ARG;
+    } else if (fence->sem_id == FENCE_NO_DOORBELL) {
+        return FENCE_STATUS_OK;
+    }
+    return hsem_notify_register(fence->sem_id, fence_doorbell, NULL) == HSEM_NOTIFY_STATUS_OK
+               ? FENCE_STATUS_OK
+               : FENCE_STATUS_BAD_ID;
+}
+
+fence_status_t fence_signal(fence_t* fence, uint32_t value) {
+    if (fence == NULL) {
+        return FENCE_STATUS_NULL_ARG;
+    } else if (fence_value_before(value, fence->value)) {
+        return FENCE_STATUS_BAD_VALUE;
+    }
+
+    // The producer's data, then the timestamp, then the value: a waiter that sees the value also
+    // sees the rest.
+    uint32_t n = fence->signals;
+    __DMB();
+    fence->history[n % FENCE_HISTORY] = (fence_point_t){value, timebase_now_us()};
+    __DMB();
+    fence->signals = n + 1;
+    fence->value = value;
+    if (fence->sem_id != FENCE_NO_DOORBELL) {
+        // BUSY means the other core is mid-release of the same doorbell, which wakes it anyway.
+        hsem_notify_signal(fence->sem_id);
+    }
+    return FENCE_STATUS_OK;
+}
+
+fence_status_t fence_wait(const fence_t* fence, uint32_t value, uint32_t timeout_us) {
+    if (fence == NULL) {
+        return FENCE_STATUS_NULL_ARG;
+    }
+
+    // Any interrupt ends the WFE, SysTick included, so the timeout is checked at least every tick
+    // even if the doorbell never comes.
+    if (fence_reached(fence, value)) {
+        __DMB();
+        return FENCE_STATUS_OK;
+    }
+
+    TRACE_BEGIN(TRACE_EVENT_FENCE_WAIT, value);
+    fence_status_t status = FENCE_STATUS_OK;
+    uint32_t start = timebase_now_us();
+    while (!fence_reached(fence, value)) {
+        if (timeout_us != FENCE_WAIT_FOREVER && timebase_elapsed_us(start) >= timeout_us) {
+            status = FENCE_STATUS_TIMEOUT;
+            break;
+        }
+        __WFE();
+    }
+    __DMB();
+    TRACE_END(TRACE_EVENT_FENCE_WAIT, value);
+    return status;
+}
+
+fence_status_t fence_timestamp(const fence_t* fence, uint32_t value, uint32_t* time_us) {
+    if (fence == NULL || time_us == NULL) {
+        return FENCE_STATUS_NULL_ARG;
+    } else if (!fence_reached(fence, value)) {
+        return FENCE_STATUS_PENDING;
+    }
+
+    // Walk back from the newest signal to the first one that reached value. The slot the next
+    // signal will write is skipped, and the count is re-read afterwards to catch overwrites.
+    uint32_t signals = fence->signals;
+    __DMB();
+    uint32_t found_us = 0;
+    uint32_t found_n = 0;
+    bool found = false;
+    bool complete = false;
+    for (uint32_t k = 1; k < FENCE_HISTORY && k <= signals; k++) {
+        uint32_t n = signals - k;
+        fence_point_t point = fence->history[n % FENCE_HISTORY];
+        if (fence_value_before(point.value, value)) {
+            complete = true;
+            break;
+        }
+        found = true;
+        found_n = n;
+        found_us = point.time_us;
+    }
+    complete = complete || (found && found_n == 0);
+    __DMB();
+    if (!found || !complete || fence->signals - found_n >= FENCE_HISTORY) {
+        return FENCE_STATUS_EXPIRED;
+    }
+    *time_us = found_us;
+    return FENCE_STATUS_OK;
+}
@@ -0,0 +1,170 @@
+#include "hsem_lock.h"
+
+#include "cycles.h"
+#include "hsem_notify.h"
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+#include "trace.h"
+
+#include <stddef.h>
+
+// When this core took each lock it holds; only ever touched by the holder.
+static uint32_t hsem_lock_taken_cycles[HSEM_ID_COUNT];
+
+static inline hsem_lock_stats_t* hsem_lock_stats(uint32_t sem_id) {
+    return &shared_mem.hsem_lock.stats[sem_id][CORE_ID_SELF];
+}
+
+// The free notification only has to end the waiter's WFE.
+static void hsem_lock_wake(uint32_t sem_id, void* user) {
+    (void)sem_id;
+    (void)user;
+}
+
+static void hsem_lock_acquired(uint32_t sem_id, uint32_t wait_cycles, bool contended) {
+    __DMB();
+    hsem_lock_stats_t* stats = hsem_lock_stats(sem_id);
+    stats->acquires++;
+    if (contended) {
+        stats->contended++;
+        stats->max_wait_cycles =
+            wait_cycles > stats->max_wait_cycles ? wait_cycles : stats->max_wait_cycles;
+    }
+    hsem_lock_taken_cycles[sem_id] = cycles_now();
+}
+
+// Takes sem_id without touching the statistics.
+static void hsem_lock_take(uint32_t sem_id, uint32_t* wait_cycles, bool* contended) {
+    uint32_t start = cycles_now();
+    *contended = false;
+    for (uint32_t i = 0; i < HSEM_LOCK_SPIN_TRIES; i++) {
+        if (HAL_HSEM_FastTake(sem_id) == HAL_OK) {
+            *wait_cycles = cycles_now() - start;
+            *contended = i != 0;
+            return;
+        }
+    }
+
+    // Arm the free notification before the final attempts, so a release in between still ends
+    // the WFE. SysTick bounds the sleep even if it somehow does not.
+    *contended = true;
+    TRACE_BEGIN(TRACE_EVENT_LOCK_WAIT, sem_id);
+    hsem_notify_register(sem_id, hsem_lock_wake, NULL);
+    while (HAL_HSEM_FastTake(sem_id) != HAL_OK) {
+        __WFE();
+    }
+    hsem_notify_register(sem_id, NULL, NULL);
+    TRACE_END(TRACE_EVENT_LOCK_WAIT, sem_id);
+    *wait_cycles = cycles_now() - start;
+}
+
+void hsem_lock_init(void) {
+    cycles_init();
+    for (uint32_t sem_id = 0; sem_id < HSEM_ID_COUNT; sem_id++) {
+        hsem_lock_stats(sem_id)->cycles_per_s = cycles_per_second();
+    }
+}
+
+/***** MUTEX *****/
+
+hsem_lock_status_t hsem_mutex_lock(uint32_t sem_id) {
+    if (sem_id >= HSEM_ID_COUNT) {
+        return HSEM_LOCK_STATUS_BAD_ID;
+    }
+    uint32_t wait_cycles;
+    bool contended;
+    hsem_lock_take(sem_id, &wait_cycles, &contended);
+    hsem_lock_acquired(sem_id, wait_cycles, contended);
+    return HSEM_LOCK_STATUS_OK;
+}
+
+hsem_lock_status_t hsem_mutex_trylock(uint32_t sem_id) {
+    if (sem_id >= HSEM_ID_COUNT) {
+        return HSEM_LOCK_STATUS_BAD_ID;
+    } else if (HAL_HSEM_FastTake(sem_id) != HAL_OK) {
+        hsem_lock_stats(sem_id)->try_failures++;
+        return HSEM_LOCK_STATUS_BUSY;
+    }
+    hsem_lock_acquired(sem_id, 0, false);
+    return HSEM_LOCK_STATUS_OK;
+}
+
+void hsem_mutex_unlock(uint32_t sem_id) {
+    if (sem_id >= HSEM_ID_COUNT) {
+        return;
+    }
+    hsem_lock_stats_t* stats = hsem_lock_stats(sem_id);
+    uint32_t hold_cycles = cycles_now() - hsem_lock_taken_cycles[sem_id];
+    stats->max_hold_cycles =
+        hold_cycles > stats->max_hold_cycles ? hold_cycles : stats->max_hold_cycles;
+
+    // Everything written under the lock before the other core can take it.
+    __DMB();
+    HAL_HSEM_Release(sem_id, 0);
+}
+
+/***** READER/WRITER *****/
+
+hsem_lock_status_t hsem_rwlock_init(hsem_rwlock_t* lock, uint32_t sem_id) {
+    if (lock == NULL || sem_id >= HSEM_ID_COUNT) {
+        return HSEM_LOCK_STATUS_BAD_ID;
+    }
+    lock->readers = 0;
+    lock->sem_id = sem_id;
+    __DMB();
+    return HSEM_LOCK_STATUS_OK;
+}
+
+void hsem_rwlock_read_lock(hsem_rwlock_t* lock) {
+    hsem_mutex_lock(lock->sem_id);
+    lock->readers++;
+    hsem_mutex_unlock(lock->sem_id);
+}
+
+void hsem_rwlock_read_unlock(hsem_rwlock_t* lock) {
+    hsem_mutex_lock(lock->sem_id);
+    lock->readers--;
+    hsem_mutex_unlock(lock->sem_id);
+}
+
+void hsem_rwlock_write_lock(hsem_rwlock_t* lock) {
+    uint32_t start = cycles_now();
+    uint32_t wait_cycles;
+    bool contended;
+    hsem_lock_take(lock->sem_id, &wait_cycles, &contended);
+    // Every reader takes and frees the semaphore on its way out; arming the free notification
+    // only after our own release keeps that release from waking us straight back up.
+    while (lock->readers != 0) {
+        contended = true;
+        __DMB();
+        HAL_HSEM_Release(lock->sem_id, 0);
+        hsem_notify_register(lock->sem_id, hsem_lock_wake, NULL);
+        if (lock->readers != 0) {
+            __WFE();
+        }
+        hsem_notify_register(lock->sem_id, NULL, NULL);
+        bool ignored;
+        hsem_lock_take(lock->sem_id, &wait_cycles, &ignored);
+    }
+    hsem_lock_acquired(lock->sem_id, cycles_now() - start, contended);
+}
+
+hsem_lock_status_t hsem_rwlock_write_trylock(hsem_rwlock_t* lock) {
+    hsem_lock_status_t status = hsem_mutex_trylock(lock->sem_id);
+    if (status == HSEM_LOCK_STATUS_OK && lock->readers != 0) {
+        hsem_mutex_unlock(lock->sem_id);
+        hsem_lock_stats(lock->sem_id)->try_failures++;
+        return HSEM_LOCK_STATUS_BUSY;
+    }
+    return status;
+}
+
+void hsem_rwlock_write_unlock(hsem_rwlock_t* lock) {
+    hsem_mutex_unlock(lock->sem_id);
+}
+
+void hsem_lock_get_stats(uint32_t sem_id, core_id_t core, hsem_lock_stats_t* stats) {
+    if (stats != NULL && sem_id < HSEM_ID_COUNT && core < CORE_ID_COUNT) {
+        *stats = shared_mem.hsem_lock.stats[sem_id][core];
+    }
+}
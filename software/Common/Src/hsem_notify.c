@@ -0,0 +1,76 @@
+#include "hsem_notify.h"
+
+#include "hsem_ids.h"
+#include "stm32h7xx_hal.h"
+
+#include <stddef.h>
+
+#if defined(CORE_CM7)
+#define HSEM_NOTIFY_IRQN HSEM1_IRQn
+#else
+#define HSEM_NOTIFY_IRQN HSEM2_IRQn
+#endif
+
+#define HSEM_NOTIFY_IRQ_PRIORITY 5
+
+// Doorbells are never held across an interrupt, so a fixed process ID is enough.
+#define HSEM_NOTIFY_PROCESS_ID 0U
+
+typedef struct {
+    hsem_notify_callback_t callback;
+    void* user;
+} hsem_notify_entry_t;
+
+static hsem_notify_entry_t hsem_notify_entries[HSEM_ID_COUNT];
+
+void hsem_notify_init(void) {
+    HAL_NVIC_SetPriority(HSEM_NOTIFY_IRQN, HSEM_NOTIFY_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(HSEM_NOTIFY_IRQN);
+}
+
+hsem_notify_status_t hsem_notify_register(uint32_t sem_id, hsem_notify_callback_t callback,
+                                          void* user) {
+    if (sem_id >= HSEM_ID_COUNT) {
+        return HSEM_NOTIFY_STATUS_BAD_ID;
+    }
+
+    uint32_t mask = __HAL_HSEM_SEMID_TO_MASK(sem_id);
+    HAL_HSEM_DeactivateNotification(mask);
+    hsem_notify_entries[sem_id].callback = callback;
+    hsem_notify_entries[sem_id].user = user;
+    if (callback != NULL) {
+        __HAL_HSEM_CLEAR_FLAG(mask);
+        HAL_HSEM_ActivateNotification(mask);
+    }
+    return HSEM_NOTIFY_STATUS_OK;
+}
+
+hsem_notify_status_t hsem_notify_signal(uint32_t sem_id) {
+    if (sem_id >= HSEM_ID_COUNT) {
+        return HSEM_NOTIFY_STATUS_BAD_ID;
+    }
+
+    // Anything the receiver will read must be visible before it can observe the release.
+    __DMB();
+    if (HAL_HSEM_FastTake(sem_id) != HAL_OK) {
+        return HSEM_NOTIFY_STATUS_BUSY;
+    }
+    HAL_HSEM_Release(sem_id, HSEM_NOTIFY_PROCESS_ID);
+    return HSEM_NOTIFY_STATUS_OK;
+}
+
+// Called by HAL_HSEM_IRQHandler() with the IDs that were freed; their interrupts are already
+// masked and their flags cleared.
+void HAL_HSEM_FreeCallback(uint32_t SemMask) {
+    for (uint32_t sem_id = 0; SemMask != 0; sem_id++, SemMask >>= 1) {
+        if ((SemMask & 1U) == 0) {
+            continue;
+        }
+        hsem_notify_entry_t* entry = &hsem_notify_entries[sem_id];
+        if (entry->callback == NULL) {
+            continue;
+        }
+        HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(sem_id));
+        entry->callback(sem_id, entry->user);
+    }
+}
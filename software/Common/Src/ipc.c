@@ -0,0 +1,114 @@
+#include "ipc.h"
+
+#include "hsem_ids.h"
+#include "hsem_notify.h"
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+#include "trace.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(CORE_CM7)
+#define IPC_TX_RING (&shared_mem.ipc.to_cm4)
+#define IPC_RX_RING (&shared_mem.ipc.to_cm7)
+#define IPC_TX_DOORBELL HSEM_ID_IPC_TO_CM4
+#define IPC_RX_DOORBELL HSEM_ID_IPC_TO_CM7
+#else
+#define IPC_TX_RING (&shared_mem.ipc.to_cm7)
+#define IPC_RX_RING (&shared_mem.ipc.to_cm4)
+#define IPC_TX_DOORBELL HSEM_ID_IPC_TO_CM7
+#define IPC_RX_DOORBELL HSEM_ID_IPC_TO_CM4
+#endif
+
+static ipc_stats_t ipc_stats;
+
+// Nothing to do beyond counting: taking the interrupt is what wakes ipc_recv_wait() from WFE.
+static void ipc_doorbell(uint32_t sem_id, void* user) {
+    (void)sem_id;
+    (void)user;
+    ipc_stats.doorbells_received++;
+}
+
+void ipc_init(void) {
+    hsem_notify_init();
+    hsem_notify_register(IPC_RX_DOORBELL, ipc_doorbell, NULL);
+}
+
+ipc_status_t ipc_send(uint16_t type, const void* payload, uint16_t len) {
+    if (payload == NULL && len != 0) {
+        return IPC_STATUS_NULL_ARG;
+    } else if (len > IPC_PAYLOAD_SIZE_B) {
+        return IPC_STATUS_TOO_LONG;
+    }
+
+    ipc_ring_t* ring = IPC_TX_RING;
+    uint32_t head = ring->head;
+    if (head - ring->tail >= IPC_RING_SLOTS) {
+        ipc_stats.full++;
+        return IPC_STATUS_FULL;
+    }
+
+    ipc_msg_t* slot = &ring->slots[head % IPC_RING_SLOTS];
+    slot->type = type;
+    slot->len = len;
+    if (len != 0) {
+        memcpy(slot->payload, payload, len);
+    }
+
+    // Slot contents before the index that publishes them, and the index before re-reading the
+    // consumer's tail. The consumer does the mirror image (tail store, barrier, head load), so at
+    // least one side always sees the other's update and a wake-up can never be lost.
+    __DMB();
+    ring->head = head + 1;
+    __DMB();
+    ipc_stats.sent++;
+    TRACE_INSTANT(TRACE_EVENT_IPC_SEND, type);
+
+    if (ring->tail == head && hsem_notify_signal(IPC_TX_DOORBELL) == HSEM_NOTIFY_STATUS_OK) {
+        ipc_stats.doorbells_sent++;
+    }
+    return IPC_STATUS_OK;
+}
+
+ipc_status_t ipc_recv(ipc_msg_t* msg) {
+    if (msg == NULL) {
+        return IPC_STATUS_NULL_ARG;
+    }
+
+    ipc_ring_t* ring = IPC_RX_RING;
+    uint32_t tail = ring->tail;
+    if (ring->head == tail) {
+        return IPC_STATUS_EMPTY;
+    }
+
+    // Head load before the slot contents, and the copy out before handing the slot back.
+    __DMB();
+    *msg = ring->slots[tail % IPC_RING_SLOTS];
+    __DMB();
+    ring->tail = tail + 1;
+    __DMB();
+    ipc_stats.received++;
+    return IPC_STATUS_OK;
+}
+
+ipc_status_t ipc_recv_wait(ipc_msg_t* msg, uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    for (;;) {
+        ipc_status_t status = ipc_recv(msg);
+        if (status != IPC_STATUS_EMPTY) {
+            return status;
+        }
+        if (timeout_ms != IPC_WAIT_FOREVER && HAL_GetTick() - start >= timeout_ms) {
+            return IPC_STATUS_TIMEOUT;
+        }
+        // Either the doorbell or the next SysTick ends the sleep.
+        __WFE();
+    }
+}
+
+void ipc_get_stats(ipc_stats_t* stats) {
+    if (stats != NULL) {
+        *stats = ipc_stats;
+    }
+}
@@ -0,0 +1,96 @@
+#include "ipc_bench.h"
+
+#include "cycles.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define IPC_BENCH_TIMEOUT_MS 100
+
+#if defined(CORE_CM7)
+
+// Waits for a specific reply, dropping anything else that arrives meanwhile.
+static ipc_status_t ipc_bench_wait_for(ipc_msg_t* msg, uint16_t type) {
+    for (;;) {
+        ipc_status_t status = ipc_recv_wait(msg, IPC_BENCH_TIMEOUT_MS);
+        if (status != IPC_STATUS_OK || msg->type == type) {
+            return status;
+        }
+    }
+}
+
+ipc_status_t ipc_bench_run(ipc_bench_result_t* result) {
+    if (result == NULL) {
+        return IPC_STATUS_NULL_ARG;
+    }
+    *result = (ipc_bench_result_t){0};
+    result->round_trip_min_cycles = UINT32_MAX;
+    cycles_init();
+
+    // Latency: one message in flight at a time, so every hop goes through an empty ring and pays
+    // for a doorbell interrupt on the way there and back.
+    uint64_t total_cycles = 0;
+    ipc_msg_t msg;
+    for (uint32_t i = 0; i < IPC_BENCH_ROUND_TRIPS; i++) {
+        uint32_t start = cycles_now();
+        ipc_status_t status = ipc_send(IPC_MSG_BENCH_PING, &start, sizeof(start));
+        if (status != IPC_STATUS_OK) {
+            return status;
+        }
+        status = ipc_bench_wait_for(&msg, IPC_MSG_BENCH_PONG);
+        if (status != IPC_STATUS_OK) {
+            return status;
+        }
+        uint32_t elapsed = cycles_now() - start;
+        total_cycles += elapsed;
+        result->round_trip_min_cycles =
+            elapsed < result->round_trip_min_cycles ? elapsed : result->round_trip_min_cycles;
+        result->round_trip_max_cycles =
+            elapsed > result->round_trip_max_cycles ? elapsed : result->round_trip_max_cycles;
+    }
+    result->round_trip_avg_cycles = (uint32_t)(total_cycles / IPC_BENCH_ROUND_TRIPS);
+
+    // Throughput: keep the ring as full as possible. A full ring just means the CM4 is behind.
+    uint32_t start = cycles_now();
+    for (uint32_t i = 0; i < IPC_BENCH_BULK_MESSAGES;) {
+        if (ipc_send(IPC_MSG_BENCH_BULK, &i, sizeof(i)) == IPC_STATUS_OK) {
+            i++;
+        }
+    }
+    while (ipc_send(IPC_MSG_BENCH_BULK_DONE, NULL, 0) == IPC_STATUS_FULL) {
+    }
+    ipc_status_t status = ipc_bench_wait_for(&msg, IPC_MSG_BENCH_BULK_DONE);
+    if (status != IPC_STATUS_OK) {
+        return status;
+    }
+    result->bulk_cycles = cycles_now() - start;
+    memcpy(&result->bulk_messages, msg.payload, sizeof(result->bulk_messages));
+    result->bulk_messages_per_s =
+        (uint32_t)((uint64_t)result->bulk_messages * cycles_per_second() / result->bulk_cycles);
+    return IPC_STATUS_OK;
+}
+
+#endif
+
+bool ipc_bench_handle(const ipc_msg_t* msg) {
+    static uint32_t bulk_received;
+
+    switch (msg->type) {
+        case IPC_MSG_BENCH_PING:
+            // Echo the sender's timestamp straight back.
+            while (ipc_send(IPC_MSG_BENCH_PONG, msg->payload, msg->len) == IPC_STATUS_FULL) {
+            }
+            return true;
+        case IPC_MSG_BENCH_BULK:
+            bulk_received++;
+            return true;
+        case IPC_MSG_BENCH_BULK_DONE:
+            while (ipc_send(IPC_MSG_BENCH_BULK_DONE, &bulk_received, sizeof(bulk_received)) ==
+                   IPC_STATUS_FULL) {
+            }
+            bulk_received = 0;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,108 @@
+#include "mem_attr.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(CORE_CM7)
+#include "stm32h7xx_hal.h"
+#endif
+
+typedef struct {
+    uint8_t number;
+    uint32_t base;
+    uint32_t size;
+    mem_attr_policy_t policy;
+} mem_attr_region_t;
+
+// Reject malformed regions at compile time rather than with a MemManage fault at boot.
+#define MEM_ATTR_CHECK_REGION(num, base, size, policy)                                  \
+    _Static_assert((num) < 16, "MPU region number out of range");                      \
+    _Static_assert((size) >= 32 && ((size) & ((size)-1)) == 0,                         \
+                   "MPU region size must be a power of two of at least 32 bytes");     \
+    _Static_assert(((base) & ((size)-1)) == 0, "MPU region base must be size-aligned");
+MEM_ATTR_REGIONS(MEM_ATTR_CHECK_REGION)
+
+#define MEM_ATTR_TABLE_ENTRY(num, base, size, policy) {(num), (base), (size), (policy)},
+static const mem_attr_region_t MEM_ATTR_TABLE[] = {MEM_ATTR_REGIONS(MEM_ATTR_TABLE_ENTRY)};
+
+#define MEM_ATTR_REGION_COUNT (sizeof(MEM_ATTR_TABLE) / sizeof(MEM_ATTR_TABLE[0]))
+
+#if defined(CORE_CM7)
+
+static void mem_attr_config_region(const mem_attr_region_t* entry) {
+    MPU_Region_InitTypeDef region = {0};
+    region.Enable = MPU_REGION_ENABLE;
+    region.Number = entry->number;
+    region.BaseAddress = entry->base;
+    // The MPU encodes a region of 2^(n+1) bytes as n.
+    region.Size = (uint8_t)(__builtin_ctz(entry->size) - 1);
+    region.SubRegionDisable = 0x00;
+    region.AccessPermission = MPU_REGION_FULL_ACCESS;
+    region.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    region.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+
+    switch (entry->policy) {
+        case MEM_ATTR_NO_ACCESS:
+            region.TypeExtField = MPU_TEX_LEVEL0;
+            region.AccessPermission = MPU_REGION_NO_ACCESS;
+            region.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+            region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+            region.IsShareable = MPU_ACCESS_SHAREABLE;
+            break;
+        case MEM_ATTR_WRITE_BACK:
+            region.TypeExtField = MPU_TEX_LEVEL1;
+            region.IsCacheable = MPU_ACCESS_CACHEABLE;
+            region.IsBufferable = MPU_ACCESS_BUFFERABLE;
+            break;
+        case MEM_ATTR_WRITE_THROUGH:
+            region.TypeExtField = MPU_TEX_LEVEL0;
+            region.IsCacheable = MPU_ACCESS_CACHEABLE;
+            region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+            break;
+        case MEM_ATTR_UNCACHED:
+            region.TypeExtField = MPU_TEX_LEVEL1;
+            region.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+            region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+            break;
+        case MEM_ATTR_UNCACHED_SHARED:
+            region.TypeExtField = MPU_TEX_LEVEL1;
+            region.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+            region.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+            region.IsShareable = MPU_ACCESS_SHAREABLE;
+            break;
+    }
+
+    HAL_MPU_ConfigRegion(&region);
+}
+
+#endif
+
+void mem_attr_init(void) {
+#if defined(CORE_CM7)
+    // Disable FMC bank 1 (enabled after reset). Otherwise CPU speculative reads of this bank block
+    // the FMC for 24 us at a time, starving the LTDC. The no-access MPU region backs this up.
+    FMC_Bank1_R->BTCR[0] = 0x000030D2;
+
+    HAL_MPU_Disable();
+    for (size_t i = 0; i < MEM_ATTR_REGION_COUNT; i++) {
+        mem_attr_config_region(&MEM_ATTR_TABLE[i]);
+    }
+    // Anything not covered above keeps the default memory map.
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+    SCB_EnableICache();
+    SCB_EnableDCache();
+#endif
+}
+
+mem_attr_policy_t mem_attr_get_policy(uintptr_t addr) {
+    // Walk backwards since higher region numbers win on overlap.
+    for (size_t i = MEM_ATTR_REGION_COUNT; i-- > 0;) {
+        const mem_attr_region_t* entry = &MEM_ATTR_TABLE[i];
+        if (addr >= entry->base && addr - entry->base < entry->size) {
+            return entry->policy;
+        }
+    }
+    // The default map makes internal SRAM write-back; TCMs are never cached and need no care.
+    return MEM_ATTR_WRITE_BACK;
+}
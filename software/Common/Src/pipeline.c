@@ -0,0 +1,461 @@
+#include "pipeline.h"
+
+#include "blit.h"
+#include "cache_maint.h"
+#include "cycles.h"
+#include "fast_mem.h"
+#include "fence.h"
+#include "hsem_ids.h"
+#include "mem_attr.h"
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+#include "timebase.h"
+#include "trace.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+static rect_t pipeline_tile_rect(uint32_t tile) {
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    int16_t x0 = (int16_t)((tile % ps->config.cols) * ps->config.tile_w);
+    int16_t y0 = (int16_t)((tile / ps->config.cols) * ps->config.tile_h);
+    rect_t rect = {x0, y0, (int16_t)(x0 + ps->config.tile_w), (int16_t)(y0 + ps->config.tile_h)};
+    rect_t viewport = {0, 0, (int16_t)ps->config.width, (int16_t)ps->config.height};
+    return rect_intersect(&rect, &viewport);
+}
+
+#if defined(CORE_CM4)
+
+/***** GEOMETRY *****/
+
+// Enough for a triangle clipped against all four guard-band edges.
+#define PIPELINE_CLIP_MAX_VERTS 7
+
+struct pipeline_builder {
+    pipeline_list_t* list;
+    pipeline_core_stats_t* stats;
+    uint32_t bin_entries;
+    rect_t tiles[PIPELINE_MAX_TRIS];  // Tile-space bounds of each triangle, half-open.
+    uint16_t cursor[PIPELINE_MAX_TILES];
+};
+
+static pipeline_builder_t pipeline_builder;
+static pipeline_scene_fn_t pipeline_scene;
+static void* pipeline_scene_user;
+static uint32_t pipeline_next_frame = 1;
+
+static inline float pipeline_cross(pipeline_vec2_t a, pipeline_vec2_t b, pipeline_vec2_t c) {
+    return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+}
+
+// Snaps a screen-space triangle to the sub-pixel grid and bins it.
+static void pipeline_emit(pipeline_builder_t* builder, pipeline_vec2_t v0, pipeline_vec2_t v1,
+                          pipeline_vec2_t v2, uint32_t argb) {
+    pipeline_list_t* list = builder->list;
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+
+    raster_tri_t tri = {
+        {(int32_t)lrintf(v0.x * RASTER_SUBPIXEL_ONE), (int32_t)lrintf(v1.x * RASTER_SUBPIXEL_ONE),
+         (int32_t)lrintf(v2.x * RASTER_SUBPIXEL_ONE)},
+        {(int32_t)lrintf(v0.y * RASTER_SUBPIXEL_ONE), (int32_t)lrintf(v1.y * RASTER_SUBPIXEL_ONE),
+         (int32_t)lrintf(v2.y * RASTER_SUBPIXEL_ONE)},
+        argb};
+    // Snapping can collapse a sliver.
+    if (raster_tri_area2(&tri) <= 0) {
+        return;
+    }
+
+    rect_t bounds = raster_tri_bounds(&tri);
+    rect_t viewport = {0, 0, (int16_t)ps->config.width, (int16_t)ps->config.height};
+    bounds = rect_intersect(&bounds, &viewport);
+    if (rect_is_empty(&bounds)) {
+        return;
+    }
+    rect_t tiles = {
+        (int16_t)(bounds.x0 / ps->config.tile_w), (int16_t)(bounds.y0 / ps->config.tile_h),
+        (int16_t)((bounds.x1 - 1) / ps->config.tile_w + 1),
+        (int16_t)((bounds.y1 - 1) / ps->config.tile_h + 1)};
+
+    uint32_t entries = rect_area(&tiles);
+    if (list->num_tris == PIPELINE_MAX_TRIS ||
+        builder->bin_entries + entries > PIPELINE_MAX_BIN_ENTRIES) {
+        builder->stats->dropped++;
+        return;
+    }
+
+    // Count now; offsets become a prefix sum once the frame is complete.
+    for (int16_t ty = tiles.y0; ty < tiles.y1; ty++) {
+        for (int16_t tx = tiles.x0; tx < tiles.x1; tx++) {
+            list->tile_offsets[ty * ps->config.cols + tx + 1]++;
+        }
+    }
+    builder->tiles[list->num_tris] = tiles;
+    builder->bin_entries += entries;
+    list->tris[list->num_tris++] = tri;
+    builder->stats->tris_out++;
+}
+
+// Sutherland-Hodgman against one guard-band edge: keeps the side where sign * (p.axis - limit) >= 0.
+static uint32_t pipeline_clip_edge(const pipeline_vec2_t* in, uint32_t count, pipeline_vec2_t* out,
+                                   bool axis_y, float limit, float sign) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        pipeline_vec2_t a = in[i];
+        pipeline_vec2_t b = in[(i + 1) % count];
+        float da = sign * ((axis_y ? a.y : a.x) - limit);
+        float db = sign * ((axis_y ? b.y : b.x) - limit);
+        if (da >= 0) {
+            out[n++] = a;
+        }
+        if ((da >= 0) != (db >= 0)) {
+            float t = da / (da - db);
+            out[n++] = (pipeline_vec2_t){a.x + t * (b.x - a.x), a.y + t * (b.y - a.y)};
+        }
+    }
+    return n;
+}
+
+static void pipeline_clip_and_emit(pipeline_builder_t* builder, pipeline_vec2_t v0,
+                                   pipeline_vec2_t v1, pipeline_vec2_t v2, uint32_t argb) {
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    float x_min = fminf(v0.x, fminf(v1.x, v2.x));
+    float x_max = fmaxf(v0.x, fmaxf(v1.x, v2.x));
+    float y_min = fminf(v0.y, fminf(v1.y, v2.y));
+    float y_max = fmaxf(v0.y, fmaxf(v1.y, v2.y));
+
+    // Trivially outside the viewport.
+    if (x_max < 0 || y_max < 0 || x_min >= ps->config.width || y_min >= ps->config.height) {
+        return;
+    }
+
+    // Most triangles fit inside the guard band; the rasterizer clips those to the tile itself.
+    const float g = PIPELINE_GUARD_BAND_PX;
+    if (x_min >= -g && y_min >= -g && x_max <= ps->config.width + g &&
+        y_max <= ps->config.height + g) {
+        pipeline_emit(builder, v0, v1, v2, argb);
+        return;
+    }
+
+    pipeline_vec2_t a[PIPELINE_CLIP_MAX_VERTS] = {v0, v1, v2};
+    pipeline_vec2_t b[PIPELINE_CLIP_MAX_VERTS];
+    uint32_t n = 3;
+    n = pipeline_clip_edge(a, n, b, false, -g, 1.0f);
+    n = pipeline_clip_edge(b, n, a, false, ps->config.width + g, -1.0f);
+    n = pipeline_clip_edge(a, n, b, true, -g, 1.0f);
+    n = pipeline_clip_edge(b, n, a, true, ps->config.height + g, -1.0f);
+
+    // The clipped polygon is convex and keeps the winding, so a fan covers it.
+    for (uint32_t i = 1; i + 1 < n; i++) {
+        pipeline_emit(builder, a[0], a[i], a[i + 1], argb);
+    }
+}
+
+void pipeline_set_scene(pipeline_scene_fn_t scene, void* user) {
+    pipeline_scene = scene;
+    pipeline_scene_user = user;
+}
+
+void pipeline_submit(pipeline_builder_t* builder, const pipeline_vec2_t* verts,
+                     const uint16_t* indices, uint16_t num_tris,
+                     const pipeline_transform_t* transform, uint32_t argb, bool cull_backfaces) {
+    if (builder == NULL || verts == NULL || indices == NULL || transform == NULL) {
+        return;
+    }
+
+    const float* m = transform->m;
+    for (uint16_t t = 0; t < num_tris; t++) {
+        pipeline_vec2_t v[3];
+        for (uint32_t i = 0; i < 3; i++) {
+            pipeline_vec2_t p = verts[indices[t * 3 + i]];
+            v[i].x = m[0] * p.x + m[1] * p.y + m[2];
+            v[i].y = m[3] * p.x + m[4] * p.y + m[5];
+        }
+        builder->stats->tris_in++;
+
+        float area = pipeline_cross(v[0], v[1], v[2]);
+        if (area == 0 || (area < 0 && cull_backfaces)) {
+            continue;
+        } else if (area < 0) {
+            pipeline_vec2_t tmp = v[1];
+            v[1] = v[2];
+            v[2] = tmp;
+        }
+        pipeline_clip_and_emit(builder, v[0], v[1], v[2], argb);
+    }
+}
+
+static void pipeline_build(uint32_t frame) {
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    pipeline_builder_t* builder = &pipeline_builder;
+    pipeline_list_t* list = ps->config.lists[frame % PIPELINE_NUM_LISTS];
+    pipeline_core_stats_t* stats = &ps->stats[CORE_ID_SELF];
+    uint32_t start = cycles_now();
+    TRACE_BEGIN(TRACE_EVENT_GEOMETRY, frame);
+
+    uint32_t num_tiles = (uint32_t)ps->config.cols * ps->config.rows;
+    builder->list = list;
+    builder->stats = stats;
+    builder->bin_entries = 0;
+    list->frame = frame;
+    list->num_tris = 0;
+    list->num_tiles = (uint16_t)num_tiles;
+    memset(list->tile_offsets, 0, (num_tiles + 1) * sizeof(list->tile_offsets[0]));
+    stats->tris_in = 0;
+    stats->tris_out = 0;
+
+    if (pipeline_scene != NULL) {
+        pipeline_scene(builder, frame, pipeline_scene_user);
+    }
+
+    // Counts to offsets, then scatter triangle indices. Each bin ends up in submission order, so
+    // painter's-order scenes still draw correctly.
+    for (uint32_t t = 0; t < num_tiles; t++) {
+        list->tile_offsets[t + 1] += list->tile_offsets[t];
+        builder->cursor[t] = list->tile_offsets[t];
+    }
+    for (uint16_t i = 0; i < list->num_tris; i++) {
+        const rect_t* tiles = &builder->tiles[i];
+        for (int16_t ty = tiles->y0; ty < tiles->y1; ty++) {
+            for (int16_t tx = tiles->x0; tx < tiles->x1; tx++) {
+                list->tile_prims[builder->cursor[ty * ps->config.cols + tx]++] = i;
+            }
+        }
+    }
+
+    stats->last_cycles = cycles_now() - start;
+    stats->frames++;
+
+    fence_signal(&ps->ready, frame);
+    TRACE_END(TRACE_EVENT_GEOMETRY, frame);
+}
+
+bool pipeline_handle(const ipc_msg_t* msg) {
+    if (msg == NULL || msg->type != IPC_MSG_PIPELINE_KICK) {
+        return false;
+    }
+
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    if (ps->stats[CORE_ID_SELF].cycles_per_s == 0) {
+        cycles_init();
+        ps->stats[CORE_ID_SELF].cycles_per_s = cycles_per_second();
+    }
+    // Fill every list the CM7 has finished with. Building N + 1 here overlaps with the CM7
+    // rasterizing N from the other list.
+    while (fence_reached(&ps->consumed, pipeline_next_frame - ps->config.depth)) {
+        pipeline_build(pipeline_next_frame++);
+    }
+    return true;
+}
+
+#endif
+
+#if defined(CORE_CM7)
+
+/***** RASTER *****/
+
+static pipeline_list_t pipeline_lists[PIPELINE_NUM_LISTS] DMA_BUFFER;
+static bool pipeline_kick_owed;
+
+// Ping-pong tile buffers: one is drawn into while the DMA2D writes the other back. Cacheable, so
+// overdraw never leaves the D-cache; the blitter cleans each tile before the DMA2D reads it.
+static uint8_t pipeline_tile_buffers[2][PIPELINE_TILE_BUFFER_B] AXI_BUFFER;
+static uint32_t pipeline_clear_argb = PIPELINE_DEFAULT_CLEAR_ARGB;
+
+// The tile buffer is contiguous, so clearing it is one run of pixels.
+FAST_CODE static void pipeline_tile_clear(const surface_t* tile, uint32_t argb) {
+    uint32_t count = (uint32_t)tile->width * tile->height;
+    uint8_t packed[4] = {0};
+    blit_pack(tile->format, packed, argb);
+    switch (pixel_format_bytes(tile->format)) {
+        case 4: {
+            uint32_t word;
+            memcpy(&word, packed, sizeof(word));
+            uint32_t* p = (uint32_t*)tile->pixels;
+            for (uint32_t i = 0; i < count; i++) {
+                p[i] = word;
+            }
+            break;
+        }
+        case 2: {
+            uint16_t half;
+            memcpy(&half, packed, sizeof(half));
+            uint16_t* p = (uint16_t*)tile->pixels;
+            for (uint32_t i = 0; i < count; i++) {
+                p[i] = half;
+            }
+            break;
+        }
+        default:
+            for (uint32_t i = 0; i < count; i++) {
+                memcpy((uint8_t*)tile->pixels + i * 3, packed, 3);
+            }
+            break;
+    }
+}
+
+// Draws the tile's triangles into a buffer holding just that tile, moving them into its
+// coordinates.
+static void pipeline_raster_tile(const surface_t* buffer, const rect_t* tile,
+                                 const pipeline_list_t* list, uint32_t t) {
+    rect_t clip = surface_bounds(buffer);
+    int32_t dx = tile->x0 * RASTER_SUBPIXEL_ONE;
+    int32_t dy = tile->y0 * RASTER_SUBPIXEL_ONE;
+    for (uint32_t i = list->tile_offsets[t]; i < list->tile_offsets[t + 1]; i++) {
+        raster_tri_t tri = list->tris[list->tile_prims[i]];
+        for (uint32_t v = 0; v < 3; v++) {
+            tri.x[v] -= dx;
+            tri.y[v] -= dy;
+        }
+        raster_triangle(buffer, &clip, &tri);
+    }
+}
+
+// *last is the blit sequence number of the last tile's write-back, which completes the frame.
+static bool pipeline_raster_tiled(const surface_t* target, const pipeline_list_t* list,
+                                  pipeline_core_stats_t* stats, uint32_t* last) {
+    uint32_t pending[2] = {0, 0};
+    bool ok = true;
+    stats->flush_cycles = 0;
+    for (uint32_t t = 0; t < list->num_tiles; t++) {
+        rect_t tile = pipeline_tile_rect(t);
+        uint16_t width = (uint16_t)(tile.x1 - tile.x0);
+        uint16_t height = (uint16_t)(tile.y1 - tile.y0);
+        surface_t buffer = {pipeline_tile_buffers[t % 2], width, height,
+                            (uint32_t)width * pixel_format_bytes(target->format), target->format};
+
+        uint32_t wait_start = cycles_now();
+        blit_wait(pending[t % 2], BLIT_WAIT_FOREVER);
+        stats->flush_cycles += cycles_now() - wait_start;
+
+        pipeline_tile_clear(&buffer, pipeline_clear_argb);
+        pipeline_raster_tile(&buffer, &tile, list, t);
+        rect_t whole = surface_bounds(&buffer);
+        if (blit_copy_async(target, tile.x0, tile.y0, &buffer, &whole, &pending[t % 2]) !=
+            BLIT_STATUS_OK) {
+            ok = false;
+        }
+        *last = pending[t % 2];
+    }
+    return ok;
+}
+
+// Fallback for tiles too large for the tile buffers: every triangle writes the target directly.
+static void pipeline_raster_direct(const surface_t* target, const pipeline_list_t* list) {
+    for (uint32_t t = 0; t < list->num_tiles; t++) {
+        rect_t tile = pipeline_tile_rect(t);
+        blit_fill(target, &tile, pipeline_clear_argb);
+        for (uint32_t i = list->tile_offsets[t]; i < list->tile_offsets[t + 1]; i++) {
+            raster_triangle(target, &tile, &list->tris[list->tile_prims[i]]);
+        }
+    }
+    rect_t bounds = surface_bounds(target);
+    cache_maint_rects(target, &bounds, 1, CACHE_MAINT_CLEAN);
+}
+
+// A CM4 busy elsewhere (on I2C, say) can leave its ring full for a while, but not forever: give
+// up after PIPELINE_KICK_TIMEOUT_US and leave the kick owed.
+static pipeline_status_t pipeline_kick(void) {
+    uint32_t start_us = timebase_now_us();
+    ipc_status_t status;
+    while ((status = ipc_send(IPC_MSG_PIPELINE_KICK, NULL, 0)) == IPC_STATUS_FULL &&
+           timebase_elapsed_us(start_us) < PIPELINE_KICK_TIMEOUT_US) {
+    }
+    pipeline_kick_owed = status != IPC_STATUS_OK;
+    return status == IPC_STATUS_OK ? PIPELINE_STATUS_OK : PIPELINE_STATUS_IPC_ERR;
+}
+
+pipeline_status_t pipeline_init(uint16_t width, uint16_t height, uint16_t tile_w, uint16_t tile_h) {
+    if (width == 0 || height == 0 || tile_w == 0 || tile_h == 0) {
+        return PIPELINE_STATUS_BAD_LAYOUT;
+    }
+    uint32_t cols = (width + tile_w - 1) / tile_w;
+    uint32_t rows = (height + tile_h - 1) / tile_h;
+    if (cols * rows > PIPELINE_MAX_TILES) {
+        return PIPELINE_STATUS_BAD_LAYOUT;
+    }
+
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    for (uint32_t i = 0; i < PIPELINE_NUM_LISTS; i++) {
+        ps->config.lists[i] = &pipeline_lists[i];
+    }
+    ps->config.width = width;
+    ps->config.height = height;
+    ps->config.tile_w = tile_w;
+    ps->config.tile_h = tile_h;
+    ps->config.cols = (uint16_t)cols;
+    ps->config.rows = (uint16_t)rows;
+    ps->config.depth = PIPELINE_NUM_LISTS;
+    fence_init(&ps->ready, HSEM_ID_PIPELINE_READY);
+    fence_init(&ps->consumed, FENCE_NO_DOORBELL);  // The CM4 is woken by the kick instead.
+    fence_attach(&ps->ready);
+
+    cycles_init();
+    ps->stats[CORE_ID_SELF].cycles_per_s = cycles_per_second();
+
+    __DMB();
+    return pipeline_kick();
+}
+
+uint32_t pipeline_raster_frame(const surface_t* target) {
+    pipeline_shared_t* ps = &shared_mem.pipeline;
+    if (target == NULL || target->width != ps->config.width ||
+        target->height != ps->config.height) {
+        return 0;
+    }
+
+    pipeline_core_stats_t* stats = &ps->stats[CORE_ID_SELF];
+    uint32_t frame = fence_value(&ps->consumed) + 1;
+    // Without the kick the CM4 may never build this frame's list.
+    if (pipeline_kick_owed && pipeline_kick() != PIPELINE_STATUS_OK &&
+        !fence_reached(&ps->ready, frame)) {
+        return 0;
+    }
+    uint32_t start = cycles_now();
+    fence_wait(&ps->ready, frame, FENCE_WAIT_FOREVER);
+    uint32_t raster_start = cycles_now();
+    stats->stall_cycles = raster_start - start;
+    TRACE_BEGIN(TRACE_EVENT_FRAME, frame);
+
+    const pipeline_list_t* list = ps->config.lists[frame % PIPELINE_NUM_LISTS];
+    uint32_t tile_b =
+        (uint32_t)ps->config.tile_w * ps->config.tile_h * pixel_format_bytes(target->format);
+    uint32_t last_flush = 0;
+    bool ok = true;
+    if (tile_b <= PIPELINE_TILE_BUFFER_B) {
+        ok = pipeline_raster_tiled(target, list, stats, &last_flush);
+    } else {
+        stats->flush_cycles = 0;
+        pipeline_raster_direct(target, list);
+    }
+
+    // Done reading the list: hand it back and let the CM4 start on frame + 2, while the last
+    // tiles are still being written back.
+    fence_signal(&ps->consumed, frame);
+    uint32_t wait_start = cycles_now();
+    ok = blit_wait(last_flush, BLIT_WAIT_FOREVER) == BLIT_STATUS_OK && ok;
+    stats->flush_cycles += cycles_now() - wait_start;
+    TRACE_END(TRACE_EVENT_FRAME, frame);
+    stats->last_cycles = cycles_now() - raster_start;
+    stats->frames++;
+    if (pipeline_kick() != PIPELINE_STATUS_OK || !ok) {
+        return 0;
+    }
+    return frame;
+}
+
+void pipeline_set_clear_color(uint32_t argb) {
+    pipeline_clear_argb = argb;
+}
+
+void pipeline_set_overlap(bool overlap) {
+    shared_mem.pipeline.config.depth = overlap ? PIPELINE_NUM_LISTS : 1;
+}
+
+#endif
+
+void pipeline_get_stats(core_id_t core, pipeline_core_stats_t* stats) {
+    if (stats != NULL && core < CORE_ID_COUNT) {
+        *stats = shared_mem.pipeline.stats[core];
+    }
+}
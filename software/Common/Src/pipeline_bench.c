@@ -0,0 +1,121 @@
+#include "pipeline_bench.h"
+
+#include "core_id.h"
+#include "timebase.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#if defined(CORE_CM4)
+
+// Radians per frame.
+#define PIPELINE_BENCH_SPIN 0.02f
+// Triangle vertices lie within this many pixels of their own centre.
+#define PIPELINE_BENCH_TRI_PX 24
+
+static pipeline_vec2_t pipeline_bench_verts[3 * PIPELINE_BENCH_TRIS];
+static uint16_t pipeline_bench_indices[3 * PIPELINE_BENCH_TRIS];
+static bool pipeline_bench_generated;
+
+static uint32_t pipeline_bench_next(uint32_t* seed) {
+    *seed = *seed * 1664525UL + 1013904223UL;
+    return *seed >> 8;
+}
+
+// Small triangles scattered over the target, centred on the origin so that rotation keeps them
+// mostly on screen. Half face away, so culling has work to do.
+static void pipeline_bench_generate(void) {
+    uint32_t seed = 1;
+    float half_w = PIPELINE_BENCH_WIDTH / 2.0f;
+    float half_h = PIPELINE_BENCH_HEIGHT / 2.0f;
+    for (uint32_t t = 0; t < PIPELINE_BENCH_TRIS; t++) {
+        float cx = (float)(pipeline_bench_next(&seed) % PIPELINE_BENCH_WIDTH) - half_w;
+        float cy = (float)(pipeline_bench_next(&seed) % PIPELINE_BENCH_HEIGHT) - half_h;
+        for (uint32_t v = 0; v < 3; v++) {
+            pipeline_bench_verts[3 * t + v] = (pipeline_vec2_t){
+                cx + (float)(pipeline_bench_next(&seed) % (2 * PIPELINE_BENCH_TRI_PX)) -
+                    PIPELINE_BENCH_TRI_PX,
+                cy + (float)(pipeline_bench_next(&seed) % (2 * PIPELINE_BENCH_TRI_PX)) -
+                    PIPELINE_BENCH_TRI_PX};
+            pipeline_bench_indices[3 * t + v] = (uint16_t)(3 * t + v);
+        }
+    }
+    pipeline_bench_generated = true;
+}
+
+void pipeline_bench_scene(pipeline_builder_t* builder, uint32_t frame, void* user) {
+    (void)user;
+    if (!pipeline_bench_generated) {
+        pipeline_bench_generate();
+    }
+    float angle = (float)frame * PIPELINE_BENCH_SPIN;
+    float c = cosf(angle);
+    float s = sinf(angle);
+    pipeline_transform_t transform = {{c, -s, PIPELINE_BENCH_WIDTH / 2.0f,
+                                       s, c, PIPELINE_BENCH_HEIGHT / 2.0f}};
+    pipeline_submit(builder, pipeline_bench_verts, pipeline_bench_indices, PIPELINE_BENCH_TRIS,
+                    &transform, 0xFF000000UL | ((frame * 0x010203UL) & 0x00FFFFFFUL), true);
+}
+
+#endif
+
+#if defined(CORE_CM7)
+
+static uint32_t pipeline_bench_us(const pipeline_core_stats_t* stats, uint32_t cycles) {
+    return stats->cycles_per_s == 0 ? 0
+                                    : (uint32_t)((uint64_t)cycles * 1000000 / stats->cycles_per_s);
+}
+
+static bool pipeline_bench_mode(const surface_t* target, bool overlap,
+                                pipeline_bench_mode_t* mode) {
+    pipeline_set_overlap(overlap);
+    for (uint32_t i = 0; i < PIPELINE_BENCH_WARMUP_FRAMES; i++) {
+        if (pipeline_raster_frame(target) == 0) {
+            return false;
+        }
+    }
+
+    uint64_t geometry_us = 0;
+    uint64_t raster_us = 0;
+    uint64_t stall_us = 0;
+    uint32_t start_us = timebase_now_us();
+    for (uint32_t i = 0; i < PIPELINE_BENCH_FRAMES; i++) {
+        if (pipeline_raster_frame(target) == 0) {
+            return false;
+        }
+        // The CM4's figure is for the newest list it built, which may be a frame ahead.
+        pipeline_core_stats_t cm4;
+        pipeline_core_stats_t cm7;
+        pipeline_get_stats(CORE_ID_CM4, &cm4);
+        pipeline_get_stats(CORE_ID_CM7, &cm7);
+        geometry_us += pipeline_bench_us(&cm4, cm4.last_cycles);
+        raster_us += pipeline_bench_us(&cm7, cm7.last_cycles);
+        stall_us += pipeline_bench_us(&cm7, cm7.stall_cycles);
+    }
+    *mode = (pipeline_bench_mode_t){
+        .frames = PIPELINE_BENCH_FRAMES,
+        .frame_us = timebase_elapsed_us(start_us) / PIPELINE_BENCH_FRAMES,
+        .geometry_us = (uint32_t)(geometry_us / PIPELINE_BENCH_FRAMES),
+        .raster_us = (uint32_t)(raster_us / PIPELINE_BENCH_FRAMES),
+        .stall_us = (uint32_t)(stall_us / PIPELINE_BENCH_FRAMES),
+    };
+    return true;
+}
+
+bool pipeline_bench_run(const surface_t* target, pipeline_bench_result_t* result) {
+    if (target == NULL || result == NULL || target->width != PIPELINE_BENCH_WIDTH ||
+        target->height != PIPELINE_BENCH_HEIGHT) {
+        return false;
+    }
+    *result = (pipeline_bench_result_t){0};
+    if (pipeline_init(PIPELINE_BENCH_WIDTH, PIPELINE_BENCH_HEIGHT, PIPELINE_BENCH_TILE_PX,
+                      PIPELINE_BENCH_TILE_PX) != PIPELINE_STATUS_OK) {
+        return false;
+    }
+    bool ok = pipeline_bench_mode(target, true, &result->overlapped) &&
+              pipeline_bench_mode(target, false, &result->serial);
+    pipeline_set_overlap(true);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,349 @@
+#include "pixel_convert.h"
+
+#include "blit.h"
+#include "fast_mem.h"
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include "stm32h7xx.h"
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define pixel_convert_pkhbt(lo, hi, shift) __PKHBT(lo, hi, shift)
+#define pixel_convert_uxtb16 __UXTB16
+#else
+#define pixel_convert_pkhbt(lo, hi, shift) \
+    (((uint32_t)(lo) & 0x0000FFFFUL) | (((uint32_t)(hi) << (shift)) & 0xFFFF0000UL))
+static inline uint32_t pixel_convert_uxtb16(uint32_t x) {
+    return x & 0x00FF00FFUL;
+}
+#endif
+
+static const pixel_convert_params_t pixel_convert_no_params = {0};
+
+// A word-at-a-time kernel. Converts count pixels, a multiple of its group, from word-aligned
+// rows.
+typedef void (*pixel_convert_kernel_fn_t)(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                          const pixel_convert_params_t* params);
+
+typedef struct {
+    pixel_format_t dst_format;
+    pixel_format_t src_format;
+    uint8_t group;  // Pixels per iteration.
+    pixel_convert_kernel_fn_t fn;
+} pixel_convert_kernel_t;
+
+/***** REFERENCE *****/
+
+static inline uint32_t pixel_convert_read(pixel_format_t format, const uint8_t* src,
+                                          const pixel_convert_params_t* params) {
+    switch (format) {
+        case PIXEL_FORMAT_L8:
+            return *src < params->clut_size ? params->clut[*src] : 0;
+        case PIXEL_FORMAT_A8:
+            return ((uint32_t)*src << 24) | (params->rgb & 0x00FFFFFFUL);
+        default:
+            return blit_unpack(format, src);
+    }
+}
+
+static inline void pixel_convert_write(pixel_format_t format, uint8_t* dst, uint32_t argb) {
+    if (format == PIXEL_FORMAT_A8) {
+        *dst = (uint8_t)(argb >> 24);
+    } else {
+        blit_pack(format, dst, argb);
+    }
+}
+
+static void pixel_convert_pixels(uint8_t* dst, pixel_format_t dst_format, const uint8_t* src,
+                                 pixel_format_t src_format, uint32_t count,
+                                 const pixel_convert_params_t* params) {
+    uint8_t dst_bpp = pixel_format_bytes(dst_format);
+    uint8_t src_bpp = pixel_format_bytes(src_format);
+    for (uint32_t i = 0; i < count; i++, dst += dst_bpp, src += src_bpp) {
+        pixel_convert_write(dst_format, dst, pixel_convert_read(src_format, src, params));
+    }
+}
+
+/***** KERNELS *****/
+
+// Per-pixel word arithmetic shared by the kernels. Channels are expanded by replicating their top
+// bits and narrowed by truncation, as in blit_unpack()/blit_pack().
+
+static inline uint32_t pixel_convert_565_to_8888(uint32_t v) {
+    uint32_t rb = ((v & 0xF800) << 8) | ((v & 0x001F) << 3);
+    uint32_t g = (v & 0x07E0) << 5;
+    rb |= (rb >> 5) & 0x00070007UL;
+    g |= (g >> 6) & 0x0300;
+    return 0xFF000000UL | rb | g;
+}
+
+static inline uint32_t pixel_convert_8888_to_565(uint32_t x) {
+    return ((x >> 8) & 0xF800) | ((x >> 5) & 0x07E0) | ((x >> 3) & 0x001F);
+}
+
+static inline uint32_t pixel_convert_4444_to_8888(uint32_t v) {
+    uint32_t n = ((v & 0xF000) << 12) | ((v & 0x0F00) << 8) | ((v & 0x00F0) << 4) | (v & 0x000F);
+    return n | (n << 4);
+}
+
+// Keeps each byte's top nibble; the extract then pulls A:R and G:B together.
+static inline uint32_t pixel_convert_8888_to_4444(uint32_t x) {
+    uint32_t n = (x >> 4) & 0x0F0F0F0FUL;
+    uint32_t pairs = pixel_convert_uxtb16(n | (n >> 4));
+    return (pairs | (pairs >> 8)) & 0xFFFF;
+}
+
+FAST_CODE static void pixel_convert_k_565_8888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                               const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 2) {
+        uint32_t v = *s++;
+        d[0] = pixel_convert_565_to_8888(v & 0xFFFF);
+        d[1] = pixel_convert_565_to_8888(v >> 16);
+        d += 2;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_8888_565(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                               const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 2) {
+        *d++ = pixel_convert_pkhbt(pixel_convert_8888_to_565(s[0]),
+                                   pixel_convert_8888_to_565(s[1]), 16);
+        s += 2;
+    }
+}
+
+// Four pixels are three words of RGB888.
+FAST_CODE static void pixel_convert_k_888_8888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                               const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t w0 = s[0];
+        uint32_t w1 = s[1];
+        uint32_t w2 = s[2];
+        d[0] = 0xFF000000UL | w0;
+        d[1] = 0xFF000000UL | (w0 >> 24) | (w1 << 8);
+        d[2] = 0xFF000000UL | (w1 >> 16) | (w2 << 16);
+        d[3] = 0xFF000000UL | (w2 >> 8);
+        s += 3;
+        d += 4;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_8888_888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                               const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t x0 = s[0];
+        uint32_t x1 = s[1];
+        uint32_t x2 = s[2];
+        uint32_t x3 = s[3];
+        d[0] = (x0 & 0x00FFFFFFUL) | (x1 << 24);
+        d[1] = pixel_convert_pkhbt(x1 >> 8, x2, 16);
+        d[2] = ((x2 >> 16) & 0xFF) | (x3 << 8);
+        s += 4;
+        d += 3;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_4444_8888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                                const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 2) {
+        uint32_t v = *s++;
+        d[0] = pixel_convert_4444_to_8888(v & 0xFFFF);
+        d[1] = pixel_convert_4444_to_8888(v >> 16);
+        d += 2;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_8888_4444(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                                const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 2) {
+        *d++ = pixel_convert_pkhbt(pixel_convert_8888_to_4444(s[0]),
+                                   pixel_convert_8888_to_4444(s[1]), 16);
+        s += 2;
+    }
+}
+
+// Four indices per word. Short CLUTs take the per-pixel path (see pixel_convert_find()).
+FAST_CODE static void pixel_convert_k_l8_8888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                              const pixel_convert_params_t* params) {
+    const uint32_t* clut = params->clut;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t v = *s++;
+        d[0] = clut[v & 0xFF];
+        d[1] = clut[(v >> 8) & 0xFF];
+        d[2] = clut[(v >> 16) & 0xFF];
+        d[3] = clut[v >> 24];
+        d += 4;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_l8_565(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                             const pixel_convert_params_t* params) {
+    const uint32_t* clut = params->clut;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t v = *s++;
+        d[0] = pixel_convert_pkhbt(pixel_convert_8888_to_565(clut[v & 0xFF]),
+                                   pixel_convert_8888_to_565(clut[(v >> 8) & 0xFF]), 16);
+        d[1] = pixel_convert_pkhbt(pixel_convert_8888_to_565(clut[(v >> 16) & 0xFF]),
+                                   pixel_convert_8888_to_565(clut[v >> 24]), 16);
+        d += 2;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_a8_8888(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                              const pixel_convert_params_t* params) {
+    uint32_t rgb = params->rgb & 0x00FFFFFFUL;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t v = *s++;
+        d[0] = (v << 24) | rgb;
+        d[1] = ((v << 16) & 0xFF000000UL) | rgb;
+        d[2] = ((v << 8) & 0xFF000000UL) | rgb;
+        d[3] = (v & 0xFF000000UL) | rgb;
+        d += 4;
+    }
+}
+
+FAST_CODE static void pixel_convert_k_8888_a8(uint8_t* dst, const uint8_t* src, uint32_t count,
+                                              const pixel_convert_params_t* params) {
+    (void)params;
+    const uint32_t* s = (const uint32_t*)src;
+    uint32_t* d = (uint32_t*)dst;
+    for (uint32_t i = 0; i < count; i += 4) {
+        *d++ = (s[0] >> 24) | ((s[1] >> 16) & 0xFF00) | ((s[2] >> 8) & 0xFF0000UL) |
+               (s[3] & 0xFF000000UL);
+        s += 4;
+    }
+}
+
+static const pixel_convert_kernel_t pixel_convert_kernels[] = {
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB565, 2, pixel_convert_k_565_8888},
+    {PIXEL_FORMAT_RGB565, PIXEL_FORMAT_ARGB8888, 2, pixel_convert_k_8888_565},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB888, 4, pixel_convert_k_888_8888},
+    {PIXEL_FORMAT_RGB888, PIXEL_FORMAT_ARGB8888, 4, pixel_convert_k_8888_888},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_ARGB4444, 2, pixel_convert_k_4444_8888},
+    {PIXEL_FORMAT_ARGB4444, PIXEL_FORMAT_ARGB8888, 2, pixel_convert_k_8888_4444},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_L8, 4, pixel_convert_k_l8_8888},
+    {PIXEL_FORMAT_RGB565, PIXEL_FORMAT_L8, 4, pixel_convert_k_l8_565},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_A8, 4, pixel_convert_k_a8_8888},
+    {PIXEL_FORMAT_A8, PIXEL_FORMAT_ARGB8888, 4, pixel_convert_k_8888_a8},
+};
+
+static const pixel_convert_kernel_t* pixel_convert_find(pixel_format_t dst_format,
+                                                        pixel_format_t src_format,
+                                                        const pixel_convert_params_t* params) {
+    // The L8 kernels index the CLUT unchecked.
+    if (src_format == PIXEL_FORMAT_L8 && params->clut_size < 256) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(pixel_convert_kernels) / sizeof(pixel_convert_kernels[0]); i++) {
+        const pixel_convert_kernel_t* kernel = &pixel_convert_kernels[i];
+        if (kernel->dst_format == dst_format && kernel->src_format == src_format) {
+            return kernel;
+        }
+    }
+    return NULL;
+}
+
+/***** PUBLIC API *****/
+
+static bool pixel_convert_src_supported(pixel_format_t format) {
+    return blit_format_supported(format) || format == PIXEL_FORMAT_L8 ||
+           format == PIXEL_FORMAT_A8;
+}
+
+bool pixel_convert_supported(pixel_format_t dst_format, pixel_format_t src_format) {
+    return pixel_convert_src_supported(src_format) &&
+           (blit_format_supported(dst_format) || dst_format == PIXEL_FORMAT_A8);
+}
+
+static pixel_convert_status_t pixel_convert_check(uint8_t* dst, pixel_format_t dst_format,
+                                                  const uint8_t* src, pixel_format_t src_format,
+                                                  const pixel_convert_params_t** params) {
+    if (dst == NULL || src == NULL || (src_format == PIXEL_FORMAT_L8 && *params == NULL)) {
+        return PIXEL_CONVERT_STATUS_NULL_ARG;
+    } else if (!pixel_convert_supported(dst_format, src_format)) {
+        return PIXEL_CONVERT_STATUS_BAD_FORMAT;
+    }
+    if (*params == NULL) {
+        *params = &pixel_convert_no_params;
+    }
+    return PIXEL_CONVERT_STATUS_OK;
+}
+
+pixel_convert_status_t pixel_convert_row(uint8_t* dst, pixel_format_t dst_format,
+                                         const uint8_t* src, pixel_format_t src_format,
+                                         uint32_t count, const pixel_convert_params_t* params) {
+    pixel_convert_status_t status = pixel_convert_check(dst, dst_format, src, src_format, &params);
+    if (status != PIXEL_CONVERT_STATUS_OK) {
+        return status;
+    }
+    if (dst_format == src_format) {
+        memmove(dst, src, (size_t)count * pixel_format_bytes(src_format));
+        return PIXEL_CONVERT_STATUS_OK;
+    }
+
+    const pixel_convert_kernel_t* kernel = pixel_convert_find(dst_format, src_format, params);
+    if (kernel == NULL) {
+        pixel_convert_pixels(dst, dst_format, src, src_format, count, params);
+        return PIXEL_CONVERT_STATUS_OK;
+    }
+
+    // Head: single pixels until both rows are word-aligned. Every format here advances by a
+    // whole number of bytes, so alignment recurs within four pixels if it ever does.
+    uint8_t dst_bpp = pixel_format_bytes(dst_format);
+    uint8_t src_bpp = pixel_format_bytes(src_format);
+    uint32_t head = 0;
+    while (head < 4 && head < count &&
+           (((uintptr_t)dst + head * dst_bpp) | ((uintptr_t)src + head * src_bpp)) % 4 != 0) {
+        head++;
+    }
+    if ((((uintptr_t)dst + head * dst_bpp) | ((uintptr_t)src + head * src_bpp)) % 4 != 0) {
+        pixel_convert_pixels(dst, dst_format, src, src_format, count, params);
+        return PIXEL_CONVERT_STATUS_OK;
+    }
+    pixel_convert_pixels(dst, dst_format, src, src_format, head, params);
+
+    uint32_t bulk = (count - head) / kernel->group * kernel->group;
+    kernel->fn(dst + head * dst_bpp, src + head * src_bpp, bulk, params);
+
+    uint32_t done = head + bulk;
+    pixel_convert_pixels(dst + done * dst_bpp, dst_format, src + done * src_bpp, src_format,
+                         count - done, params);
+    return PIXEL_CONVERT_STATUS_OK;
+}
+
+pixel_convert_status_t pixel_convert_row_ref(uint8_t* dst, pixel_format_t dst_format,
+                                             const uint8_t* src, pixel_format_t src_format,
+                                             uint32_t count, const pixel_convert_params_t* params) {
+    pixel_convert_status_t status = pixel_convert_check(dst, dst_format, src, src_format, &params);
+    if (status == PIXEL_CONVERT_STATUS_OK) {
+        pixel_convert_pixels(dst, dst_format, src, src_format, count, params);
+    }
+    return status;
+}
@@ -0,0 +1,109 @@
+#include "pixel_convert_bench.h"
+
+#include "cycles.h"
+#include "pixel_convert.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Rows timed per case; results are averaged over all of them.
+#define PIXEL_CONVERT_BENCH_ROUNDS 16
+// Short rows checked at every alignment: 0 up to this many pixels.
+#define PIXEL_CONVERT_BENCH_SHORT_MAX 19
+
+static const pixel_format_t pixel_convert_bench_pairs[PIXEL_CONVERT_BENCH_CASES][2] = {
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB565},   {PIXEL_FORMAT_RGB565, PIXEL_FORMAT_ARGB8888},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB888},   {PIXEL_FORMAT_RGB888, PIXEL_FORMAT_ARGB8888},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_ARGB4444}, {PIXEL_FORMAT_ARGB4444, PIXEL_FORMAT_ARGB8888},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_L8},       {PIXEL_FORMAT_RGB565, PIXEL_FORMAT_L8},
+    {PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_A8},       {PIXEL_FORMAT_A8, PIXEL_FORMAT_ARGB8888},
+};
+
+static uint32_t pixel_convert_bench_clut[256];
+
+// Deterministic noise, so every run sees the same inputs.
+static void pixel_convert_bench_pattern(uint8_t* buf, uint32_t size_b, uint32_t seed) {
+    for (uint32_t i = 0; i < size_b; i++) {
+        seed = seed * 1664525UL + 1013904223UL;
+        buf[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static uint32_t pixel_convert_bench_time(bool ref, uint8_t* dst, pixel_format_t dst_format,
+                                         const uint8_t* src, pixel_format_t src_format,
+                                         const pixel_convert_params_t* params) {
+    uint32_t start = cycles_now();
+    for (uint32_t i = 0; i < PIXEL_CONVERT_BENCH_ROUNDS; i++) {
+        if (ref) {
+            pixel_convert_row_ref(dst, dst_format, src, src_format, PIXEL_CONVERT_BENCH_PIXELS,
+                                  params);
+        } else {
+            pixel_convert_row(dst, dst_format, src, src_format, PIXEL_CONVERT_BENCH_PIXELS,
+                              params);
+        }
+    }
+    uint32_t cycles = cycles_now() - start;
+    return (uint32_t)((uint64_t)cycles * 1000 /
+                      ((uint64_t)PIXEL_CONVERT_BENCH_ROUNDS * PIXEL_CONVERT_BENCH_PIXELS));
+}
+
+// Converts count pixels both ways, with the rows offset by the given bytes, and counts differing
+// output bytes.
+static uint32_t pixel_convert_bench_check(uint8_t* scratch, pixel_format_t dst_format,
+                                          pixel_format_t src_format,
+                                          const pixel_convert_params_t* params, uint32_t src_off,
+                                          uint32_t dst_off, uint32_t count) {
+    const uint32_t row_b = PIXEL_CONVERT_BENCH_PIXELS * 4 + 8;
+    const uint8_t* src = scratch + src_off;
+    uint8_t* out = scratch + row_b + dst_off;
+    uint8_t* ref = scratch + 2 * row_b + dst_off;
+    uint32_t size_b = count * pixel_format_bytes(dst_format);
+    memset(out, 0, size_b);
+    memset(ref, 0, size_b);
+    pixel_convert_row(out, dst_format, src, src_format, count, params);
+    pixel_convert_row_ref(ref, dst_format, src, src_format, count, params);
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < size_b; i++) {
+        mismatches += out[i] != ref[i];
+    }
+    return mismatches;
+}
+
+bool pixel_convert_bench_run(void* scratch, pixel_convert_bench_result_t* result) {
+    if (scratch == NULL || result == NULL || (uintptr_t)scratch % 4 != 0) {
+        return false;
+    }
+    *result = (pixel_convert_bench_result_t){0};
+    cycles_init();
+
+    uint8_t* buf = scratch;
+    const uint32_t row_b = PIXEL_CONVERT_BENCH_PIXELS * 4 + 8;
+    pixel_convert_bench_pattern(buf, row_b, 0xC0FFEEUL);
+    pixel_convert_bench_pattern((uint8_t*)pixel_convert_bench_clut,
+                                sizeof(pixel_convert_bench_clut), 0x5EEDUL);
+    pixel_convert_params_t params = {pixel_convert_bench_clut, 256, 0x00C08040UL};
+
+    for (uint32_t c = 0; c < PIXEL_CONVERT_BENCH_CASES; c++) {
+        pixel_convert_bench_case_t* bench = &result->cases[c];
+        bench->dst_format = pixel_convert_bench_pairs[c][0];
+        bench->src_format = pixel_convert_bench_pairs[c][1];
+
+        bench->cycles_per_kpx = pixel_convert_bench_time(false, buf + row_b, bench->dst_format,
+                                                         buf, bench->src_format, &params);
+        bench->ref_cycles_per_kpx = pixel_convert_bench_time(true, buf + row_b, bench->dst_format,
+                                                             buf, bench->src_format, &params);
+
+        bench->mismatches = pixel_convert_bench_check(buf, bench->dst_format, bench->src_format,
+                                                      &params, 0, 0, PIXEL_CONVERT_BENCH_PIXELS);
+        for (uint32_t src_off = 0; src_off < 4; src_off++) {
+            for (uint32_t dst_off = 0; dst_off < 4; dst_off++) {
+                for (uint32_t count = 0; count <= PIXEL_CONVERT_BENCH_SHORT_MAX; count++) {
+                    bench->mismatches +=
+                        pixel_convert_bench_check(buf, bench->dst_format, bench->src_format,
+                                                  &params, src_off, dst_off, count);
+                }
+            }
+        }
+    }
+    return true;
+}
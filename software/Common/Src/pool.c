@@ -0,0 +1,211 @@
+#include "pool.h"
+
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define POOL_MAGIC 0x4C4F4F50UL  // "POOL"
+#define POOL_INDEX_NONE 0xFFFFUL
+#define POOL_INDEX_MASK 0xFFFFUL
+#define POOL_TAG_ONE 0x10000UL
+
+// This core's side of each pool. Private memory, so the local exclusive monitor covers it.
+typedef struct {
+    volatile uint32_t head;  // Tag in the upper half, index of the first free block in the lower.
+    volatile uint32_t in_use;
+} pool_local_t;
+
+static pool_local_t pool_locals[POOL_COUNT];
+
+static inline pool_t* pool_get(pool_id_t id) {
+    return id < POOL_COUNT ? &shared_mem.pool.pools[id] : NULL;
+}
+
+static inline uint16_t* pool_link(const pool_t* pool, uint32_t index) {
+    return (uint16_t*)(pool->storage + index * pool->block_size_b);
+}
+
+static inline core_id_t pool_home(const pool_t* pool, uint32_t index) {
+    return index < pool->cm7_blocks ? CORE_ID_CM7 : CORE_ID_CM4;
+}
+
+static uint32_t pool_atomic_add(volatile uint32_t* value, int32_t delta) {
+    uint32_t result;
+    do {
+        result = __LDREXW(value) + (uint32_t)delta;
+    } while (__STREXW(result, value) != 0);
+    return result;
+}
+
+/***** LOCAL FREE LIST *****/
+
+// Block links are read and written outside the exclusive pair; the tag, bumped on every update,
+// makes the head compare fail if the list changed underneath (ABA), so a stale link is never
+// installed.
+
+static void pool_push(const pool_t* pool, pool_local_t* local, uint32_t index) {
+    uint16_t* link = pool_link(pool, index);
+    uint32_t head;
+    do {
+        head = local->head;
+        *link = (uint16_t)(head & POOL_INDEX_MASK);
+        __DMB();
+    } while (__LDREXW(&local->head) != head ||
+             __STREXW(((head + POOL_TAG_ONE) & ~POOL_INDEX_MASK) | index, &local->head) != 0);
+}
+
+static uint32_t pool_pop(const pool_t* pool, pool_local_t* local) {
+    uint32_t head;
+    uint32_t index;
+    uint16_t next;
+    do {
+        head = local->head;
+        index = head & POOL_INDEX_MASK;
+        if (index == POOL_INDEX_NONE) {
+            return POOL_INDEX_NONE;
+        }
+        next = *pool_link(pool, index);
+    } while (__LDREXW(&local->head) != head ||
+             __STREXW(((head + POOL_TAG_ONE) & ~POOL_INDEX_MASK) | next, &local->head) != 0);
+    return index;
+}
+
+/***** RETURN RINGS *****/
+
+// Both ends may be reached from thread and interrupt context on their core, so each end masks
+// interrupts for its few accesses. The other core is never blocked.
+
+static void pool_return(pool_t* pool, uint32_t index) {
+    pool_return_ring_t* ring = &pool->returns[pool_home(pool, index)];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t head = ring->head;
+    ring->slots[head % POOL_MAX_BLOCKS] = (uint16_t)index;
+    __DMB();
+    ring->head = head + 1;
+    __set_PRIMASK(primask);
+}
+
+static void pool_reclaim(pool_t* pool, pool_local_t* local) {
+    pool_return_ring_t* ring = &pool->returns[CORE_ID_SELF];
+    pool_stats_t* stats = &pool->stats[CORE_ID_SELF];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t tail = ring->tail;
+    uint32_t head = ring->head;
+    __DMB();
+    for (; tail != head; tail++) {
+        pool_push(pool, local, ring->slots[tail % POOL_MAX_BLOCKS]);
+        stats->returned++;
+        stats->in_use = pool_atomic_add(&local->in_use, -1);
+    }
+    ring->tail = tail;
+    __set_PRIMASK(primask);
+}
+
+/***** PUBLIC API *****/
+
+pool_status_t pool_init(pool_id_t id, void* storage, uint32_t block_size_b, uint32_t num_blocks,
+                        uint32_t cm7_blocks) {
+    pool_t* pool = pool_get(id);
+    if (pool == NULL) {
+        return POOL_STATUS_BAD_ID;
+    } else if (storage == NULL) {
+        return POOL_STATUS_NULL_ARG;
+    }
+    block_size_b = (block_size_b + POOL_BLOCK_ALIGN_B - 1) & ~(POOL_BLOCK_ALIGN_B - 1);
+    if ((uintptr_t)storage % POOL_BLOCK_ALIGN_B != 0 || block_size_b < POOL_MIN_BLOCK_SIZE_B ||
+        num_blocks == 0 || num_blocks > POOL_MAX_BLOCKS || cm7_blocks > num_blocks) {
+        return POOL_STATUS_BAD_CONFIG;
+    }
+
+    pool->magic = 0;
+    __DMB();
+    memset(pool, 0, sizeof(*pool));
+    pool->storage = storage;
+    pool->block_size_b = block_size_b;
+    pool->num_blocks = (uint16_t)num_blocks;
+    pool->cm7_blocks = (uint16_t)cm7_blocks;
+    pool->stats[CORE_ID_CM7].num_blocks = cm7_blocks;
+    pool->stats[CORE_ID_CM4].num_blocks = num_blocks - cm7_blocks;
+    __DMB();
+    pool->magic = POOL_MAGIC;
+    return POOL_STATUS_OK;
+}
+
+pool_status_t pool_attach(pool_id_t id) {
+    pool_t* pool = pool_get(id);
+    if (pool == NULL) {
+        return POOL_STATUS_BAD_ID;
+    } else if (pool->magic != POOL_MAGIC) {
+        return POOL_STATUS_NOT_INITIALIZED;
+    }
+    __DMB();
+
+    // Pushed in reverse so blocks come out in address order.
+    pool_local_t* local = &pool_locals[id];
+    local->head = POOL_INDEX_NONE;
+    local->in_use = 0;
+    uint32_t first = CORE_ID_SELF == CORE_ID_CM7 ? 0 : pool->cm7_blocks;
+    uint32_t end = CORE_ID_SELF == CORE_ID_CM7 ? pool->cm7_blocks : pool->num_blocks;
+    for (uint32_t i = end; i-- > first;) {
+        pool_push(pool, local, i);
+    }
+    return POOL_STATUS_OK;
+}
+
+void* pool_alloc(pool_id_t id) {
+    pool_t* pool = pool_get(id);
+    if (pool == NULL || pool->magic != POOL_MAGIC) {
+        return NULL;
+    }
+
+    pool_local_t* local = &pool_locals[id];
+    pool_stats_t* stats = &pool->stats[CORE_ID_SELF];
+    uint32_t index = pool_pop(pool, local);
+    if (index == POOL_INDEX_NONE) {
+        pool_reclaim(pool, local);
+        index = pool_pop(pool, local);
+    }
+    if (index == POOL_INDEX_NONE) {
+        stats->failures++;
+        return NULL;
+    }
+
+    stats->allocs++;
+    uint32_t in_use = pool_atomic_add(&local->in_use, 1);
+    stats->in_use = in_use;
+    if (in_use > stats->high_water) {
+        stats->high_water = in_use;
+    }
+    return pool_link(pool, index);
+}
+
+void pool_free(pool_id_t id, void* block) {
+    pool_t* pool = pool_get(id);
+    if (pool == NULL || block == NULL || pool->magic != POOL_MAGIC) {
+        return;
+    }
+    uintptr_t offset = (uintptr_t)block - (uintptr_t)pool->storage;
+    uint32_t index = offset / pool->block_size_b;
+    if ((uintptr_t)block < (uintptr_t)pool->storage || index >= pool->num_blocks ||
+        offset % pool->block_size_b != 0) {
+        return;
+    }
+
+    if (pool_home(pool, index) != CORE_ID_SELF) {
+        pool_return(pool, index);
+        return;
+    }
+    pool_push(pool, &pool_locals[id], index);
+    pool->stats[CORE_ID_SELF].in_use = pool_atomic_add(&pool_locals[id].in_use, -1);
+}
+
+void pool_get_stats(pool_id_t id, core_id_t core, pool_stats_t* stats) {
+    pool_t* pool = pool_get(id);
+    if (pool != NULL && stats != NULL && core < CORE_ID_COUNT) {
+        *stats = pool->stats[core];
+    }
+}
@@ -0,0 +1,391 @@
+#include "raster.h"
+
+#include "fast_mem.h"
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#include "stm32h7xx.h"
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Edge functions are evaluated on 4x1 blocks of pixels, within windows of RASTER_WINDOW_PX
+// squared. Each window is classified against each edge first: windows outside any edge are
+// skipped, and edges that contain the whole window drop out of the per-block tests. A crossing
+// edge's values stay within about 2^30 inside a window even for vertices at the int16 limits, so
+// the block loop runs in 32 bits. Blocks outside an edge are skipped, and a row ends early once
+// it leaves the triangle through an edge that only gets further away to the right.
+#define RASTER_BLOCK_PX 4
+#define RASTER_WINDOW_PX 32
+
+// Packed 16-bit lanes for colour interpolation: one word holds R and B, another A and G, each
+// channel as 8.8 fixed point. Lanes wrap independently, so values extrapolated outside the
+// triangle may wrap and come back; only covered pixels, where the value is a weighted mean of the
+// vertex colours, are ever read.
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define raster_add16 __SADD16
+#else
+static inline uint32_t raster_add16(uint32_t a, uint32_t b) {
+    return ((a + b) & 0x0000FFFFUL) | (((a >> 16) + (b >> 16)) << 16);
+}
+#endif
+
+// Triangle-wide edge function a->b, relative to the first sample of the triangle's bounds.
+typedef struct {
+    int64_t origin;  // Biased: positive inside, and pixels on bottom/right edges are outside.
+    int32_t bias;    // 1 where the origin was biased, to recover the true value for attributes.
+    int32_t step_x;  // Per pixel.
+    int32_t step_y;
+} raster_edge_t;
+
+// An edge within one window.
+typedef struct {
+    int32_t value;      // At the window's first sample.
+    int32_t step_x;
+    int32_t step_y;
+    int32_t block_max;  // Added to a block's first sample, gives the block's largest sample.
+    int32_t block_min;  // Likewise the smallest.
+    int32_t dead_end;   // -1 when values only fall to the right, so a rejected block ends the row.
+} raster_window_edge_t;
+
+typedef enum { RASTER_WINDOW_OUT, RASTER_WINDOW_IN, RASTER_WINDOW_CROSSES } raster_window_t;
+
+// Colour gradients, 16.16 per channel in ARGB order. Only the bits that end up in the lanes
+// matter, so these wrap freely too.
+typedef struct {
+    uint32_t origin[4];
+    uint32_t step_x[4];
+    uint32_t step_y[4];
+} raster_shade_t;
+
+static inline int32_t raster_min3(int32_t a, int32_t b, int32_t c) {
+    int32_t m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+static inline int32_t raster_max3(int32_t a, int32_t b, int32_t c) {
+    int32_t m = a > b ? a : b;
+    return m > c ? m : c;
+}
+
+static inline int64_t raster_pos(int64_t v) {
+    return v > 0 ? v : 0;
+}
+
+static inline int64_t raster_neg(int64_t v) {
+    return v < 0 ? v : 0;
+}
+
+// Edge a->b evaluated at (px, py). The value is positive on the inside. Pixels exactly on an edge
+// belong to the triangle only for top and left edges: those are biased by 0, the rest by -1 so a
+// zero becomes "outside".
+static raster_edge_t raster_edge_setup(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t px,
+                                       int32_t py) {
+    int32_t dx = bx - ax;
+    int32_t dy = by - ay;
+    bool top_left = dy < 0 || (dy == 0 && dx > 0);
+    raster_edge_t edge;
+    edge.bias = top_left ? 0 : 1;
+    edge.origin = (int64_t)dx * (py - ay) - (int64_t)dy * (px - ax) - edge.bias;
+    edge.step_x = -dy * RASTER_SUBPIXEL_ONE;
+    edge.step_y = dx * RASTER_SUBPIXEL_ONE;
+    return edge;
+}
+
+// Classifies the window of w x h pixels at (ox, oy) from the bounds' origin against the edge.
+static raster_window_t raster_edge_window(const raster_edge_t* edge, int32_t ox, int32_t oy,
+                                          int32_t w, int32_t h, raster_window_edge_t* out) {
+    int64_t value = edge->origin + (int64_t)edge->step_x * ox + (int64_t)edge->step_y * oy;
+    int64_t span_x = (int64_t)edge->step_x * (w - 1);
+    int64_t span_y = (int64_t)edge->step_y * (h - 1);
+    if (value + raster_pos(span_x) + raster_pos(span_y) < 0) {
+        return RASTER_WINDOW_OUT;
+    }
+    if (value + raster_neg(span_x) + raster_neg(span_y) >= 0) {
+        // Always passes the block tests.
+        *out = (raster_window_edge_t){0};
+        return RASTER_WINDOW_IN;
+    }
+    int32_t block = edge->step_x * (RASTER_BLOCK_PX - 1);
+    out->value = (int32_t)value;
+    out->step_x = edge->step_x;
+    out->step_y = edge->step_y;
+    out->block_max = block > 0 ? block : 0;
+    out->block_min = block < 0 ? block : 0;
+    out->dead_end = edge->step_x <= 0 ? -1 : 0;
+    return RASTER_WINDOW_CROSSES;
+}
+
+static inline void raster_write(uint8_t* dst, pixel_format_t format, uint32_t argb) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            *(uint32_t*)dst = argb;
+            break;
+        case PIXEL_FORMAT_RGB888:
+            dst[0] = (uint8_t)argb;
+            dst[1] = (uint8_t)(argb >> 8);
+            dst[2] = (uint8_t)(argb >> 16);
+            break;
+        case PIXEL_FORMAT_RGB565:
+            *(uint16_t*)dst = (uint16_t)(((argb >> 8) & 0xF800) | ((argb >> 5) & 0x07E0) |
+                                         ((argb >> 3) & 0x001F));
+            break;
+        case PIXEL_FORMAT_L8:
+            dst[0] = (uint8_t)argb;
+            break;
+        default:
+            break;
+    }
+}
+
+// Integer parts of the packed 8.8 lanes, back in ARGB8888 order.
+static inline uint32_t raster_unpack_lanes(uint32_t rb, uint32_t ag) {
+    return (ag & 0xFF00FF00UL) | ((rb >> 8) & 0x00FF00FFUL);
+}
+
+// 16.16 channel values to 8.8 lanes, wrapping like the lanes themselves.
+static inline uint32_t raster_pack_lanes(uint32_t hi, uint32_t lo) {
+    return ((hi >> 8) << 16) | ((lo >> 8) & 0xFFFF);
+}
+
+// Fills the covered pixels of one window. shade is NULL for flat triangles. Flat and shaded
+// loops are separate instantiations, so neither tests for the other per pixel.
+static inline __attribute__((always_inline)) uint32_t
+raster_window(const surface_t* target, const rect_t* window, const raster_window_edge_t* e,
+              uint32_t argb, const raster_shade_t* shade, int32_t ox, int32_t oy) {
+    const int32_t width = window->x1 - window->x0;
+    const uint8_t bpp = pixel_format_bytes(target->format);
+    const pixel_format_t format = target->format;
+    uint32_t pixels = 0;
+
+    uint32_t row[4] = {0};  // 16.16 ARGB at the row's first sample.
+    uint32_t step_rb = 0;
+    uint32_t step_ag = 0;
+    uint32_t block_rb = 0;
+    uint32_t block_ag = 0;
+    if (shade != NULL) {
+        for (uint32_t c = 0; c < 4; c++) {
+            row[c] = shade->origin[c] + shade->step_x[c] * (uint32_t)ox +
+                     shade->step_y[c] * (uint32_t)oy;
+        }
+        // Round the per-pixel steps; over a window that costs well under a quarter of a level.
+        uint32_t s[4];
+        for (uint32_t c = 0; c < 4; c++) {
+            s[c] = shade->step_x[c] + 0x80;
+        }
+        step_rb = raster_pack_lanes(s[1], s[3]);
+        step_ag = raster_pack_lanes(s[0], s[2]);
+        block_rb = step_rb;
+        block_ag = step_ag;
+        for (uint32_t i = 1; i < RASTER_BLOCK_PX; i++) {
+            block_rb = raster_add16(block_rb, step_rb);
+            block_ag = raster_add16(block_ag, step_ag);
+        }
+    }
+
+    int32_t r0 = e[0].value;
+    int32_t r1 = e[1].value;
+    int32_t r2 = e[2].value;
+    for (int16_t y = window->y0; y < window->y1; y++) {
+        int32_t w0 = r0;
+        int32_t w1 = r1;
+        int32_t w2 = r2;
+        uint32_t rb = 0;
+        uint32_t ag = 0;
+        if (shade != NULL) {
+            rb = raster_pack_lanes(row[1], row[3]);
+            ag = raster_pack_lanes(row[0], row[2]);
+        }
+        uint8_t* dst = surface_pixel_addr(target, window->x0, y);
+
+        for (int32_t x = 0; x < width; x += RASTER_BLOCK_PX) {
+            int32_t hi0 = w0 + e[0].block_max;
+            int32_t hi1 = w1 + e[1].block_max;
+            int32_t hi2 = w2 + e[2].block_max;
+            if ((hi0 | hi1 | hi2) < 0) {
+                // Entirely outside an edge.
+                if (((hi0 & e[0].dead_end) | (hi1 & e[1].dead_end) | (hi2 & e[2].dead_end)) < 0) {
+                    break;
+                }
+            } else if (width - x >= RASTER_BLOCK_PX &&
+                       ((w0 + e[0].block_min) | (w1 + e[1].block_min) | (w2 + e[2].block_min)) >=
+                           0) {
+                // Entirely inside.
+                uint8_t* p = dst;
+                if (shade == NULL) {
+                    for (uint32_t i = 0; i < RASTER_BLOCK_PX; i++, p += bpp) {
+                        raster_write(p, format, argb);
+                    }
+                } else {
+                    uint32_t prb = rb;
+                    uint32_t pag = ag;
+                    for (uint32_t i = 0; i < RASTER_BLOCK_PX; i++, p += bpp) {
+                        raster_write(p, format, raster_unpack_lanes(prb, pag));
+                        prb = raster_add16(prb, step_rb);
+                        pag = raster_add16(pag, step_ag);
+                    }
+                }
+                pixels += RASTER_BLOCK_PX;
+            } else {
+                // Straddles an edge, or is cut short by the window: test each pixel.
+                int32_t n = width - x < RASTER_BLOCK_PX ? width - x : RASTER_BLOCK_PX;
+                int32_t v0 = w0;
+                int32_t v1 = w1;
+                int32_t v2 = w2;
+                uint32_t prb = rb;
+                uint32_t pag = ag;
+                uint8_t* p = dst;
+                for (int32_t i = 0; i < n; i++, p += bpp) {
+                    if ((v0 | v1 | v2) >= 0) {
+                        uint32_t color = shade == NULL ? argb : raster_unpack_lanes(prb, pag);
+                        raster_write(p, format, color);
+                        pixels++;
+                    }
+                    v0 += e[0].step_x;
+                    v1 += e[1].step_x;
+                    v2 += e[2].step_x;
+                    if (shade != NULL) {
+                        prb = raster_add16(prb, step_rb);
+                        pag = raster_add16(pag, step_ag);
+                    }
+                }
+            }
+            w0 += e[0].step_x * RASTER_BLOCK_PX;
+            w1 += e[1].step_x * RASTER_BLOCK_PX;
+            w2 += e[2].step_x * RASTER_BLOCK_PX;
+            if (shade != NULL) {
+                rb = raster_add16(rb, block_rb);
+                ag = raster_add16(ag, block_ag);
+            }
+            dst += bpp * RASTER_BLOCK_PX;
+        }
+
+        r0 += e[0].step_y;
+        r1 += e[1].step_y;
+        r2 += e[2].step_y;
+        if (shade != NULL) {
+            for (uint32_t c = 0; c < 4; c++) {
+                row[c] += shade->step_y[c];
+            }
+        }
+    }
+    return pixels;
+}
+
+FAST_CODE static uint32_t raster_window_flat(const surface_t* target, const rect_t* window,
+                                             const raster_window_edge_t* e, uint32_t argb) {
+    return raster_window(target, window, e, argb, NULL, 0, 0);
+}
+
+FAST_CODE static uint32_t raster_window_shaded(const surface_t* target, const rect_t* window,
+                                               const raster_window_edge_t* e,
+                                               const raster_shade_t* shade, int32_t ox,
+                                               int32_t oy) {
+    return raster_window(target, window, e, 0, shade, ox, oy);
+}
+
+// num / den in 16.16. Split so the shift cannot overflow for any int16 vertices.
+static int64_t raster_div16(int64_t num, int64_t den) {
+    return num / den * 65536 + num % den * 65536 / den;
+}
+
+// Colour gradients from the vertex colours. Each channel is the vertices' values weighted by the
+// (unbiased) edge functions opposite them, over twice the area.
+static void raster_shade_setup(raster_shade_t* shade, const raster_edge_t* edges,
+                               const uint32_t* argb, int64_t area2) {
+    for (uint32_t c = 0; c < 4; c++) {
+        uint32_t shift = 24 - 8 * c;
+        int64_t origin = 0;
+        int64_t step_x = 0;
+        int64_t step_y = 0;
+        for (uint32_t v = 0; v < 3; v++) {
+            int64_t value = (argb[v] >> shift) & 0xFF;
+            origin += value * (edges[v].origin + edges[v].bias);
+            step_x += value * edges[v].step_x;
+            step_y += value * edges[v].step_y;
+        }
+        // Bias by half a level so the lanes' integer parts round to nearest.
+        shade->origin[c] = (uint32_t)raster_div16(origin, area2) + 0x8000;
+        shade->step_x[c] = (uint32_t)raster_div16(step_x, area2);
+        shade->step_y[c] = (uint32_t)raster_div16(step_y, area2);
+    }
+}
+
+static uint32_t raster_draw(const surface_t* target, const rect_t* clip, const int32_t* xs,
+                            const int32_t* ys, uint32_t argb, const uint32_t* shade_argb) {
+    raster_tri_t bounds_tri = {{xs[0], xs[1], xs[2]}, {ys[0], ys[1], ys[2]}, 0};
+    int64_t area2 = raster_tri_area2(&bounds_tri);
+    rect_t bounds = raster_tri_bounds(&bounds_tri);
+    bounds = rect_intersect(&bounds, clip);
+    if (area2 <= 0 || rect_is_empty(&bounds)) {
+        return 0;
+    }
+
+    // Edges are opposite their vertex index: e0 = v1->v2, e1 = v2->v0, e2 = v0->v1.
+    int32_t px = bounds.x0 * RASTER_SUBPIXEL_ONE + RASTER_SUBPIXEL_ONE / 2;
+    int32_t py = bounds.y0 * RASTER_SUBPIXEL_ONE + RASTER_SUBPIXEL_ONE / 2;
+    raster_edge_t edges[3] = {
+        raster_edge_setup(xs[1], ys[1], xs[2], ys[2], px, py),
+        raster_edge_setup(xs[2], ys[2], xs[0], ys[0], px, py),
+        raster_edge_setup(xs[0], ys[0], xs[1], ys[1], px, py),
+    };
+    raster_shade_t shade;
+    if (shade_argb != NULL) {
+        raster_shade_setup(&shade, edges, shade_argb, area2);
+    }
+
+    uint32_t pixels = 0;
+    for (int32_t wy = bounds.y0; wy < bounds.y1; wy += RASTER_WINDOW_PX) {
+        for (int32_t wx = bounds.x0; wx < bounds.x1; wx += RASTER_WINDOW_PX) {
+            int32_t wx1 = wx + RASTER_WINDOW_PX < bounds.x1 ? wx + RASTER_WINDOW_PX : bounds.x1;
+            int32_t wy1 = wy + RASTER_WINDOW_PX < bounds.y1 ? wy + RASTER_WINDOW_PX : bounds.y1;
+            rect_t window = {(int16_t)wx, (int16_t)wy, (int16_t)wx1, (int16_t)wy1};
+            int32_t ox = wx - bounds.x0;
+            int32_t oy = wy - bounds.y0;
+            raster_window_edge_t e[3];
+            bool outside = false;
+            for (uint32_t i = 0; i < 3 && !outside; i++) {
+                outside = raster_edge_window(&edges[i], ox, oy, window.x1 - window.x0,
+                                             window.y1 - window.y0, &e[i]) == RASTER_WINDOW_OUT;
+            }
+            if (outside) {
+                continue;
+            }
+            pixels += shade_argb == NULL
+                          ? raster_window_flat(target, &window, e, argb)
+                          : raster_window_shaded(target, &window, e, &shade, ox, oy);
+        }
+    }
+    return pixels;
+}
+
+rect_t raster_tri_bounds(const raster_tri_t* tri) {
+    // A pixel is covered only if its centre (x + 0.5) is, so round the extremes inwards.
+    const int32_t half = RASTER_SUBPIXEL_ONE / 2;
+    int32_t x0 = raster_min3(tri->x[0], tri->x[1], tri->x[2]);
+    int32_t y0 = raster_min3(tri->y[0], tri->y[1], tri->y[2]);
+    int32_t x1 = raster_max3(tri->x[0], tri->x[1], tri->x[2]);
+    int32_t y1 = raster_max3(tri->y[0], tri->y[1], tri->y[2]);
+    rect_t bounds = {
+        (int16_t)((x0 - half + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS),
+        (int16_t)((y0 - half + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS),
+        (int16_t)(((x1 - half) >> RASTER_SUBPIXEL_BITS) + 1),
+        (int16_t)(((y1 - half) >> RASTER_SUBPIXEL_BITS) + 1),
+    };
+    return bounds;
+}
+
+uint32_t raster_triangle(const surface_t* target, const rect_t* clip, const raster_tri_t* tri) {
+    if (target == NULL || clip == NULL || tri == NULL) {
+        return 0;
+    }
+    return raster_draw(target, clip, tri->x, tri->y, tri->argb, NULL);
+}
+
+uint32_t raster_shaded_triangle(const surface_t* target, const rect_t* clip,
+                                const raster_shaded_tri_t* tri) {
+    if (target == NULL || clip == NULL || tri == NULL) {
+        return 0;
+    }
+    return raster_draw(target, clip, tri->x, tri->y, 0, tri->argb);
+}
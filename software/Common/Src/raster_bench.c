@@ -0,0 +1,100 @@
+#include "raster_bench.h"
+
+#include "cycles.h"
+#include "raster.h"
+
+#include <stddef.h>
+
+static const uint16_t raster_bench_sizes[RASTER_BENCH_SIZES] = {8, 32, 128};
+
+// Keeps the generate-only pass from being optimized away.
+static volatile uint32_t raster_bench_sink;
+
+static uint32_t raster_bench_next(uint32_t* seed) {
+    *seed = *seed * 1664525UL + 1013904223UL;
+    return *seed >> 8;
+}
+
+// A triangle with its vertices anywhere in the size x size square at (ox, oy), wound so that
+// its area is positive.
+static raster_shaded_tri_t raster_bench_tri(uint32_t* seed, uint16_t size, int16_t ox, int16_t oy) {
+    raster_shaded_tri_t tri;
+    uint32_t range = (uint32_t)size * RASTER_SUBPIXEL_ONE;
+    for (uint32_t v = 0; v < 3; v++) {
+        tri.x[v] = ox * RASTER_SUBPIXEL_ONE + (int32_t)(raster_bench_next(seed) % range);
+        tri.y[v] = oy * RASTER_SUBPIXEL_ONE + (int32_t)(raster_bench_next(seed) % range);
+        tri.argb[v] = 0xFF000000UL | raster_bench_next(seed);
+    }
+    raster_tri_t flat = {{tri.x[0], tri.x[1], tri.x[2]}, {tri.y[0], tri.y[1], tri.y[2]}, 0};
+    if (raster_tri_area2(&flat) < 0) {
+        int32_t x = tri.x[1];
+        int32_t y = tri.y[1];
+        tri.x[1] = tri.x[2];
+        tri.y[1] = tri.y[2];
+        tri.x[2] = x;
+        tri.y[2] = y;
+    }
+    return tri;
+}
+
+// Draws (or with draw unset, only generates) the case's triangles and returns the cycles taken.
+static uint32_t raster_bench_pass(const surface_t* target, raster_bench_case_t* bench, bool draw) {
+    rect_t clip = surface_bounds(target);
+    uint16_t span_x = (uint16_t)(target->width - bench->size_px + 1);
+    uint16_t span_y = (uint16_t)(target->height - bench->size_px + 1);
+    // Same triangles for flat and shaded, spread over the target so that they do not all hit the
+    // same few cache lines.
+    uint32_t seed = bench->size_px;
+    uint32_t pixels = 0;
+
+    uint32_t start = cycles_now();
+    for (uint32_t i = 0; i < RASTER_BENCH_TRIS; i++) {
+        int16_t ox = (int16_t)(raster_bench_next(&seed) % span_x);
+        int16_t oy = (int16_t)(raster_bench_next(&seed) % span_y);
+        raster_shaded_tri_t tri = raster_bench_tri(&seed, bench->size_px, ox, oy);
+        if (!draw) {
+            raster_bench_sink = (uint32_t)tri.x[0];
+        } else if (bench->shaded) {
+            pixels += raster_shaded_triangle(target, &clip, &tri);
+        } else {
+            raster_tri_t flat = {{tri.x[0], tri.x[1], tri.x[2]},
+                                 {tri.y[0], tri.y[1], tri.y[2]},
+                                 tri.argb[0]};
+            pixels += raster_triangle(target, &clip, &flat);
+        }
+    }
+    uint32_t cycles = cycles_now() - start;
+    if (draw) {
+        bench->pixels = pixels;
+    }
+    return cycles;
+}
+
+bool raster_bench_run(const surface_t* target, raster_bench_result_t* result) {
+    if (target == NULL || result == NULL ||
+        target->width < raster_bench_sizes[RASTER_BENCH_SIZES - 1] ||
+        target->height < raster_bench_sizes[RASTER_BENCH_SIZES - 1]) {
+        return false;
+    }
+    *result = (raster_bench_result_t){0};
+    cycles_init();
+
+    for (uint32_t c = 0; c < RASTER_BENCH_CASES; c++) {
+        raster_bench_case_t* bench = &result->cases[c];
+        bench->size_px = raster_bench_sizes[c % RASTER_BENCH_SIZES];
+        bench->shaded = c >= RASTER_BENCH_SIZES;
+        bench->tris = RASTER_BENCH_TRIS;
+
+        // Generating the triangles is not part of the rasterizer's cost.
+        uint32_t overhead = raster_bench_pass(target, bench, false);
+        uint32_t total = raster_bench_pass(target, bench, true);
+        bench->cycles = total > overhead ? total - overhead : 0;
+        if (bench->cycles != 0) {
+            bench->tris_per_s =
+                (uint32_t)((uint64_t)bench->tris * cycles_per_second() / bench->cycles);
+            bench->pixels_per_s =
+                (uint32_t)((uint64_t)bench->pixels * cycles_per_second() / bench->cycles);
+        }
+    }
+    return true;
+}
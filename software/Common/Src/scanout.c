@@ -0,0 +1,667 @@
+#include "scanout.h"
+
+#if defined(CORE_CM7)
+
+#include "boot.h"
+#include "cache_maint.h"
+#include "fence.h"
+#include "mem_map.h"
+#include "stm32h7xx_hal.h"
+
+#include <stddef.h>
+
+#define SCANOUT_IRQ_PRIORITY 4
+
+// PLL3 input range 2-4 MHz with the wide VCO (192-836 MHz). R then divides the VCO down to the
+// pixel clock, and the fractional N makes up the rest.
+#define SCANOUT_PLL_REF_HZ 2000000UL
+#define SCANOUT_PLL_VCO_MIN_HZ 192000000UL
+#define SCANOUT_PLL_VCO_MAX_HZ 836000000UL
+#define SCANOUT_PLL_FRAC_ONE 8192UL
+#define SCANOUT_PLL_N_MIN 4UL
+#define SCANOUT_PLL_N_MAX 512UL
+#define SCANOUT_PLL_R_MAX 128UL
+
+// On the H7 the line length register wants the line's size in bytes plus 7.
+#define SCANOUT_LINE_LENGTH_EXTRA_B 7
+
+// Blend the layer by its pixel alpha times the constant alpha, which is left fully opaque.
+#define SCANOUT_BLEND_PIXEL_ALPHA ((6UL << LTDC_LxBFCR_BF1_Pos) | 7UL)
+
+typedef struct {
+    GPIO_TypeDef* port;
+    uint32_t pins;
+    uint8_t alternate;
+} scanout_pin_t;
+
+// LTDC pins as routed on the board (see the rev-2 schematic).
+static const scanout_pin_t scanout_pins[] = {
+    {GPIOA, GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6 | GPIO_PIN_9 | GPIO_PIN_10,
+     GPIO_AF14_LTDC},                                    // B5, VSYNC, R4, G2, R5, B4
+    {GPIOA, GPIO_PIN_8, GPIO_AF13_LTDC},                 // B3
+    {GPIOB, GPIO_PIN_0 | GPIO_PIN_1, GPIO_AF9_LTDC},     // R3, R6
+    {GPIOB, GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11, GPIO_AF14_LTDC},  // B6, B7, G4, G5
+    {GPIOC, GPIO_PIN_6, GPIO_AF14_LTDC},                 // HSYNC
+    {GPIOF, GPIO_PIN_10, GPIO_AF14_LTDC},                // DE
+    {GPIOG, GPIO_PIN_6 | GPIO_PIN_7, GPIO_AF14_LTDC},    // R7, CLK
+    {GPIOJ, GPIO_PIN_10, GPIO_AF14_LTDC},                // G3
+    {GPIOK, GPIO_PIN_1 | GPIO_PIN_2, GPIO_AF14_LTDC},    // G6, G7
+};
+
+typedef struct {
+    bool active;
+    scanout_strip_config_t config;
+    uint8_t* buffer;
+    uint32_t stride_b;
+    uint32_t strip_b;
+    uint16_t per_frame;          // Strips per frame.
+    uint16_t event;              // Boundary the line interrupt waits for, 0 .. per_frame.
+    volatile uint32_t done;      // Strips scanned out so far. Written by the line interrupt.
+    volatile uint32_t rendered;  // Strips rendered or skipped so far. Written by the poll.
+} scanout_strips_t;
+
+typedef struct {
+    bool initialized;
+    volatile bool running;
+    video_timing_t timing;
+    int16_t x;
+    int16_t y;
+    volatile uint32_t queued;  // Sequence number of the last flip requested.
+    fence_t flips;             // Sequence number of the last flip latched.
+    uint32_t palette[SCANOUT_PALETTE_SIZE];
+    uint16_t palette_first;    // Entries palette_first .. palette_end - 1 are not loaded yet.
+    uint16_t palette_end;
+    volatile uint32_t palette_queued;  // Sequence number of the last palette change.
+    fence_t palettes;                  // Sequence number of the last palette change loaded.
+    scanout_strips_t strips;
+    scanout_stats_t stats;
+} scanout_t;
+
+static scanout_t scanout;
+
+static LTDC_Layer_TypeDef* const scanout_layer = LTDC_Layer1;
+
+/***** HELPERS *****/
+
+static bool scanout_indexed(pixel_format_t format) {
+    return format == PIXEL_FORMAT_L8 || format == PIXEL_FORMAT_AL44 || format == PIXEL_FORMAT_AL88;
+}
+
+static scanout_status_t scanout_check_timing(const video_timing_t* timing) {
+    if (timing->pixel_clock_khz == 0 || (timing->flags & VIDEO_TIMING_FLAG_INTERLACED) != 0 ||
+        timing->h_active == 0 || timing->h_sync == 0 || timing->v_active == 0 ||
+        timing->v_sync == 0 ||
+        video_timing_h_total(timing) - 1 > (LTDC_TWCR_TOTALW_Msk >> LTDC_TWCR_TOTALW_Pos) ||
+        video_timing_v_total(timing) - 1 > (LTDC_TWCR_TOTALH_Msk >> LTDC_TWCR_TOTALH_Pos)) {
+        return SCANOUT_STATUS_BAD_TIMING;
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+static scanout_status_t scanout_check_surface(const surface_t* surface,
+                                              const video_timing_t* timing, int16_t x, int16_t y) {
+    uint32_t line_b = (uint32_t)surface->width * pixel_format_bytes(surface->format);
+    if (surface->pixels == NULL || surface->format > PIXEL_FORMAT_AL88 || surface->width == 0 ||
+        surface->height == 0 || x < 0 || y < 0 ||
+        (uint32_t)x + surface->width > timing->h_active ||
+        (uint32_t)y + surface->height > timing->v_active ||
+        line_b + SCANOUT_LINE_LENGTH_EXTRA_B > (LTDC_LxCFBLR_CFBLL_Msk >> LTDC_LxCFBLR_CFBLL_Pos) ||
+        surface->stride_b < line_b ||
+        surface->stride_b > (LTDC_LxCFBLR_CFBP_Msk >> LTDC_LxCFBLR_CFBP_Pos)) {
+        return SCANOUT_STATUS_BAD_SURFACE;
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+// Picks PLL3 dividers for the pixel clock and returns the clock they actually give, or 0.
+static uint32_t scanout_set_pixel_clock(uint32_t pixel_clock_hz) {
+    if (__HAL_RCC_GET_PLL_OSCSOURCE() != RCC_PLLSOURCE_HSI) {
+        return 0;
+    }
+    uint32_t hsi_hz = HSI_VALUE >> ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos);
+    uint32_t m = hsi_hz / SCANOUT_PLL_REF_HZ;
+    uint32_t ref_hz = hsi_hz / m;
+    uint32_t r = (SCANOUT_PLL_VCO_MIN_HZ + pixel_clock_hz - 1) / pixel_clock_hz;
+    uint64_t vco_hz = (uint64_t)pixel_clock_hz * r;
+    if (r > SCANOUT_PLL_R_MAX || vco_hz > SCANOUT_PLL_VCO_MAX_HZ) {
+        return 0;
+    }
+
+    uint32_t n = (uint32_t)(vco_hz / ref_hz);
+    uint32_t frac = (uint32_t)(((vco_hz % ref_hz) * SCANOUT_PLL_FRAC_ONE + ref_hz / 2) / ref_hz);
+    if (frac == SCANOUT_PLL_FRAC_ONE) {
+        n++;
+        frac = 0;
+    }
+    if (n < SCANOUT_PLL_N_MIN || n > SCANOUT_PLL_N_MAX) {
+        return 0;
+    }
+
+    RCC_PeriphCLKInitTypeDef clocks = {0};
+    clocks.PeriphClockSelection = RCC_PERIPHCLK_LTDC;
+    clocks.PLL3.PLL3M = m;
+    clocks.PLL3.PLL3N = n;
+    clocks.PLL3.PLL3P = 2;
+    clocks.PLL3.PLL3Q = 2;
+    clocks.PLL3.PLL3R = r;
+    clocks.PLL3.PLL3RGE = RCC_PLL3VCIRANGE_1;
+    clocks.PLL3.PLL3VCOSEL = RCC_PLL3VCOWIDE;
+    clocks.PLL3.PLL3FRACN = frac;
+    if (HAL_RCCEx_PeriphCLKConfig(&clocks) != HAL_OK) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)ref_hz * (n * SCANOUT_PLL_FRAC_ONE + frac) /
+                      (SCANOUT_PLL_FRAC_ONE * r));
+}
+
+// Writes a layer's shadow registers to show surface at (x, y) in the active area; they take
+// effect at the next reload.
+static void scanout_program_layer(LTDC_Layer_TypeDef* layer, const surface_t* surface, int16_t x,
+                                  int16_t y) {
+    const video_timing_t* timing = &scanout.timing;
+    uint32_t h_start = (uint32_t)timing->h_sync + timing->h_back_porch + x;
+    uint32_t v_start = (uint32_t)timing->v_sync + timing->v_back_porch + y;
+    uint32_t line_b = (uint32_t)surface->width * pixel_format_bytes(surface->format);
+
+    layer->WHPCR = ((h_start + surface->width) << LTDC_LxWHPCR_WHSPPOS_Pos) | (h_start + 1);
+    layer->WVPCR = ((v_start + surface->height) << LTDC_LxWVPCR_WVSPPOS_Pos) | (v_start + 1);
+    layer->PFCR = surface->format;
+    layer->CFBAR = (uint32_t)surface->pixels;
+    layer->CFBLR = (surface->stride_b << LTDC_LxCFBLR_CFBP_Pos) |
+                   (line_b + SCANOUT_LINE_LENGTH_EXTRA_B);
+    layer->CFBLNR = surface->height;
+    layer->CR = LTDC_LxCR_LEN | (scanout_indexed(surface->format) ? LTDC_LxCR_CLUTEN : 0);
+}
+
+static void scanout_set_blending(LTDC_Layer_TypeDef* layer) {
+    layer->CACR = 0xFF;
+    layer->DCCR = 0;
+    layer->BFCR = SCANOUT_BLEND_PIXEL_ALPHA;
+}
+
+/***** PALETTE *****/
+
+// Writes the entries changed since the last load to both layers' CLUTs. Only while neither layer
+// is being scanned: in vertical blanking, or with the LTDC off.
+static void scanout_load_palette(void) {
+    uint16_t first = scanout.palette_first;
+    uint16_t end = scanout.palette_end;
+    for (uint32_t i = first; i < end; i++) {
+        uint32_t entry = (i << LTDC_LxCLUTWR_CLUTADD_Pos) | scanout.palette[i];
+        LTDC_Layer1->CLUTWR = entry;
+        LTDC_Layer2->CLUTWR = entry;
+    }
+    if (first < end) {
+        scanout.stats.palette_updates++;
+        scanout.stats.palette_entries += (uint32_t)(end - first);
+    }
+    scanout.palette_first = SCANOUT_PALETTE_SIZE;
+    scanout.palette_end = 0;
+    if (!fence_reached(&scanout.palettes, scanout.palette_queued)) {
+        fence_signal(&scanout.palettes, scanout.palette_queued);
+    }
+}
+
+// Records that entries first .. end - 1 changed and returns the change's sequence number. In
+// framebuffer mode the line interrupt is only enabled for the first frame and while a change
+// waits for vertical blanking; strip mode has it on anyway. Call with the LTDC interrupt masked.
+static uint32_t scanout_palette_changed(uint16_t first, uint16_t end) {
+    if (first < end) {
+        scanout.palette_first = first < scanout.palette_first ? first : scanout.palette_first;
+        scanout.palette_end = end > scanout.palette_end ? end : scanout.palette_end;
+    }
+    uint32_t next = scanout.palette_queued + 1;
+    scanout.palette_queued = next;
+    if (!scanout.running) {
+        // Loaded in full when scan-out starts.
+        fence_signal(&scanout.palettes, next);
+    } else if (!scanout.strips.active) {
+        LTDC->LIPCR = (uint32_t)scanout.timing.v_sync + scanout.timing.v_back_porch +
+                      scanout.timing.v_active;
+        LTDC->IER |= LTDC_IER_LIE;
+    }
+    return next;
+}
+
+static void scanout_reverse(uint32_t* entries, uint32_t count) {
+    for (uint32_t i = 0, j = count; i + 1 < j; i++, j--) {
+        uint32_t t = entries[i];
+        entries[i] = entries[j - 1];
+        entries[j - 1] = t;
+    }
+}
+
+// Stops any previous scan-out and sets up the clock and timing registers, leaving the LTDC off.
+static scanout_status_t scanout_setup(const video_timing_t* timing) {
+    // The pixel clock can only change while the LTDC is off.
+    scanout_stop();
+    uint32_t pixel_clock_hz = scanout_set_pixel_clock(timing->pixel_clock_khz * 1000);
+    if (pixel_clock_hz == 0) {
+        return SCANOUT_STATUS_CLOCK_ERR;
+    }
+    scanout.stats.pixel_clock_hz = pixel_clock_hz;
+    scanout.timing = *timing;
+    scanout.palette_first = 0;
+    scanout.palette_end = SCANOUT_PALETTE_SIZE;
+    scanout_load_palette();
+
+    // Each register holds the last pixel/line of its region, counted from the start of sync.
+    uint32_t hbp = (uint32_t)timing->h_sync + timing->h_back_porch;
+    uint32_t vbp = (uint32_t)timing->v_sync + timing->v_back_porch;
+    LTDC->SSCR = ((timing->h_sync - 1UL) << LTDC_SSCR_HSW_Pos) | (timing->v_sync - 1UL);
+    LTDC->BPCR = ((hbp - 1) << LTDC_BPCR_AHBP_Pos) | (vbp - 1);
+    LTDC->AWCR = ((hbp + timing->h_active - 1) << LTDC_AWCR_AAW_Pos) | (vbp + timing->v_active - 1);
+    LTDC->TWCR = ((video_timing_h_total(timing) - 1) << LTDC_TWCR_TOTALW_Pos) |
+                 (video_timing_v_total(timing) - 1);
+    LTDC->BCCR = SCANOUT_BACKGROUND_RGB;
+
+    // The SiI1136 wants an active-high DE and samples on the rising clock edge, so data is
+    // launched on the falling one.
+    uint32_t gcr = LTDC_GCR_DEPOL | LTDC_GCR_PCPOL;
+    gcr |= (timing->flags & VIDEO_TIMING_FLAG_HSYNC_POS) ? LTDC_GCR_HSPOL : 0;
+    gcr |= (timing->flags & VIDEO_TIMING_FLAG_VSYNC_POS) ? LTDC_GCR_VSPOL : 0;
+    LTDC->GCR = gcr;
+    return SCANOUT_STATUS_OK;
+}
+
+/***** STRIPS *****/
+
+// Strips are numbered from the start of strip mode: strip seq is line (seq % per_frame) *
+// strip_lines of frame seq / per_frame, lives in buffer seq % num_strips and is shown by layer
+// seq % 2.
+static surface_t scanout_strip_surface(uint32_t seq, uint16_t* row) {
+    const scanout_strips_t* strips = &scanout.strips;
+    const scanout_strip_config_t* config = &strips->config;
+    *row = (uint16_t)((seq % strips->per_frame) * config->strip_lines);
+    uint16_t left = (uint16_t)(config->height - *row);
+    surface_t strip = {
+        .pixels = strips->buffer + (seq % config->num_strips) * strips->strip_b,
+        .width = config->width,
+        .height = left < config->strip_lines ? left : config->strip_lines,
+        .stride_b = strips->stride_b,
+        .format = config->format,
+    };
+    return strip;
+}
+
+static void scanout_strip_arm(uint32_t seq) {
+    uint16_t row;
+    surface_t strip = scanout_strip_surface(seq, &row);
+    scanout_program_layer((seq & 1) ? LTDC_Layer2 : LTDC_Layer1, &strip,
+                          scanout.strips.config.x, (int16_t)(scanout.strips.config.y + row));
+}
+
+// LTDC line of strip boundary event: the first line of that strip, or for event per_frame the
+// first line of vertical blanking. The palette is loaded there, so that has to be past the
+// active area rather than just past the strips, which may end above its bottom.
+static uint32_t scanout_strip_line(uint16_t event) {
+    const scanout_strip_config_t* config = &scanout.strips.config;
+    uint32_t vbp = (uint32_t)scanout.timing.v_sync + scanout.timing.v_back_porch;
+    if (event >= scanout.strips.per_frame) {
+        return vbp + scanout.timing.v_active;
+    }
+    return vbp + config->y + (uint32_t)event * config->strip_lines;
+}
+
+// Runs at each strip boundary, as the scan leaves one strip and enters the next, and at vertical
+// blanking after the last one.
+static void scanout_strip_irq(void) {
+    scanout_strips_t* strips = &scanout.strips;
+    uint16_t event = strips->event;
+    if (event > 0) {
+        // Strip done has been scanned: its buffer is free, and its layer takes the strip after
+        // the one starting now. The other layer's registers are unchanged, so reloading them
+        // immediately does not disturb it.
+        uint32_t done = strips->done;
+        scanout_strip_arm(done + 2);
+        LTDC->SRCR = LTDC_SRCR_IMR;
+        strips->done = done + 1;
+    }
+    if (event < strips->per_frame) {
+        if (strips->rendered <= strips->done) {
+            scanout.stats.strip_misses++;
+        }
+        strips->event = (uint16_t)(event + 1);
+    } else {
+        scanout.stats.strip_frames++;
+        strips->event = 0;
+        scanout_load_palette();
+        boot_mark(BOOT_MARK_FIRST_PIXEL);
+    }
+    LTDC->LIPCR = scanout_strip_line(strips->event);
+}
+
+/***** PUBLIC API *****/
+
+scanout_status_t scanout_init(void) {
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_GPIOF_CLK_ENABLE();
+    __HAL_RCC_GPIOG_CLK_ENABLE();
+    __HAL_RCC_GPIOJ_CLK_ENABLE();
+    __HAL_RCC_GPIOK_CLK_ENABLE();
+    for (size_t i = 0; i < sizeof(scanout_pins) / sizeof(scanout_pins[0]); i++) {
+        GPIO_InitTypeDef init = {0};
+        init.Pin = scanout_pins[i].pins;
+        init.Mode = GPIO_MODE_AF_PP;
+        init.Pull = GPIO_NOPULL;
+        init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+        init.Alternate = scanout_pins[i].alternate;
+        HAL_GPIO_Init(scanout_pins[i].port, &init);
+    }
+
+    __HAL_RCC_LTDC_CLK_ENABLE();
+    __HAL_RCC_LTDC_FORCE_RESET();
+    __HAL_RCC_LTDC_RELEASE_RESET();
+
+    scanout.running = false;
+    scanout.queued = 0;
+    scanout.stats = (scanout_stats_t){0};
+    fence_init(&scanout.flips, FENCE_NO_DOORBELL);
+    for (uint32_t i = 0; i < SCANOUT_PALETTE_SIZE; i++) {
+        scanout.palette[i] = i * 0x010101UL;
+    }
+    scanout.palette_first = 0;
+    scanout.palette_end = SCANOUT_PALETTE_SIZE;
+    scanout.palette_queued = 0;
+    fence_init(&scanout.palettes, FENCE_NO_DOORBELL);
+
+    HAL_NVIC_SetPriority(LTDC_IRQn, SCANOUT_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(LTDC_IRQn);
+    HAL_NVIC_SetPriority(LTDC_ER_IRQn, SCANOUT_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(LTDC_ER_IRQn);
+    scanout.initialized = true;
+    return SCANOUT_STATUS_OK;
+}
+
+scanout_status_t scanout_start(const video_timing_t* timing, const surface_t* surface, int16_t x,
+                               int16_t y) {
+    if (timing == NULL || surface == NULL) {
+        return SCANOUT_STATUS_NULL_ARG;
+    } else if (!scanout.initialized) {
+        return SCANOUT_STATUS_NOT_RUNNING;
+    }
+    scanout_status_t status = scanout_check_timing(timing);
+    if (status == SCANOUT_STATUS_OK) {
+        status = scanout_check_surface(surface, timing, x, y);
+    }
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+
+    status = scanout_setup(timing);
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+    scanout.x = x;
+    scanout.y = y;
+
+    scanout_program_layer(scanout_layer, surface, x, y);
+    scanout_set_blending(scanout_layer);
+    LTDC_Layer2->CR = 0;
+    // The immediate reload raises the reload flag too; let it finish and clear it so it cannot
+    // complete the first flip early.
+    LTDC->SRCR = LTDC_SRCR_IMR;
+    while (LTDC->SRCR & LTDC_SRCR_IMR) {
+    }
+
+    // The line interrupt marks the end of the first frame, then stays off until a palette change.
+    LTDC->LIPCR = (uint32_t)timing->v_sync + timing->v_back_porch + timing->v_active;
+    LTDC->ICR = LTDC_ICR_CLIF | LTDC_ICR_CRRIF | LTDC_ICR_CFUIF | LTDC_ICR_CTERRIF;
+    LTDC->IER = LTDC_IER_LIE | LTDC_IER_RRIE | LTDC_IER_FUIE | LTDC_IER_TERRIE;
+    scanout.running = true;
+    LTDC->GCR |= LTDC_GCR_LTDCEN;
+    return SCANOUT_STATUS_OK;
+}
+
+scanout_status_t scanout_start_strips(const video_timing_t* timing,
+                                      const scanout_strip_config_t* config, void* buffer,
+                                      uint32_t size_b) {
+    if (timing == NULL || config == NULL || buffer == NULL || config->render == NULL) {
+        return SCANOUT_STATUS_NULL_ARG;
+    } else if (!scanout.initialized) {
+        return SCANOUT_STATUS_NOT_RUNNING;
+    }
+    scanout_status_t status = scanout_check_timing(timing);
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+    // The whole area as one surface, to check it fits the active area and the LTDC's registers.
+    uint32_t stride_b = (uint32_t)config->width * pixel_format_bytes(config->format);
+    surface_t area = {buffer, config->width, config->height, stride_b, config->format};
+    status = scanout_check_surface(&area, timing, config->x, config->y);
+    uint32_t strip_b = stride_b * config->strip_lines;
+    uintptr_t addr = (uintptr_t)buffer;
+    if (status == SCANOUT_STATUS_OK &&
+        (config->num_strips < SCANOUT_MIN_STRIPS || config->num_strips > SCANOUT_MAX_STRIPS ||
+         config->strip_lines == 0 || config->height <= config->strip_lines ||
+         size_b < strip_b * config->num_strips ||
+         (addr >= DTCM_BASE && addr < DTCM_BASE + DTCM_SIZE))) {
+        // Too few strips per frame for the two layers to alternate, or no room for the ring.
+        status = SCANOUT_STATUS_BAD_SURFACE;
+    }
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+
+    status = scanout_setup(timing);
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+    scanout_strips_t* strips = &scanout.strips;
+    *strips = (scanout_strips_t){
+        .config = *config,
+        .buffer = buffer,
+        .stride_b = stride_b,
+        .strip_b = strip_b,
+        .per_frame = (uint16_t)((config->height + config->strip_lines - 1) / config->strip_lines),
+    };
+    scanout.x = config->x;
+    scanout.y = config->y;
+    scanout.stats.strip_min_lead = UINT32_MAX;
+
+    // Fill the ring, then let the first two strips' layers wait for the scan.
+    strips->active = true;
+    scanout_strip_poll();
+    scanout_strip_arm(0);
+    scanout_strip_arm(1);
+    scanout_set_blending(LTDC_Layer1);
+    scanout_set_blending(LTDC_Layer2);
+    LTDC->SRCR = LTDC_SRCR_IMR;
+    while (LTDC->SRCR & LTDC_SRCR_IMR) {
+    }
+
+    LTDC->LIPCR = scanout_strip_line(0);
+    LTDC->ICR = LTDC_ICR_CLIF | LTDC_ICR_CRRIF | LTDC_ICR_CFUIF | LTDC_ICR_CTERRIF;
+    LTDC->IER = LTDC_IER_LIE | LTDC_IER_FUIE | LTDC_IER_TERRIE;
+    scanout.running = true;
+    LTDC->GCR |= LTDC_GCR_LTDCEN;
+    return SCANOUT_STATUS_OK;
+}
+
+scanout_status_t scanout_stop(void) {
+    scanout.strips.active = false;
+    if (!scanout.running) {
+        return SCANOUT_STATUS_NOT_RUNNING;
+    }
+    LTDC->IER = 0;
+    LTDC->GCR &= ~LTDC_GCR_LTDCEN;
+    scanout.running = false;
+
+    // Nothing is scanned any more, so a flip still waiting for its reload is as good as done,
+    // and a palette change will be loaded when scan-out starts again.
+    if (!fence_reached(&scanout.flips, scanout.queued)) {
+        fence_signal(&scanout.flips, scanout.queued);
+    }
+    if (!fence_reached(&scanout.palettes, scanout.palette_queued)) {
+        fence_signal(&scanout.palettes, scanout.palette_queued);
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+bool scanout_running(void) {
+    return scanout.running;
+}
+
+scanout_status_t scanout_flip(const surface_t* surface, uint32_t* seq) {
+    if (surface == NULL) {
+        return SCANOUT_STATUS_NULL_ARG;
+    } else if (!scanout.running) {
+        return SCANOUT_STATUS_NOT_RUNNING;
+    } else if (scanout.strips.active) {
+        return SCANOUT_STATUS_WRONG_MODE;
+    } else if (scanout_flip_pending()) {
+        // Only one set of shadow registers: overwriting them now could latch half of each flip.
+        scanout.stats.busy++;
+        return SCANOUT_STATUS_BUSY;
+    }
+    scanout_status_t status = scanout_check_surface(surface, &scanout.timing, scanout.x, scanout.y);
+    if (status != SCANOUT_STATUS_OK) {
+        return status;
+    }
+
+    scanout_program_layer(scanout_layer, surface, scanout.x, scanout.y);
+    uint32_t next = scanout.queued + 1;
+    scanout.queued = next;
+    __DSB();
+    LTDC->SRCR = LTDC_SRCR_VBR;
+    if (seq != NULL) {
+        *seq = next;
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+// Pending until the reload interrupt has run, not just until the LTDC clears VBR, so a flip
+// queued between the two can never be mistaken for the one that was latched.
+bool scanout_flip_pending(void) {
+    return !fence_reached(&scanout.flips, scanout.queued);
+}
+
+bool scanout_flip_done(uint32_t seq) {
+    return fence_reached(&scanout.flips, seq);
+}
+
+scanout_status_t scanout_wait_flip(uint32_t seq, uint32_t timeout_us) {
+    return fence_wait(&scanout.flips, seq, timeout_us) == FENCE_STATUS_OK ? SCANOUT_STATUS_OK
+                                                                          : SCANOUT_STATUS_TIMEOUT;
+}
+
+uint32_t scanout_strip_poll(void) {
+    scanout_strips_t* strips = &scanout.strips;
+    if (!strips->active) {
+        return 0;
+    }
+    uint32_t count = 0;
+    for (;;) {
+        uint32_t done = strips->done;
+        uint32_t seq = strips->rendered;
+        if (seq < done) {
+            // Already scanned out (a miss): drawing it now would only delay the next ones.
+            scanout.stats.strip_skips += done - seq;
+            strips->rendered = done;
+            continue;
+        } else if (seq - done >= strips->config.num_strips) {
+            break;  // Its buffer still holds a strip that has not been shown yet.
+        }
+        uint16_t row;
+        surface_t strip = scanout_strip_surface(seq, &row);
+        strips->config.render(&strip, row, seq / strips->per_frame, strips->config.user);
+        rect_t bounds = surface_bounds(&strip);
+        cache_maint_rects(&strip, &bounds, 1, CACHE_MAINT_CLEAN);
+        __DSB();
+        strips->rendered = seq + 1;
+
+        // How far ahead of the scan this strip was finished, in strips.
+        uint32_t now = strips->done;
+        uint32_t lead = seq > now ? seq - now : 0;
+        if (scanout.running && lead < scanout.stats.strip_min_lead) {
+            scanout.stats.strip_min_lead = lead;
+        }
+        scanout.stats.strips++;
+        count++;
+    }
+    return count;
+}
+
+scanout_status_t scanout_set_palette(const uint32_t* rgb, uint16_t first, uint16_t count,
+                                     uint32_t* seq) {
+    if (rgb == NULL) {
+        return SCANOUT_STATUS_NULL_ARG;
+    } else if ((uint32_t)first + count > SCANOUT_PALETTE_SIZE) {
+        return SCANOUT_STATUS_BAD_PALETTE;
+    }
+    HAL_NVIC_DisableIRQ(LTDC_IRQn);
+    for (uint32_t i = 0; i < count; i++) {
+        scanout.palette[first + i] = rgb[i] & 0x00FFFFFFUL;
+    }
+    uint32_t next = scanout_palette_changed(first, (uint16_t)(first + count));
+    HAL_NVIC_EnableIRQ(LTDC_IRQn);
+    if (seq != NULL) {
+        *seq = next;
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+scanout_status_t scanout_rotate_palette(uint16_t first, uint16_t count, int16_t step,
+                                        uint32_t* seq) {
+    if ((uint32_t)first + count > SCANOUT_PALETTE_SIZE) {
+        return SCANOUT_STATUS_BAD_PALETTE;
+    }
+    HAL_NVIC_DisableIRQ(LTDC_IRQn);
+    if (count > 1) {
+        // Moving every entry up by shift: reverse the range, then both of its parts.
+        uint32_t shift = (uint32_t)((step % (int32_t)count + (int32_t)count) % (int32_t)count);
+        uint32_t* entries = &scanout.palette[first];
+        scanout_reverse(entries, count);
+        scanout_reverse(entries, shift);
+        scanout_reverse(entries + shift, count - shift);
+    }
+    uint32_t next = scanout_palette_changed(first, (uint16_t)(first + count));
+    HAL_NVIC_EnableIRQ(LTDC_IRQn);
+    if (seq != NULL) {
+        *seq = next;
+    }
+    return SCANOUT_STATUS_OK;
+}
+
+bool scanout_palette_done(uint32_t seq) {
+    return fence_reached(&scanout.palettes, seq);
+}
+
+scanout_status_t scanout_wait_palette(uint32_t seq, uint32_t timeout_us) {
+    return fence_wait(&scanout.palettes, seq, timeout_us) == FENCE_STATUS_OK
+               ? SCANOUT_STATUS_OK
+               : SCANOUT_STATUS_TIMEOUT;
+}
+
+void scanout_get_stats(scanout_stats_t* stats) {
+    if (stats != NULL) {
+        *stats = scanout.stats;
+    }
+}
+
+void scanout_irq(void) {
+    uint32_t isr = LTDC->ISR;
+    LTDC->ICR = isr & (LTDC_ISR_LIF | LTDC_ISR_RRIF | LTDC_ISR_FUIF | LTDC_ISR_TERRIF);
+    if ((isr & LTDC_ISR_LIF) && scanout.strips.active) {
+        scanout_strip_irq();
+    } else if (isr & LTDC_ISR_LIF) {
+        // Vertical blanking after the first frame, or with a palette change waiting.
+        scanout_load_palette();
+        boot_mark(BOOT_MARK_FIRST_PIXEL);
+        LTDC->IER &= ~LTDC_IER_LIE;
+    }
+    if (isr & LTDC_ISR_FUIF) {
+        scanout.stats.underruns++;
+    }
+    if (isr & LTDC_ISR_TERRIF) {
+        scanout.stats.transfer_errors++;
+    }
+    if ((isr & LTDC_ISR_RRIF) && scanout.running && scanout_flip_pending()) {
+        scanout.stats.flips++;
+        fence_signal(&scanout.flips, scanout.queued);
+    }
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "shared_mem.h"
+
+#include "stm32h7xx_hal.h"
+
+#include <string.h>
+
+shared_mem_t shared_mem __attribute__((section(".shared")));
+
+shared_mem_status_t shared_mem_init(void) {
+    memset(&shared_mem, 0, sizeof(shared_mem));
+
+    shared_mem.header.version = SHARED_MEM_VERSION;
+    shared_mem.header.size_b = sizeof(shared_mem);
+    shared_mem.header.address = (uintptr_t)&shared_mem;
+    shared_mem.header.cm7_state = SHARED_MEM_CORE_READY;
+
+    // Magic goes last so the CM4 never sees a half-written header.
+    __DMB();
+    shared_mem.header.magic = SHARED_MEM_MAGIC;
+    __DSB();
+
+    return SHARED_MEM_STATUS_OK;
+}
+
+shared_mem_status_t shared_mem_attach(void) {
+    shared_mem_status_t status = SHARED_MEM_STATUS_OK;
+    if (shared_mem.header.magic != SHARED_MEM_MAGIC ||
+        shared_mem.header.cm7_state != SHARED_MEM_CORE_READY) {
+        status = SHARED_MEM_STATUS_BAD_MAGIC;
+    } else if (shared_mem.header.version != SHARED_MEM_VERSION) {
+        status = SHARED_MEM_STATUS_BAD_VERSION;
+    } else if (shared_mem.header.size_b != sizeof(shared_mem) ||
+               shared_mem.header.address != (uintptr_t)&shared_mem) {
+        status = SHARED_MEM_STATUS_BAD_LAYOUT;
+    }
+
+    __DMB();
+    shared_mem.header.cm4_state =
+        status == SHARED_MEM_STATUS_OK ? SHARED_MEM_CORE_READY : SHARED_MEM_CORE_FAILED;
+    __DSB();
+
+    return status;
+}
+
+shared_mem_status_t shared_mem_wait_attached(uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    while (shared_mem.header.cm4_state == SHARED_MEM_CORE_OFF) {
+        if (HAL_GetTick() - start > timeout_ms) {
+            return SHARED_MEM_STATUS_TIMEOUT;
+        }
+    }
+    __DMB();
+
+    if (shared_mem.header.cm4_state != SHARED_MEM_CORE_READY) {
+        return SHARED_MEM_STATUS_BAD_LAYOUT;
+    }
+    return SHARED_MEM_STATUS_OK;
+}
@@ -1,5 +1,7 @@
 #include "sii1136.h"
 
+#include "trace.h"
+
 // I2C Statuses.
 typedef enum {
 	SII1136_I2C_STATUS_OK = 0x00,
@@ -68,29 +70,41 @@ enum {
 
 static inline sii1136_i2c_status_t sii1136_i2c_write_reg(sii1136_t* self, uint16_t mem_addr,
 															uint8_t data) {
+	uint16_t trace_arg = (uint16_t)(self->_i2c_addr << 8 | (mem_addr & 0xFF));
+	TRACE_BEGIN(TRACE_EVENT_I2C, trace_arg);
 	HAL_StatusTypeDef status = HAL_I2C_Mem_Write(self->_i2c_handle, self->_i2c_addr, mem_addr, 1,
 			&data, 1, self->_i2c_timeout);
+	TRACE_END(TRACE_EVENT_I2C, trace_arg);
 	return (sii1136_i2c_status_t)status;
 }
 
 static inline sii1136_i2c_status_t sii1136_i2c_write_multi_reg(sii1136_t* self, uint16_t mem_addr,
 																uint8_t* data, size_t size_b) {
+	uint16_t trace_arg = (uint16_t)(self->_i2c_addr << 8 | (mem_addr & 0xFF));
+	TRACE_BEGIN(TRACE_EVENT_I2C, trace_arg);
 	HAL_StatusTypeDef status = HAL_I2C_Mem_Write(self->_i2c_handle, self->_i2c_addr, mem_addr, 1,
 			data, size_b, self->_i2c_timeout);
+	TRACE_END(TRACE_EVENT_I2C, trace_arg);
 	return (sii1136_i2c_status_t)status;
 }
 
 static inline sii1136_i2c_status_t sii1136_i2c_read_reg(sii1136_t* self, uint16_t mem_addr,
 														uint8_t* data) {
+	uint16_t trace_arg = (uint16_t)(self->_i2c_addr << 8 | (mem_addr & 0xFF));
+	TRACE_BEGIN(TRACE_EVENT_I2C, trace_arg);
 	HAL_StatusTypeDef status = HAL_I2C_Mem_Read(self->_i2c_handle, self->_i2c_addr, mem_addr, 1,
 			data, 1, self->_i2c_timeout);
+	TRACE_END(TRACE_EVENT_I2C, trace_arg);
 	return (sii1136_i2c_status_t)status;
 }
 
 static inline sii1136_i2c_status_t sii1136_i2c_read_multi_reg(sii1136_t* self, uint16_t mem_addr,
 																uint8_t* data, size_t size_b) {
+	uint16_t trace_arg = (uint16_t)(self->_i2c_addr << 8 | (mem_addr & 0xFF));
+	TRACE_BEGIN(TRACE_EVENT_I2C, trace_arg);
 	HAL_StatusTypeDef status = HAL_I2C_Mem_Read(self->_i2c_handle, self->_i2c_addr, mem_addr, 1,
 			data, size_b, self->_i2c_timeout);
+	TRACE_END(TRACE_EVENT_I2C, trace_arg);
 	return (sii1136_i2c_status_t)status;
 }
 
@@ -232,7 +246,7 @@ sii1136_status_t sii1136_set_pixel_clock(sii1136_t* self, uint32_t pixel_clock)
 		return SII1136_STATUS_NULL_ARG;
 	}
 	pixel_clock /= 10000;
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_multi_reg(self, SII1136_REG_HORIZ_RES_LSB,
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_multi_reg(self, SII1136_REG_PXL_CLK_LSB,
 			(uint8_t*)&pixel_clock, 2);
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
@@ -241,7 +255,7 @@ sii1136_status_t sii1136_set_vert_freq(sii1136_t* self, uint16_t vert_freq) {
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_multi_reg(self, SII1136_REG_VFREQ_LSB,
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_multi_reg(self, SII1136_REG_VFREQ_LSB,
 			(uint8_t*)&vert_freq, 2);
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
@@ -250,7 +264,7 @@ sii1136_status_t sii1136_set_horiz_res(sii1136_t* self, uint16_t horiz_res) {
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_multi_reg(self, SII1136_REG_HORIZ_RES_LSB,
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_multi_reg(self, SII1136_REG_HORIZ_RES_LSB,
 			(uint8_t*)&horiz_res, 2);
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
@@ -259,7 +273,7 @@ sii1136_status_t sii1136_set_vert_res(sii1136_t* self, uint16_t vert_res) {
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_multi_reg(self, SII1136_REG_VERT_RES_LSB,
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_multi_reg(self, SII1136_REG_VERT_RES_LSB,
 			(uint8_t*)&vert_res, 2);
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
@@ -620,9 +634,9 @@ sii1136_status_t sii1136_get_yc_mux_enabled(sii1136_t* self, bool* yc_mux_enable
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN,
-			(uint8_t*)yc_mux_enabled);
-	*yc_mux_enabled = (*yc_mux_enabled >> 5) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN, &reg_val);
+	*yc_mux_enabled = (reg_val >> 5) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -630,9 +644,9 @@ sii1136_status_t sii1136_get_f_bit_inverted(sii1136_t* self, bool* f_bit_inverte
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN,
-			(uint8_t*)f_bit_inverted);
-	*f_bit_inverted = (*f_bit_inverted >> 4) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN, &reg_val);
+	*f_bit_inverted = (reg_val >> 4) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -640,9 +654,9 @@ sii1136_status_t sii1136_get_de_adj_enabled(sii1136_t* self, bool* de_adj_enable
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN,
-			(uint8_t*)de_adj_enabled);
-	*de_adj_enabled = (*de_adj_enabled >> 2) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN, &reg_val);
+	*de_adj_enabled = (reg_val >> 2) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -650,9 +664,9 @@ sii1136_status_t sii1136_get_vbit_adj_enabled(sii1136_t* self, bool* vbit_adj_en
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN,
-			(uint8_t*)vbit_adj_enabled);
-	*vbit_adj_enabled = (*vbit_adj_enabled >> 1) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_GEN, &reg_val);
+	*vbit_adj_enabled = (reg_val >> 1) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -779,9 +793,9 @@ sii1136_status_t sii1136_get_video_interlaced(sii1136_t* self, bool* video_inter
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_DET,
-			(uint8_t*)video_interlaced);
-	*video_interlaced = (*video_interlaced >> 2) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYNC_DET, &reg_val);
+	*video_interlaced = (reg_val >> 2) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -827,9 +841,9 @@ sii1136_status_t sii1136_get_yc_msb_swapped(sii1136_t* self, bool* yc_msb_swappe
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT,
-			(uint8_t*)yc_msb_swapped);
-	*yc_msb_swapped >>= 7;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT, &reg_val);
+	*yc_msb_swapped = (reg_val >> 7) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -847,9 +861,9 @@ sii1136_status_t sii1136_get_yc_nongap_enabled(sii1136_t* self, bool* non_gap_en
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT,
-			(uint8_t*)non_gap_enabled);
-	*non_gap_enabled = (*non_gap_enabled >> 3) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT, &reg_val);
+	*non_gap_enabled = (reg_val >> 3) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -857,9 +871,9 @@ sii1136_status_t sii1136_get_yc_input_mode(sii1136_t* self, bool* yc_input_mode)
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT,
-			(uint8_t*)yc_input_mode);
-	*yc_input_mode &= 0x07;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_YC_IN_FMT, &reg_val);
+	*yc_input_mode = reg_val & 0x07;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -944,9 +958,9 @@ sii1136_status_t sii1136_get_de_gen_enabled(sii1136_t* self, bool* de_gen_enable
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_DE_GEN_FLAGS,
-			(uint8_t*)de_gen_enabled);
-	*de_gen_enabled >>= 6;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_DE_GEN_FLAGS, &reg_val);
+	*de_gen_enabled = (reg_val >> 6) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1190,9 +1204,9 @@ sii1136_status_t sii1136_get_emb_sync_enabled(sii1136_t* self, bool* embedded_sy
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_EMB_SYNC_EN,
-			(uint8_t*)embedded_sync_enabled);
-	*embedded_sync_enabled >>= 6;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_EMB_SYNC_EN, &reg_val);
+	*embedded_sync_enabled = (reg_val >> 6) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1366,9 +1380,9 @@ sii1136_status_t sii1136_get_av_muted(sii1136_t* self, bool* av_muted) {
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL,
-			(uint8_t*)av_muted);
-	*av_muted = (*av_muted >> 3) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL, &reg_val);
+	*av_muted = (reg_val >> 3) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1376,9 +1390,9 @@ sii1136_status_t sii1136_get_ddc_bus_requested(sii1136_t* self, bool* ddc_bus_re
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL,
-			(uint8_t*)ddc_bus_requested);
-	*ddc_bus_requested = (*ddc_bus_requested >> 2) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL, &reg_val);
+	*ddc_bus_requested = (reg_val >> 2) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1386,9 +1400,9 @@ sii1136_status_t sii1136_get_ddc_bus_granted(sii1136_t* self, bool* bus_granted)
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL,
-			(uint8_t*)bus_granted);
-	*bus_granted = (*bus_granted >> 1) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL, &reg_val);
+	*bus_granted = (reg_val >> 1) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1410,12 +1424,12 @@ sii1136_status_t sii1136_get_sys_cntl(sii1136_t* self, sii1136_link_int_mode_t*
 	}
 	uint8_t reg_val;
 	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_SYS_CNTL, &reg_val);
-	*link_mode = (*link_mode >> 6) & 0x01;
-	*tmds_control = (*tmds_control >> 4) & 0x01;
-	*av_muted = (*av_muted >> 3) & 0x01;
-	*ddc_bus_requested = (*ddc_bus_requested >> 2) & 0x01;
-	*bus_granted = (*bus_granted >> 1) & 0x01;
-	*output_mode &= 0x01;
+	*link_mode = (reg_val >> 6) & 0x01;
+	*tmds_control = (reg_val >> 4) & 0x01;
+	*av_muted = (reg_val >> 3) & 0x01;
+	*ddc_bus_requested = (reg_val >> 2) & 0x01;
+	*bus_granted = (reg_val >> 1) & 0x01;
+	*output_mode = reg_val & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1511,9 +1525,9 @@ sii1136_status_t sii1136_get_auth_chg_int_en(sii1136_t* self, bool* auth_change_
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)auth_change_int_enabled);
-	*auth_change_int_enabled >>= 7;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*auth_change_int_enabled = (reg_val >> 7) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1521,9 +1535,9 @@ sii1136_status_t sii1136_get_v_val_int_en(sii1136_t* self, bool* v_value_int_ena
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)v_value_int_enabled);
-	*v_value_int_enabled = (*v_value_int_enabled >> 6) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*v_value_int_enabled = (reg_val >> 6) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1531,9 +1545,9 @@ sii1136_status_t sii1136_get_sec_chg_int_en(sii1136_t* self, bool* sec_chg_int_e
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)sec_chg_int_enabled);
-	*sec_chg_int_enabled = (*sec_chg_int_enabled >> 5) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*sec_chg_int_enabled = (reg_val >> 5) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1541,9 +1555,9 @@ sii1136_status_t sii1136_get_audio_err_int_en(sii1136_t* self, bool* audio_err_i
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)audio_err_int_enabled);
-	*audio_err_int_enabled = (*audio_err_int_enabled >> 4) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*audio_err_int_enabled = (reg_val >> 4) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1551,9 +1565,9 @@ sii1136_status_t sii1136_get_cpi_event_int_en(sii1136_t* self, bool* gpi_event_i
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)gpi_event_int_enabled);
-	*gpi_event_int_enabled = (*gpi_event_int_enabled >> 3) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*gpi_event_int_enabled = (reg_val >> 3) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1561,9 +1575,9 @@ sii1136_status_t sii1136_get_recv_sns_int_en(sii1136_t* self, bool* recv_sense_i
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)recv_sense_int_enabled);
-	*recv_sense_int_enabled = (*recv_sense_int_enabled >> 1) & 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*recv_sense_int_enabled = (reg_val >> 1) & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1571,9 +1585,9 @@ sii1136_status_t sii1136_get_hot_plug_int_en(sii1136_t* self, bool* hot_plug_int
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)hot_plug_int_enabled);
-	*hot_plug_int_enabled &= 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*hot_plug_int_enabled = reg_val & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1587,15 +1601,15 @@ bool* v_value_int_enabled,
 	if (self == NULL) {
 		return SII1136_STATUS_NULL_ARG;
 	}
-	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN,
-			(uint8_t*)auth_change_int_enabled);
-	*auth_change_int_enabled >>= 7;
-	*v_value_int_enabled = (*v_value_int_enabled >> 6) & 0x01;
-	*sec_chg_int_enabled = (*sec_chg_int_enabled >> 5) & 0x01;
-	*audio_err_int_enabled = (*audio_err_int_enabled >> 4) & 0x01;
-	*gpi_event_int_enabled = (*gpi_event_int_enabled >> 3) & 0x01;
-	*recv_sense_int_enabled = (*recv_sense_int_enabled >> 1) & 0x01;
-	*hot_plug_int_enabled &= 0x01;
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_EN, &reg_val);
+	*auth_change_int_enabled = (reg_val >> 7) & 0x01;
+	*v_value_int_enabled = (reg_val >> 6) & 0x01;
+	*sec_chg_int_enabled = (reg_val >> 5) & 0x01;
+	*audio_err_int_enabled = (reg_val >> 4) & 0x01;
+	*gpi_event_int_enabled = (reg_val >> 3) & 0x01;
+	*recv_sense_int_enabled = (reg_val >> 1) & 0x01;
+	*hot_plug_int_enabled = reg_val & 0x01;
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
@@ -1700,3 +1714,62 @@ bool v_value_int_enabled,
 	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
 }
 
+/***** INTERRUPT STATUS REGISTER *****/
+
+sii1136_status_t sii1136_get_rx_sns_detected(sii1136_t* self, bool* rx_sense_detected) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_STATUS, &reg_val);
+	*rx_sense_detected = (reg_val >> 3) & 0x01;
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
+
+sii1136_status_t sii1136_get_hot_plug_state(sii1136_t* self, bool* hot_plug_state) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_STATUS, &reg_val);
+	*hot_plug_state = (reg_val >> 2) & 0x01;
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
+
+sii1136_status_t sii1136_get_rx_sns_event_pending(sii1136_t* self, bool* rx_sense_event_pending) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_STATUS, &reg_val);
+	*rx_sense_event_pending = (reg_val >> 1) & 0x01;
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
+
+sii1136_status_t sii1136_get_conn_event_pending(sii1136_t* self, bool* conn_event_pending) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	uint8_t reg_val;
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_read_reg(self, SII1136_REG_INT_STATUS, &reg_val);
+	*conn_event_pending = reg_val & 0x01;
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
+
+// Pending bits are cleared by writing 1 to them; writing 0 leaves the others alone.
+sii1136_status_t sii1136_clear_rx_sns_event_pending(sii1136_t* self) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_reg(self, SII1136_REG_INT_STATUS,
+			0x01 << 1);
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
+
+sii1136_status_t sii1136_clear_conn_event_pending(sii1136_t* self) {
+	if (self == NULL) {
+		return SII1136_STATUS_NULL_ARG;
+	}
+	sii1136_i2c_status_t i2c_status = sii1136_i2c_write_reg(self, SII1136_REG_INT_STATUS, 0x01);
+	return i2c_status == SII1136_I2C_STATUS_OK ? SII1136_STATUS_OK : SII1136_STATUS_I2C_ERR;
+}
@@ -236,12 +236,7 @@ void SystemInit (void)
 #else
 #ifdef CORE_CM7
 
-  /*
-   * Disable the FMC bank1 (enabled after reset).
-   * This, prevents CPU speculation access on this bank which blocks the use of FMC during
-   * 24us. During this time the others FMC master (such as LTDC) cannot use it!
-   */
-  FMC_Bank1_R->BTCR[0] = 0x000030D2;
+  /* FMC bank1 is disabled by mem_attr_init(), together with the rest of the MPU setup */
 
   /* Configure the Vector Table location add offset address ------------------*/
 #ifdef VECT_TAB_SRAM
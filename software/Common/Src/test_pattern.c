@@ -0,0 +1,36 @@
+#include "test_pattern.h"
+
+#include "blit.h"
+
+#include <stddef.h>
+
+static const uint32_t test_pattern_colors[TEST_PATTERN_BARS] = {
+    0xFFFFFFFFUL, 0xFFFFFF00UL, 0xFF00FFFFUL, 0xFF00FF00UL,
+    0xFFFF00FFUL, 0xFFFF0000UL, 0xFF0000FFUL, 0xFF000000UL,
+};
+
+void test_pattern_draw(const surface_t* target, const rect_t* rect, uint32_t frame) {
+    if (target == NULL || rect == NULL) {
+        return;
+    }
+    rect_t bounds = surface_bounds(target);
+    rect_t clipped = rect_intersect(rect, &bounds);
+    uint32_t bar_w = target->width / TEST_PATTERN_BARS;
+    bar_w = bar_w != 0 ? bar_w : 1;
+    uint32_t period = bar_w * TEST_PATTERN_BARS;
+    uint32_t scroll = (frame % period) * TEST_PATTERN_SPEED_PX % period;
+
+    // One fill per run of a single bar.
+    for (int16_t x = clipped.x0; x < clipped.x1;) {
+        uint32_t pos = ((uint32_t)x + scroll) % period;
+        int32_t end = x + (int32_t)(bar_w - pos % bar_w);
+        rect_t run = {x, clipped.y0, (int16_t)(end < clipped.x1 ? end : clipped.x1), clipped.y1};
+        blit_fill(target, &run, test_pattern_colors[pos / bar_w]);
+        x = run.x1;
+    }
+}
+
+void test_pattern_tile(const surface_t* target, const rect_t* tile, uint32_t arg, void* user) {
+    (void)user;
+    test_pattern_draw(target, tile, arg);
+}
@@ -0,0 +1,245 @@
+#include "tile_sched.h"
+
+#include "cache_maint.h"
+#include "cycles.h"
+#include "hsem_ids.h"
+#include "hsem_lock.h"
+#include "fence.h"
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+#include "trace.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static tile_sched_render_fn_t tile_sched_render;
+static void* tile_sched_user;
+
+#if defined(CORE_CM4)
+static uint32_t tile_sched_last_done_cycles;
+#endif
+
+/***** LOCK *****/
+
+// Only taken when the two cores meet on the last tile, and twice per frame for join/close.
+static void tile_sched_lock(void) {
+    hsem_mutex_lock(HSEM_ID_TILE_SCHED);
+}
+
+static void tile_sched_unlock(void) {
+    hsem_mutex_unlock(HSEM_ID_TILE_SCHED);
+}
+
+/***** TILES *****/
+
+static rect_t tile_sched_tile_rect(uint32_t tile) {
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    int16_t x0 = (int16_t)((tile % ts->job.cols) * ts->job.tile_w);
+    int16_t y0 = (int16_t)((tile / ts->job.cols) * ts->job.tile_h);
+    rect_t rect = {x0, y0, (int16_t)(x0 + ts->job.tile_w), (int16_t)(y0 + ts->job.tile_h)};
+    rect_t bounds = surface_bounds(&ts->job.target);
+    return rect_intersect(&rect, &bounds);
+}
+
+static void tile_sched_render_tile(uint32_t tile, tile_sched_core_stats_t* stats) {
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    rect_t rect = tile_sched_tile_rect(tile);
+    uint32_t start = cycles_now();
+    TRACE_BEGIN(TRACE_EVENT_TILE, tile);
+    tile_sched_render(&ts->job.target, &rect, ts->job.arg, tile_sched_user);
+#if defined(CORE_CM7)
+    cache_maint_rects(&ts->job.target, &rect, 1, CACHE_MAINT_CLEAN);
+#endif
+    TRACE_END(TRACE_EVENT_TILE, tile);
+    stats->busy_cycles += cycles_now() - start;
+    stats->last_tiles++;
+    stats->tiles++;
+}
+
+#if defined(CORE_CM7)
+
+// Claims the next tile from the front. Publishes the claim before looking at the CM4's index; the
+// CM4 does the mirror image, so at least one of them notices when they reach the same tile.
+static bool tile_sched_take_front(uint32_t* tile) {
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    uint32_t f = ts->front;
+    if (f >= ts->back) {
+        return false;
+    }
+    ts->front = f + 1;
+    __DMB();
+    if (f >= ts->back) {
+        shared_mem.tile_sched.stats[CORE_ID_SELF].lock_fallbacks++;
+        tile_sched_lock();
+        bool lost = f >= ts->back;
+        if (lost) {
+            ts->front = f;
+        }
+        tile_sched_unlock();
+        if (lost) {
+            return false;
+        }
+    }
+    *tile = f;
+    return true;
+}
+
+#else
+
+static bool tile_sched_take_back(uint32_t* tile) {
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    uint32_t b = ts->back;
+    if (b <= ts->front) {
+        return false;
+    }
+    b--;
+    ts->back = b;
+    __DMB();
+    if (b < ts->front) {
+        shared_mem.tile_sched.stats[CORE_ID_SELF].lock_fallbacks++;
+        tile_sched_lock();
+        bool lost = b < ts->front;
+        if (lost) {
+            ts->back = b + 1;
+        }
+        tile_sched_unlock();
+        if (lost) {
+            return false;
+        }
+    }
+    *tile = b;
+    return true;
+}
+
+#endif
+
+/***** PUBLIC API *****/
+
+void tile_sched_init(tile_sched_render_fn_t render, void* user) {
+    tile_sched_render = render;
+    tile_sched_user = user;
+    shared_mem.tile_sched.stats[CORE_ID_SELF].cycles_per_s = cycles_per_second();
+    cycles_init();
+#if defined(CORE_CM7)
+    fence_init(&shared_mem.tile_sched.done, HSEM_ID_TILE_DONE);
+    fence_attach(&shared_mem.tile_sched.done);
+#else
+    tile_sched_last_done_cycles = cycles_now();
+#endif
+}
+
+#if defined(CORE_CM7)
+
+tile_sched_status_t tile_sched_render_frame(const surface_t* target, uint16_t tile_w,
+                                            uint16_t tile_h, uint32_t arg) {
+    if (target == NULL || tile_sched_render == NULL) {
+        return TILE_SCHED_STATUS_NULL_ARG;
+    }
+
+    uint32_t bpp = pixel_format_bytes(target->format);
+    uint32_t cols = (target->width + tile_w - 1) / (tile_w ? tile_w : 1);
+    uint32_t rows = (target->height + tile_h - 1) / (tile_h ? tile_h : 1);
+    if (tile_w == 0 || tile_h == 0 || cols * rows > TILE_SCHED_MAX_TILES ||
+        ((uintptr_t)target->pixels | target->stride_b | tile_w * bpp) % CACHE_LINE_SIZE_B != 0) {
+        return TILE_SCHED_STATUS_BAD_LAYOUT;
+    }
+
+    // Nobody else touches the indices between frames, so both can be reset from here.
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    uint32_t frame = ts->job.frame + 1;
+    frame = frame == 0 ? 1 : frame;
+    ts->job.frame = frame;
+    ts->job.target = *target;
+    ts->job.tile_w = tile_w;
+    ts->job.tile_h = tile_h;
+    ts->job.cols = (uint16_t)cols;
+    ts->job.num_tiles = (uint16_t)(cols * rows);
+    ts->job.arg = arg;
+    ts->front = 0;
+    ts->back = cols * rows;
+
+    tile_sched_lock();
+    ts->open_frame = frame;
+    tile_sched_unlock();
+    // Never announced, the frame cannot be joined, so it can be closed without the lock.
+    ipc_status_t status = ipc_send(IPC_MSG_TILE_SCHED_FRAME, &frame, sizeof(frame));
+    if (status == IPC_STATUS_FULL) {
+        ts->open_frame = 0;
+    } else if (status != IPC_STATUS_OK) {
+        ts->open_frame = 0;
+        return TILE_SCHED_STATUS_IPC_ERR;
+    }
+
+    TRACE_BEGIN(TRACE_EVENT_FRAME, frame);
+    tile_sched_core_stats_t* stats = &ts->stats[CORE_ID_SELF];
+    stats->last_tiles = 0;
+    stats->busy_cycles = 0;
+    uint32_t tile;
+    while (tile_sched_take_front(&tile)) {
+        tile_sched_render_tile(tile, stats);
+    }
+
+    // Barrier. Closing the frame stops a late CM4 from joining; if it already joined, wait for it
+    // to finish the tiles it claimed.
+    uint32_t start = cycles_now();
+    tile_sched_lock();
+    ts->open_frame = 0;
+    bool joined = ts->joined == frame;
+    tile_sched_unlock();
+    if (joined) {
+        fence_wait(&ts->done, frame, FENCE_WAIT_FOREVER);
+    }
+    stats->idle_cycles = cycles_now() - start;
+    stats->frames++;
+    TRACE_END(TRACE_EVENT_FRAME, frame);
+    return status == IPC_STATUS_FULL ? TILE_SCHED_STATUS_SOLO : TILE_SCHED_STATUS_OK;
+}
+
+#endif
+
+bool tile_sched_handle(const ipc_msg_t* msg) {
+    if (msg == NULL || msg->type != IPC_MSG_TILE_SCHED_FRAME) {
+        return false;
+    }
+
+#if defined(CORE_CM4)
+    uint32_t frame;
+    memcpy(&frame, msg->payload, sizeof(frame));
+
+    tile_sched_shared_t* ts = &shared_mem.tile_sched;
+    tile_sched_core_stats_t* stats = &ts->stats[CORE_ID_SELF];
+    uint32_t start = cycles_now();
+
+    // The announcement may be stale: the CM7 closes frames it finished without us.
+    tile_sched_lock();
+    bool open = ts->open_frame == frame && tile_sched_render != NULL;
+    if (open) {
+        ts->joined = frame;
+    }
+    tile_sched_unlock();
+    if (!open) {
+        return true;
+    }
+
+    TRACE_BEGIN(TRACE_EVENT_FRAME, frame);
+    stats->idle_cycles = start - tile_sched_last_done_cycles;
+    stats->last_tiles = 0;
+    stats->busy_cycles = 0;
+    uint32_t tile;
+    while (tile_sched_take_back(&tile)) {
+        tile_sched_render_tile(tile, stats);
+    }
+    stats->frames++;
+
+    fence_signal(&ts->done, frame);
+    TRACE_END(TRACE_EVENT_FRAME, frame);
+    tile_sched_last_done_cycles = cycles_now();
+#endif
+    return true;
+}
+
+void tile_sched_get_stats(core_id_t core, tile_sched_core_stats_t* stats) {
+    if (stats != NULL && core < CORE_ID_COUNT) {
+        *stats = shared_mem.tile_sched.stats[core];
+    }
+}
@@ -0,0 +1,444 @@
+#include "tlsf.h"
+
+#include <string.h>
+
+// Physical block header. prev_phys and size are always valid; the free-list links overlap the
+// start of the payload and are only meaningful while the block is free.
+struct tlsf_block {
+    tlsf_block_t* prev_phys;
+    size_t size;  // Total block size including this header. Low bits hold flags.
+    tlsf_block_t* next_free;
+    tlsf_block_t* prev_free;
+};
+
+#define TLSF_BLOCK_OVERHEAD offsetof(tlsf_block_t, next_free)
+#define TLSF_BLOCK_FLAG_FREE ((size_t)1)
+#define TLSF_BLOCK_FLAG_MASK ((size_t)(TLSF_ALIGN_SIZE - 1))
+
+#define TLSF_ALIGN_UP(x, a) (((x) + ((a)-1)) & ~((size_t)(a)-1))
+
+// Smallest block that can hold its own free-list links once freed.
+#define TLSF_BLOCK_MIN_SIZE TLSF_ALIGN_UP(sizeof(tlsf_block_t), TLSF_ALIGN_SIZE)
+#define TLSF_BLOCK_MAX_SIZE ((size_t)1 << TLSF_FL_INDEX_MAX)
+
+/****************************
+ ***** BIT MANIPULATION *****
+ ****************************/
+
+static inline int tlsf_fls(size_t x) {
+    return x ? (int)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl((unsigned long)x)) : -1;
+}
+
+static inline int tlsf_ffs(uint32_t x) {
+    return x ? __builtin_ctz(x) : -1;
+}
+
+/*******************************
+ ***** BLOCK ACCESS HELPERS *****
+ *******************************/
+
+static inline size_t tlsf_block_size(const tlsf_block_t* block) {
+    return block->size & ~TLSF_BLOCK_FLAG_MASK;
+}
+
+static inline bool tlsf_block_is_free(const tlsf_block_t* block) {
+    return (block->size & TLSF_BLOCK_FLAG_FREE) != 0;
+}
+
+static inline void tlsf_block_set_size(tlsf_block_t* block, size_t size) {
+    block->size = size | (block->size & TLSF_BLOCK_FLAG_MASK);
+}
+
+static inline void tlsf_block_set_free(tlsf_block_t* block, bool free) {
+    block->size = free ? (block->size | TLSF_BLOCK_FLAG_FREE) : (block->size & ~TLSF_BLOCK_FLAG_FREE);
+}
+
+static inline tlsf_block_t* tlsf_block_next(const tlsf_block_t* block) {
+    return (tlsf_block_t*)((uint8_t*)block + tlsf_block_size(block));
+}
+
+static inline void* tlsf_block_to_ptr(const tlsf_block_t* block) {
+    return (uint8_t*)block + TLSF_BLOCK_OVERHEAD;
+}
+
+static inline tlsf_block_t* tlsf_ptr_to_block(const void* ptr) {
+    return (tlsf_block_t*)((uint8_t*)ptr - TLSF_BLOCK_OVERHEAD);
+}
+
+/***************************
+ ***** SIZE CLASS MAPPING *****
+ ***************************/
+
+static inline void tlsf_mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < TLSF_SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT));
+    } else {
+        int f = tlsf_fls(size);
+        *sl = (int)(size >> (f - TLSF_SL_INDEX_COUNT_LOG2)) ^ TLSF_SL_INDEX_COUNT;
+        *fl = f - (TLSF_FL_INDEX_SHIFT - 1);
+    }
+}
+
+// Smallest block size that tlsf_mapping_insert() puts in class (fl, sl).
+static inline size_t tlsf_class_min_size(int fl, int sl) {
+    if (fl == 0) {
+        return (size_t)sl * (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT);
+    }
+    int f = fl + TLSF_FL_INDEX_SHIFT - 1;
+    return ((size_t)1 << f) + ((size_t)sl << (f - TLSF_SL_INDEX_COUNT_LOG2));
+}
+
+// Like tlsf_mapping_insert(), but rounds up to the next class so that any block found in the
+// resulting list is guaranteed to be large enough. This is what makes the search O(1).
+static inline void tlsf_mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= TLSF_SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (tlsf_fls(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    tlsf_mapping_insert(size, fl, sl);
+}
+
+/**************************
+ ***** FREE LIST OPS *****
+ **************************/
+
+static void tlsf_remove_free(tlsf_t* self, tlsf_block_t* block, int fl, int sl) {
+    tlsf_block_t* prev = block->prev_free;
+    tlsf_block_t* next = block->next_free;
+    if (next != NULL) {
+        next->prev_free = prev;
+    }
+    if (prev != NULL) {
+        prev->next_free = next;
+    } else {
+        self->_free_lists[fl][sl] = next;
+        if (next == NULL) {
+            self->_sl_bitmap[fl] &= ~(1U << sl);
+            if (self->_sl_bitmap[fl] == 0) {
+                self->_fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+    self->_free_b -= tlsf_block_size(block);
+    self->_free_blocks--;
+}
+
+static void tlsf_insert_free(tlsf_t* self, tlsf_block_t* block) {
+    int fl, sl;
+    tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+
+    tlsf_block_t* head = self->_free_lists[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL) {
+        head->prev_free = block;
+    }
+    self->_free_lists[fl][sl] = block;
+    self->_fl_bitmap |= 1U << fl;
+    self->_sl_bitmap[fl] |= 1U << sl;
+
+    self->_free_b += tlsf_block_size(block);
+    self->_free_blocks++;
+}
+
+static inline void tlsf_remove_free_block(tlsf_t* self, tlsf_block_t* block) {
+    int fl, sl;
+    tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+    tlsf_remove_free(self, block, fl, sl);
+}
+
+// Pops the head of the first non-empty list whose blocks are all at least `size` bytes.
+static tlsf_block_t* tlsf_take_suitable(tlsf_t* self, size_t size) {
+    int fl, sl;
+    tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= (int)TLSF_FL_INDEX_COUNT) {
+        return NULL;
+    }
+
+    uint32_t sl_map = self->_sl_bitmap[fl] & (~0U << sl);
+    if (sl_map == 0) {
+        uint32_t fl_map = (fl + 1 < 32) ? self->_fl_bitmap & (~0U << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return NULL;
+        }
+        fl = tlsf_ffs(fl_map);
+        sl_map = self->_sl_bitmap[fl];
+    }
+    sl = tlsf_ffs(sl_map);
+
+    tlsf_block_t* block = self->_free_lists[fl][sl];
+    tlsf_remove_free(self, block, fl, sl);
+    return block;
+}
+
+/***********************************
+ ***** SPLIT AND MERGE HELPERS *****
+ ***********************************/
+
+// Splits `block` so it is exactly `size` bytes, returning the remainder to the free lists.
+static void tlsf_trim(tlsf_t* self, tlsf_block_t* block, size_t size) {
+    size_t remaining = tlsf_block_size(block) - size;
+    if (remaining < TLSF_BLOCK_MIN_SIZE) {
+        return;
+    }
+
+    tlsf_block_t* rest = (tlsf_block_t*)((uint8_t*)block + size);
+    rest->prev_phys = block;
+    rest->size = remaining | TLSF_BLOCK_FLAG_FREE;
+    tlsf_block_next(rest)->prev_phys = rest;
+    tlsf_block_set_size(block, size);
+
+    tlsf_insert_free(self, rest);
+}
+
+// Absorbs free physical neighbours into `block`. Returns the start of the merged block.
+static tlsf_block_t* tlsf_merge(tlsf_t* self, tlsf_block_t* block) {
+    tlsf_block_t* prev = block->prev_phys;
+    if (prev != NULL && tlsf_block_is_free(prev)) {
+        tlsf_remove_free_block(self, prev);
+        tlsf_block_set_size(prev, tlsf_block_size(prev) + tlsf_block_size(block));
+        block = prev;
+        tlsf_block_next(block)->prev_phys = block;
+    }
+
+    tlsf_block_t* next = tlsf_block_next(block);
+    if (tlsf_block_is_free(next)) {
+        tlsf_remove_free_block(self, next);
+        tlsf_block_set_size(block, tlsf_block_size(block) + tlsf_block_size(next));
+        tlsf_block_next(block)->prev_phys = block;
+    }
+    return block;
+}
+
+static inline size_t tlsf_adjust_request(size_t size_b) {
+    size_t size = TLSF_ALIGN_UP(size_b + TLSF_BLOCK_OVERHEAD, TLSF_ALIGN_SIZE);
+    return size < TLSF_BLOCK_MIN_SIZE ? TLSF_BLOCK_MIN_SIZE : size;
+}
+
+static void* tlsf_commit(tlsf_t* self, tlsf_block_t* block, size_t size) {
+    tlsf_trim(self, block, size);
+    tlsf_block_set_free(block, false);
+
+    self->_used_blocks++;
+    size_t used_b = self->_total_b - self->_free_b;
+    if (used_b > self->_peak_used_b) {
+        self->_peak_used_b = used_b;
+    }
+    return tlsf_block_to_ptr(block);
+}
+
+/**********************
+ ***** PUBLIC API *****
+ **********************/
+
+tlsf_status_t tlsf_init(tlsf_t* self, void* mem, size_t size_b) {
+    if (self == NULL || mem == NULL) {
+        return TLSF_STATUS_NULL_ARG;
+    }
+    memset(self, 0, sizeof(*self));
+
+    // Place the first header so that its payload lands on an alignment boundary. Every block is a
+    // multiple of the alignment, so every later payload is aligned too.
+    uintptr_t start = (uintptr_t)mem;
+    uintptr_t end = start + size_b;
+    uintptr_t first = TLSF_ALIGN_UP(start + TLSF_BLOCK_OVERHEAD, TLSF_ALIGN_SIZE) -
+                      TLSF_BLOCK_OVERHEAD;
+    if (end < first + TLSF_BLOCK_OVERHEAD ||
+        end - first - TLSF_BLOCK_OVERHEAD < TLSF_BLOCK_MIN_SIZE) {
+        return TLSF_STATUS_POOL_TOO_SMALL;
+    }
+
+    // The last TLSF_BLOCK_OVERHEAD bytes hold a zero-sized, permanently used sentinel so that
+    // merging never runs off the end of the pool.
+    size_t span = (end - first - TLSF_BLOCK_OVERHEAD) & ~((size_t)TLSF_ALIGN_SIZE - 1);
+    if (span >= TLSF_BLOCK_MAX_SIZE) {
+        return TLSF_STATUS_POOL_TOO_LARGE;
+    }
+
+    tlsf_block_t* block = (tlsf_block_t*)first;
+    block->prev_phys = NULL;
+    block->size = span | TLSF_BLOCK_FLAG_FREE;
+
+    tlsf_block_t* sentinel = tlsf_block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size = 0;
+
+    self->_first = block;
+    self->_total_b = span;
+    tlsf_insert_free(self, block);
+
+    return TLSF_STATUS_OK;
+}
+
+void* tlsf_malloc(tlsf_t* self, size_t size_b) {
+    if (self == NULL || size_b == 0 || size_b >= TLSF_BLOCK_MAX_SIZE) {
+        return NULL;
+    }
+
+    size_t size = tlsf_adjust_request(size_b);
+    tlsf_block_t* block = tlsf_take_suitable(self, size);
+    if (block == NULL) {
+        return NULL;
+    }
+    return tlsf_commit(self, block, size);
+}
+
+void* tlsf_memalign(tlsf_t* self, size_t align, size_t size_b) {
+    if (align <= TLSF_ALIGN_SIZE) {
+        return tlsf_malloc(self, size_b);
+    }
+    if (self == NULL || size_b == 0 || size_b >= TLSF_BLOCK_MAX_SIZE || (align & (align - 1))) {
+        return NULL;
+    }
+
+    // Over-allocate so there is room to carve off a leading free block (which must itself be at
+    // least TLSF_BLOCK_MIN_SIZE) before the aligned payload.
+    size_t size = tlsf_adjust_request(size_b);
+    tlsf_block_t* block = tlsf_take_suitable(self, size + align + TLSF_BLOCK_MIN_SIZE);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    uintptr_t ptr = (uintptr_t)tlsf_block_to_ptr(block);
+    size_t gap = TLSF_ALIGN_UP(ptr, align) - ptr;
+    if (gap != 0 && gap < TLSF_BLOCK_MIN_SIZE) {
+        gap = TLSF_ALIGN_UP(ptr + TLSF_BLOCK_MIN_SIZE, align) - ptr;
+    }
+
+    if (gap != 0) {
+        tlsf_block_t* aligned = (tlsf_block_t*)((uint8_t*)block + gap);
+        aligned->prev_phys = block;
+        aligned->size = tlsf_block_size(block) - gap;
+        tlsf_block_next(aligned)->prev_phys = aligned;
+
+        // The block came off a free list, so its physical predecessor is in use; the leading
+        // fragment can go straight back without merging.
+        block->size = gap | TLSF_BLOCK_FLAG_FREE;
+        tlsf_insert_free(self, block);
+        block = aligned;
+    }
+    return tlsf_commit(self, block, size);
+}
+
+void tlsf_free(tlsf_t* self, void* ptr) {
+    if (self == NULL || ptr == NULL) {
+        return;
+    }
+
+    tlsf_block_t* block = tlsf_ptr_to_block(ptr);
+    tlsf_block_set_free(block, true);
+    self->_used_blocks--;
+
+    block = tlsf_merge(self, block);
+    tlsf_insert_free(self, block);
+}
+
+size_t tlsf_usable_size(void* ptr) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    return tlsf_block_size(tlsf_ptr_to_block(ptr)) - TLSF_BLOCK_OVERHEAD;
+}
+
+tlsf_status_t tlsf_get_stats(tlsf_t* self, tlsf_stats_t* stats) {
+    if (self == NULL || stats == NULL) {
+        return TLSF_STATUS_NULL_ARG;
+    }
+
+    // Every block in the highest non-empty class is larger than everything below it, so only that
+    // one list needs scanning to find the largest free block. A request is rounded up to the next
+    // class before searching, so the largest that succeeds is that class's smallest block size.
+    size_t largest = 0;
+    size_t largest_request = 0;
+    if (self->_fl_bitmap != 0) {
+        int fl = tlsf_fls(self->_fl_bitmap);
+        int sl = tlsf_fls(self->_sl_bitmap[fl]);
+        for (tlsf_block_t* b = self->_free_lists[fl][sl]; b != NULL; b = b->next_free) {
+            if (tlsf_block_size(b) > largest) {
+                largest = tlsf_block_size(b);
+            }
+        }
+        largest_request = tlsf_class_min_size(fl, sl);
+    }
+
+    stats->total_b = self->_total_b;
+    stats->free_b = self->_free_b;
+    stats->used_b = self->_total_b - self->_free_b;
+    stats->peak_used_b = self->_peak_used_b;
+    stats->largest_free_b =
+        largest_request > TLSF_BLOCK_OVERHEAD ? largest_request - TLSF_BLOCK_OVERHEAD : 0;
+    stats->free_blocks = self->_free_blocks;
+    stats->used_blocks = self->_used_blocks;
+    stats->fragmentation_pm =
+        self->_free_b ? (uint16_t)(1000 - (uint64_t)largest * 1000 / self->_free_b) : 0;
+
+    return TLSF_STATUS_OK;
+}
+
+tlsf_status_t tlsf_check(tlsf_t* self) {
+    if (self == NULL || self->_first == NULL) {
+        return TLSF_STATUS_NULL_ARG;
+    }
+
+    // Physical walk: links are consistent, no two free blocks are adjacent, totals add up.
+    size_t free_b = 0;
+    uint32_t free_blocks = 0;
+    uint32_t used_blocks = 0;
+    tlsf_block_t* prev = NULL;
+    tlsf_block_t* block = self->_first;
+    while (tlsf_block_size(block) != 0) {
+        if (block->prev_phys != prev ||
+            ((uintptr_t)tlsf_block_to_ptr(block) & (TLSF_ALIGN_SIZE - 1)) != 0) {
+            return TLSF_STATUS_CORRUPT;
+        }
+        if (tlsf_block_is_free(block)) {
+            if (prev != NULL && tlsf_block_is_free(prev)) {
+                return TLSF_STATUS_CORRUPT;
+            }
+            free_b += tlsf_block_size(block);
+            free_blocks++;
+        } else {
+            used_blocks++;
+        }
+        prev = block;
+        block = tlsf_block_next(block);
+    }
+    if (block->prev_phys != prev || free_b != self->_free_b || free_blocks != self->_free_blocks ||
+        used_blocks != self->_used_blocks) {
+        return TLSF_STATUS_CORRUPT;
+    }
+
+    // Free lists: bitmaps match list occupancy and every block is filed in its own class.
+    for (int fl = 0; fl < (int)TLSF_FL_INDEX_COUNT; fl++) {
+        if (((self->_fl_bitmap >> fl) & 1) != (self->_sl_bitmap[fl] != 0)) {
+            return TLSF_STATUS_CORRUPT;
+        }
+        for (int sl = 0; sl < (int)TLSF_SL_INDEX_COUNT; sl++) {
+            tlsf_block_t* b = self->_free_lists[fl][sl];
+            if (((self->_sl_bitmap[fl] >> sl) & 1) != (b != NULL)) {
+                return TLSF_STATUS_CORRUPT;
+            }
+            for (; b != NULL; b = b->next_free) {
+                int bfl, bsl;
+                tlsf_mapping_insert(tlsf_block_size(b), &bfl, &bsl);
+                if (!tlsf_block_is_free(b) || bfl != fl || bsl != sl) {
+                    return TLSF_STATUS_CORRUPT;
+                }
+            }
+        }
+    }
+
+    return TLSF_STATUS_OK;
+}
+
+tlsf_status_t tlsf_walk(tlsf_t* self, tlsf_walk_cb_t cb, void* user) {
+    if (self == NULL || self->_first == NULL || cb == NULL) {
+        return TLSF_STATUS_NULL_ARG;
+    }
+
+    for (tlsf_block_t* b = self->_first; tlsf_block_size(b) != 0; b = tlsf_block_next(b)) {
+        cb(tlsf_block_to_ptr(b), tlsf_block_size(b) - TLSF_BLOCK_OVERHEAD, !tlsf_block_is_free(b),
+           user);
+    }
+    return TLSF_STATUS_OK;
+}
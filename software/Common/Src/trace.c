@@ -0,0 +1,40 @@
+#include "trace.h"
+
+#include "shared_mem.h"
+#include "stm32h7xx_hal.h"
+#include "timebase.h"
+
+#include <string.h>
+
+#if defined(CORE_CM7)
+void trace_init(void) {
+    trace_shared_t* trace = &shared_mem.trace;
+    trace->enabled = 0;
+    __DMB();
+    memset(trace->rings, 0, sizeof(trace->rings));
+    trace->magic = TRACE_MAGIC;
+    __DMB();
+    trace->enabled = 1;
+}
+#endif
+
+void trace_set_enabled(bool enabled) {
+    shared_mem.trace.enabled = enabled ? 1 : 0;
+}
+
+void trace_record(trace_event_t event, trace_phase_t phase, uint16_t arg) {
+    if (!shared_mem.trace.enabled) {
+        return;
+    }
+
+    // Each ring has one writer core, but interrupts on that core may record too. Masking them
+    // is cheaper than exclusives here: SRAM4 is shareable, and the H7 has no global monitor.
+    trace_ring_t* ring = &shared_mem.trace.rings[CORE_ID_SELF];
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t n = ring->head;
+    ring->records[n % TRACE_RING_RECORDS] =
+        (trace_record_t){timebase_now_us(), (uint8_t)event, (uint8_t)phase, arg};
+    ring->head = n + 1;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,273 @@
+// Checks blit_fill(), blit_copy() and blit_blend() on the host against the per-pixel reference in
+// blit.h (blit_unpack(), blit_pack() and blit_blend_pixel()), for every pair of formats the
+// blitter takes and for rectangles clipped on every side. On the host the blitter runs its
+// software kernels; the DMA2D is compared against them on the CM7 by blit_calibrate().
+//
+// Build on the host:
+//     SRC="../Common/Src/blit.c ../Common/Src/blend.c ../Common/Src/pixel_convert.c
+//          ../Common/Src/cache_maint.c ../Common/Src/mem_attr.c"
+//     cc -std=gnu11 -O2 -I../Common/Inc -o blit_check blit_check.c $SRC
+//
+// Then:
+//     ./blit_check
+//
+// Exits non-zero if any blit's output differed from the reference.
+
+#include "blit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLIT_CHECK_WIDTH 37
+#define BLIT_CHECK_HEIGHT 23
+// Bytes past the last pixel of each row, which no blit may touch.
+#define BLIT_CHECK_PAD_B 5
+#define BLIT_CHECK_CLUT_SIZE 200  // Fewer than 256, so some L8 indices fall outside it.
+#define BLIT_CHECK_MAX_B \
+    (BLIT_CHECK_HEIGHT * (BLIT_CHECK_WIDTH * 4 + BLIT_CHECK_PAD_B))
+
+static const pixel_format_t blit_check_formats[] = {
+    PIXEL_FORMAT_ARGB8888, PIXEL_FORMAT_RGB888,   PIXEL_FORMAT_RGB565,
+    PIXEL_FORMAT_ARGB1555, PIXEL_FORMAT_ARGB4444, PIXEL_FORMAT_L8,
+};
+#define BLIT_CHECK_FORMATS (sizeof(blit_check_formats) / sizeof(blit_check_formats[0]))
+
+// Inside, straddling each edge and corner, larger than the surface, and entirely outside.
+static const rect_t blit_check_rects[] = {
+    {3, 2, 20, 15},   {-5, 4, 9, 12},   {30, -3, 45, 8},   {10, 18, 25, 30},
+    {-8, -6, 6, 5},   {25, 15, 50, 40}, {-10, -10, 60, 40}, {0, 0, 1, 1},
+    {-20, 5, -2, 10}, {40, 0, 50, 23},  {5, 5, 5, 10},
+};
+#define BLIT_CHECK_RECTS (sizeof(blit_check_rects) / sizeof(blit_check_rects[0]))
+
+// Where each clipped source rectangle lands, including off the destination.
+static const struct {
+    int16_t x;
+    int16_t y;
+} blit_check_positions[] = {{0, 0}, {7, 3}, {-6, -4}, {28, 17}, {-3, 20}};
+#define BLIT_CHECK_POSITIONS (sizeof(blit_check_positions) / sizeof(blit_check_positions[0]))
+
+static const uint32_t blit_check_colors[] = {0xFF336699UL, 0x80FF8000UL, 0x00000000UL,
+                                             0x7F0A1B2CUL};
+#define BLIT_CHECK_COLORS (sizeof(blit_check_colors) / sizeof(blit_check_colors[0]))
+
+static const uint8_t blit_check_alphas[] = {0, 1, 128, 254, 255};
+#define BLIT_CHECK_ALPHAS (sizeof(blit_check_alphas) / sizeof(blit_check_alphas[0]))
+
+static uint32_t blit_check_clut[BLIT_CHECK_CLUT_SIZE];
+static uint32_t blit_check_seed = 1;
+
+typedef struct {
+    uint32_t blits;
+    uint32_t failures;
+} blit_check_count_t;
+
+static uint32_t blit_check_random(void) {
+    blit_check_seed = blit_check_seed * 1664525UL + 1013904223UL;
+    return blit_check_seed >> 8;
+}
+
+static const char* format_name(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return "ARGB8888";
+        case PIXEL_FORMAT_RGB888:
+            return "RGB888";
+        case PIXEL_FORMAT_RGB565:
+            return "RGB565";
+        case PIXEL_FORMAT_ARGB1555:
+            return "ARGB1555";
+        case PIXEL_FORMAT_ARGB4444:
+            return "ARGB4444";
+        case PIXEL_FORMAT_L8:
+            return "L8";
+        default:
+            return "?";
+    }
+}
+
+static surface_t blit_check_surface(uint8_t* pixels, pixel_format_t format) {
+    uint32_t stride_b = BLIT_CHECK_WIDTH * pixel_format_bytes(format) + BLIT_CHECK_PAD_B;
+    surface_t surface = {pixels, BLIT_CHECK_WIDTH, BLIT_CHECK_HEIGHT, stride_b, format};
+    return surface;
+}
+
+static uint32_t blit_check_size_b(const surface_t* surface) {
+    return surface->height * surface->stride_b;
+}
+
+static void blit_check_randomize(const surface_t* surface) {
+    uint8_t* bytes = surface->pixels;
+    for (uint32_t i = 0; i < blit_check_size_b(surface); i++) {
+        bytes[i] = (uint8_t)blit_check_random();
+    }
+}
+
+// The colour an L8 source pixel stands for, as the software path reads it.
+static uint32_t blit_check_src_pixel(const surface_t* src, int16_t x, int16_t y) {
+    const uint8_t* p = surface_pixel_addr(src, x, y);
+    if (src->format != PIXEL_FORMAT_L8) {
+        return blit_unpack(src->format, p);
+    }
+    return *p < BLIT_CHECK_CLUT_SIZE ? blit_check_clut[*p] : 0;
+}
+
+static bool blit_check_inside(const surface_t* surface, int32_t x, int32_t y) {
+    return x >= 0 && y >= 0 && x < surface->width && y < surface->height;
+}
+
+static void blit_check_ref_fill(const surface_t* dst, const rect_t* rect, uint32_t argb) {
+    for (int32_t y = rect->y0; y < rect->y1; y++) {
+        for (int32_t x = rect->x0; x < rect->x1; x++) {
+            if (blit_check_inside(dst, x, y)) {
+                blit_pack(dst->format, surface_pixel_addr(dst, (int16_t)x, (int16_t)y), argb);
+            }
+        }
+    }
+}
+
+// Each source pixel inside both src_rect and src lands at (x, y) plus its offset in src_rect,
+// if that is on dst.
+static void blit_check_ref_copy(const surface_t* dst, int16_t x, int16_t y, const surface_t* src,
+                                const rect_t* src_rect, bool blend, uint8_t alpha) {
+    for (int32_t sy = src_rect->y0; sy < src_rect->y1; sy++) {
+        for (int32_t sx = src_rect->x0; sx < src_rect->x1; sx++) {
+            int32_t dx = x + sx - src_rect->x0;
+            int32_t dy = y + sy - src_rect->y0;
+            if (!blit_check_inside(src, sx, sy) || !blit_check_inside(dst, dx, dy)) {
+                continue;
+            }
+            uint8_t* d = surface_pixel_addr(dst, (int16_t)dx, (int16_t)dy);
+            if (dst->format == src->format && !blend) {
+                memcpy(d, surface_pixel_addr(src, (int16_t)sx, (int16_t)sy),
+                       pixel_format_bytes(dst->format));
+                continue;
+            }
+            uint32_t argb = blit_check_src_pixel(src, (int16_t)sx, (int16_t)sy);
+            if (blend) {
+                argb = blit_blend_pixel(argb, blit_unpack(dst->format, d), alpha);
+            }
+            blit_pack(dst->format, d, argb);
+        }
+    }
+}
+
+// Reports the first differing byte as a pixel, or as padding past the end of a row.
+static bool blit_check_compare(const surface_t* got, const uint8_t* want, const char* what) {
+    const uint8_t* bytes = got->pixels;
+    for (uint32_t i = 0; i < blit_check_size_b(got); i++) {
+        if (bytes[i] != want[i]) {
+            uint32_t row = i / got->stride_b;
+            uint32_t col = i % got->stride_b / pixel_format_bytes(got->format);
+            printf("FAIL %s: %s (%u, %u)\n", what, col < got->width ? "pixel" : "padding at",
+                   col, row);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void blit_check_fills(pixel_format_t format, blit_check_count_t* count) {
+    static uint8_t dst_pixels[BLIT_CHECK_MAX_B];
+    static uint8_t want[BLIT_CHECK_MAX_B];
+    surface_t dst = blit_check_surface(dst_pixels, format);
+    surface_t ref = blit_check_surface(want, format);
+
+    for (uint32_t r = 0; r < BLIT_CHECK_RECTS; r++) {
+        for (uint32_t c = 0; c < BLIT_CHECK_COLORS; c++) {
+            blit_check_randomize(&dst);
+            memcpy(want, dst_pixels, blit_check_size_b(&dst));
+            const rect_t* rect = &blit_check_rects[r];
+            blit_check_ref_fill(&ref, rect, blit_check_colors[c]);
+
+            char what[96];
+            snprintf(what, sizeof(what), "fill %s rect %u color %08X", format_name(format), r,
+                     blit_check_colors[c]);
+            count->blits++;
+            blit_status_t status = blit_fill(&dst, rect, blit_check_colors[c]);
+            if (status != BLIT_STATUS_OK) {
+                printf("FAIL %s: status %d\n", what, status);
+                count->failures++;
+            } else if (!blit_check_compare(&dst, want, what)) {
+                count->failures++;
+            }
+        }
+    }
+}
+
+static void blit_check_copies(pixel_format_t dst_format, pixel_format_t src_format, bool blend,
+                              blit_check_count_t* count) {
+    static uint8_t src_pixels[BLIT_CHECK_MAX_B];
+    static uint8_t dst_pixels[BLIT_CHECK_MAX_B];
+    static uint8_t want[BLIT_CHECK_MAX_B];
+    surface_t src = blit_check_surface(src_pixels, src_format);
+    surface_t dst = blit_check_surface(dst_pixels, dst_format);
+    surface_t ref = blit_check_surface(want, dst_format);
+    uint32_t alphas = blend ? BLIT_CHECK_ALPHAS : 1;
+
+    for (uint32_t r = 0; r < BLIT_CHECK_RECTS; r++) {
+        for (uint32_t p = 0; p < BLIT_CHECK_POSITIONS; p++) {
+            for (uint32_t a = 0; a < alphas; a++) {
+                int16_t x = blit_check_positions[p].x;
+                int16_t y = blit_check_positions[p].y;
+                const rect_t* rect = &blit_check_rects[r];
+                uint8_t alpha = blit_check_alphas[a];
+                blit_check_randomize(&src);
+                blit_check_randomize(&dst);
+                memcpy(want, dst_pixels, blit_check_size_b(&dst));
+                blit_check_ref_copy(&ref, x, y, &src, rect, blend, alpha);
+
+                char what[96];
+                snprintf(what, sizeof(what), "%s %s to %s rect %u at (%d, %d) alpha %u",
+                         blend ? "blend" : "copy", format_name(src_format),
+                         format_name(dst_format), r, x, y, alpha);
+                count->blits++;
+                blit_status_t status = blend ? blit_blend(&dst, x, y, &src, rect, alpha)
+                                             : blit_copy(&dst, x, y, &src, rect);
+                if (status != BLIT_STATUS_OK) {
+                    printf("FAIL %s: status %d\n", what, status);
+                    count->failures++;
+                } else if (!blit_check_compare(&dst, want, what)) {
+                    count->failures++;
+                }
+            }
+        }
+    }
+}
+
+int main(void) {
+    blit_init();
+    for (uint32_t i = 0; i < BLIT_CHECK_CLUT_SIZE; i++) {
+        blit_check_clut[i] = blit_check_random() | (blit_check_random() << 24);
+    }
+    if (blit_load_clut(blit_check_clut, BLIT_CHECK_CLUT_SIZE) != BLIT_STATUS_OK) {
+        printf("FAIL loading the CLUT\n");
+        return 1;
+    }
+
+    blit_check_count_t fills = {0};
+    blit_check_count_t copies = {0};
+    blit_check_count_t blends = {0};
+    for (uint32_t d = 0; d < BLIT_CHECK_FORMATS; d++) {
+        pixel_format_t dst_format = blit_check_formats[d];
+        blit_check_fills(dst_format, &fills);
+        for (uint32_t s = 0; s < BLIT_CHECK_FORMATS; s++) {
+            pixel_format_t src_format = blit_check_formats[s];
+            // Indexed destinations only take other indexed pixels as they are.
+            if (dst_format == PIXEL_FORMAT_L8 && src_format != PIXEL_FORMAT_L8) {
+                continue;
+            }
+            blit_check_copies(dst_format, src_format, false, &copies);
+            if (dst_format != PIXEL_FORMAT_L8) {
+                blit_check_copies(dst_format, src_format, true, &blends);
+            }
+        }
+    }
+
+    printf("%-6s %8s %9s\n", "op", "blits", "failures");
+    printf("%-6s %8u %9u\n", "fill", fills.blits, fills.failures);
+    printf("%-6s %8u %9u\n", "copy", copies.blits, copies.failures);
+    printf("%-6s %8u %9u\n", "blend", blends.blits, blends.failures);
+    return fills.failures + copies.failures + blends.failures == 0 ? 0 : 1;
+}
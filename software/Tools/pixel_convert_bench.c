@@ -0,0 +1,57 @@
+// Runs the pixel-format conversion benchmark and self-check on the host, with the portable
+// (non-SIMD) kernels. The same benchmark runs on the CM7 when the firmware is built with
+// PIXEL_CONVERT_BENCH.
+//
+// Build on the host:
+//     SRC="../Common/Src/pixel_convert.c ../Common/Src/pixel_convert_bench.c"
+//     cc -std=gnu11 -O2 -I../Common/Inc -o pixel_convert_bench pixel_convert_bench.c $SRC
+//
+// Then:
+//     ./pixel_convert_bench
+//
+// Exits non-zero if any kernel's output differed from the reference.
+
+#include "pixel_convert_bench.h"
+
+#include <stdio.h>
+
+static const char* format_name(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_ARGB8888:
+            return "ARGB8888";
+        case PIXEL_FORMAT_RGB888:
+            return "RGB888";
+        case PIXEL_FORMAT_RGB565:
+            return "RGB565";
+        case PIXEL_FORMAT_ARGB1555:
+            return "ARGB1555";
+        case PIXEL_FORMAT_ARGB4444:
+            return "ARGB4444";
+        case PIXEL_FORMAT_L8:
+            return "L8";
+        case PIXEL_FORMAT_A8:
+            return "A8";
+        default:
+            return "?";
+    }
+}
+
+int main(void) {
+    static uint32_t scratch[PIXEL_CONVERT_BENCH_SCRATCH_B / 4];
+    pixel_convert_bench_result_t result;
+    if (!pixel_convert_bench_run(scratch, &result)) {
+        fprintf(stderr, "benchmark failed\n");
+        return 1;
+    }
+
+    uint32_t mismatches = 0;
+    printf("%-8s    %-8s %10s %10s %10s\n", "from", "to", "ns/px", "ref ns/px", "mismatches");
+    for (uint32_t i = 0; i < PIXEL_CONVERT_BENCH_CASES; i++) {
+        const pixel_convert_bench_case_t* c = &result.cases[i];
+        printf("%-8s -> %-8s %10.3f %10.3f %10u\n", format_name(c->src_format),
+               format_name(c->dst_format), c->cycles_per_kpx / 1000.0,
+               c->ref_cycles_per_kpx / 1000.0, c->mismatches);
+        mismatches += c->mismatches;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+// Runs the rasterizer benchmark on the host, with the portable (non-SIMD) inner loops. The same
+// benchmark runs on the CM7 when the firmware is built with RASTER_BENCH.
+//
+// Build on the host:
+//     SRC="../Common/Src/raster.c ../Common/Src/raster_bench.c"
+//     cc -std=gnu11 -O2 -I../Common/Inc -o raster_bench raster_bench.c $SRC
+//
+// Then:
+//     ./raster_bench [argb8888|rgb565]
+
+#include "raster_bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RASTER_BENCH_TARGET_PX 256
+
+int main(int argc, char** argv) {
+    pixel_format_t format = PIXEL_FORMAT_RGB565;
+    if (argc == 2 && strcmp(argv[1], "argb8888") == 0) {
+        format = PIXEL_FORMAT_ARGB8888;
+    } else if (argc > 2 || (argc == 2 && strcmp(argv[1], "rgb565") != 0)) {
+        fprintf(stderr, "usage: %s [argb8888|rgb565]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t stride_b = RASTER_BENCH_TARGET_PX * pixel_format_bytes(format);
+    uint8_t* pixels = calloc(RASTER_BENCH_TARGET_PX, stride_b);
+    if (pixels == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        return 1;
+    }
+    surface_t target = {pixels, RASTER_BENCH_TARGET_PX, RASTER_BENCH_TARGET_PX, stride_b, format};
+
+    raster_bench_result_t result;
+    if (!raster_bench_run(&target, &result)) {
+        fprintf(stderr, "%s: benchmark failed\n", argv[0]);
+        free(pixels);
+        return 1;
+    }
+    printf("%-6s %5s %8s %10s %12s %14s\n", "mode", "size", "tris", "pixels", "tris/s",
+           "pixels/s");
+    for (uint32_t i = 0; i < RASTER_BENCH_CASES; i++) {
+        const raster_bench_case_t* c = &result.cases[i];
+        printf("%-6s %5u %8u %10u %12u %14u\n", c->shaded ? "shaded" : "flat", c->size_px,
+               c->tris, c->pixels, c->tris_per_s, c->pixels_per_s);
+    }
+    free(pixels);
+    return 0;
+}
@@ -0,0 +1,284 @@
+// Replays an allocation trace against the TLSF heap on the host and reports how long each call
+// took and how fragmented the heap became. The pool is the size of the SDRAM heap. Worst-case
+// times on the host include its scheduling; the means are the figures to compare.
+//
+// Build on the host:
+//     cc -std=gnu11 -O2 -I../Common/Inc -o tlsf_replay tlsf_replay.c ../Common/Src/tlsf.c
+//
+// Then:
+//     ./tlsf_replay [trace]
+//
+// A trace has one call per line: "a <id> <size>" allocates, "m <id> <align> <size>" allocates
+// aligned, and "f <id>" frees what was allocated under id. Freeing an id whose allocation failed
+// frees NULL, as the traced program would have. Ids are below TLSF_REPLAY_MAX_IDS;
+// lines starting with '#' are ignored. Without a trace, a generated one churns image, glyph
+// atlas and mesh sized assets.
+//
+// The heap is checked with tlsf_check() every TLSF_REPLAY_CHECK_EVERY calls, and at the end its
+// blocks are walked with tlsf_walk() and compared with tlsf_get_stats(), whose largest_free_b
+// must then allocate while anything larger must not. Exits non-zero if any of these finds a
+// problem or the trace is malformed.
+
+#include "mem_map.h"
+#include "tlsf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TLSF_REPLAY_MAX_IDS 65536
+#define TLSF_REPLAY_CHECK_EVERY 1024
+// Generated trace: this many calls, holding at most TLSF_REPLAY_LIVE assets at once.
+#define TLSF_REPLAY_CALLS 200000
+#define TLSF_REPLAY_LIVE 512
+
+typedef enum { TLSF_REPLAY_MALLOC, TLSF_REPLAY_MEMALIGN, TLSF_REPLAY_FREE } tlsf_replay_op_t;
+
+typedef struct {
+    tlsf_replay_op_t op;
+    uint32_t id;
+    size_t align;
+    size_t size_b;
+} tlsf_replay_call_t;
+
+typedef struct {
+    uint32_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} tlsf_replay_timing_t;
+
+typedef struct {
+    tlsf_replay_timing_t timing[3];
+    uint32_t failed;               // Allocations the heap could not satisfy.
+    uint32_t null_frees;           // Frees of those allocations.
+    uint16_t max_fragmentation_pm;
+    uint64_t fragmentation_sum_pm;
+    uint32_t samples;
+} tlsf_replay_result_t;
+
+typedef struct {
+    size_t free_b;
+    size_t largest_free_b;
+    uint32_t free_blocks;
+    uint32_t used_blocks;
+} tlsf_replay_walk_t;
+
+static void* tlsf_replay_ptrs[TLSF_REPLAY_MAX_IDS];
+static bool tlsf_replay_failed[TLSF_REPLAY_MAX_IDS];  // Allocated, but the heap returned NULL.
+static uint32_t tlsf_replay_seed = 1;
+
+static uint32_t tlsf_replay_random(void) {
+    tlsf_replay_seed = tlsf_replay_seed * 1664525UL + 1013904223UL;
+    return tlsf_replay_seed >> 8;
+}
+
+static uint64_t tlsf_replay_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Mostly small glyph atlases and mesh buffers, with the occasional decoded image up to 1 MB.
+static tlsf_replay_call_t tlsf_replay_generate(uint32_t* live, uint32_t* live_count) {
+    if (*live_count == TLSF_REPLAY_LIVE ||
+        (*live_count > 0 && tlsf_replay_random() % 100 < 45)) {
+        uint32_t slot = tlsf_replay_random() % *live_count;
+        tlsf_replay_call_t call = {TLSF_REPLAY_FREE, live[slot], 0, 0};
+        live[slot] = live[--*live_count];
+        return call;
+    }
+    uint32_t kind = tlsf_replay_random() % 100;
+    size_t size_b = kind < 60   ? 64 + tlsf_replay_random() % 4096
+                    : kind < 95 ? 4096 + tlsf_replay_random() % (64 * 1024)
+                                : 64 * 1024 + tlsf_replay_random() % (1024 * 1024);
+    // Any id not in use will do; with at most TLSF_REPLAY_LIVE live, a few tries find one.
+    uint32_t id;
+    do {
+        id = tlsf_replay_random() % TLSF_REPLAY_MAX_IDS;
+    } while (tlsf_replay_ptrs[id] != NULL || tlsf_replay_failed[id]);
+    live[(*live_count)++] = id;
+    if (kind % 10 == 0) {
+        return (tlsf_replay_call_t){TLSF_REPLAY_MEMALIGN, id, 256, size_b};
+    }
+    return (tlsf_replay_call_t){TLSF_REPLAY_MALLOC, id, 0, size_b};
+}
+
+// Returns false if the line is malformed; blank lines and comments set call->op to -1.
+static bool tlsf_replay_parse(const char* line, tlsf_replay_call_t* call) {
+    char op;
+    unsigned long a;
+    unsigned long b;
+    unsigned long c;
+    call->op = (tlsf_replay_op_t)-1;
+    if (sscanf(line, " %c", &op) != 1 || op == '#') {
+        return true;
+    } else if (op == 'a' && sscanf(line, " a %lu %lu", &a, &b) == 2) {
+        *call = (tlsf_replay_call_t){TLSF_REPLAY_MALLOC, (uint32_t)a, 0, b};
+    } else if (op == 'm' && sscanf(line, " m %lu %lu %lu", &a, &b, &c) == 3) {
+        *call = (tlsf_replay_call_t){TLSF_REPLAY_MEMALIGN, (uint32_t)a, b, c};
+    } else if (op == 'f' && sscanf(line, " f %lu", &a) == 1) {
+        *call = (tlsf_replay_call_t){TLSF_REPLAY_FREE, (uint32_t)a, 0, 0};
+    } else {
+        return false;
+    }
+    return a < TLSF_REPLAY_MAX_IDS;
+}
+
+static bool tlsf_replay_run(tlsf_t* heap, const tlsf_replay_call_t* call,
+                            tlsf_replay_result_t* result) {
+    void** slot = &tlsf_replay_ptrs[call->id];
+    bool* failed = &tlsf_replay_failed[call->id];
+    bool live = *slot != NULL || *failed;
+    if ((call->op == TLSF_REPLAY_FREE) != live) {
+        fprintf(stderr, "id %u %s\n", call->id,
+                live ? "allocated twice" : "freed but not allocated");
+        return false;
+    }
+    if (call->op == TLSF_REPLAY_FREE && *failed) {
+        result->null_frees++;
+    }
+    uint64_t start = tlsf_replay_now_ns();
+    switch (call->op) {
+        case TLSF_REPLAY_MALLOC:
+            *slot = tlsf_malloc(heap, call->size_b);
+            break;
+        case TLSF_REPLAY_MEMALIGN:
+            *slot = tlsf_memalign(heap, call->align, call->size_b);
+            break;
+        case TLSF_REPLAY_FREE:
+            tlsf_free(heap, *slot);
+            *slot = NULL;
+            break;
+    }
+    uint64_t ns = tlsf_replay_now_ns() - start;
+
+    tlsf_replay_timing_t* timing = &result->timing[call->op];
+    timing->calls++;
+    timing->total_ns += ns;
+    timing->max_ns = ns > timing->max_ns ? ns : timing->max_ns;
+    *failed = call->op != TLSF_REPLAY_FREE && *slot == NULL;
+    if (*failed) {
+        result->failed++;
+    }
+
+    tlsf_stats_t stats;
+    tlsf_get_stats(heap, &stats);
+    result->fragmentation_sum_pm += stats.fragmentation_pm;
+    result->samples++;
+    if (stats.fragmentation_pm > result->max_fragmentation_pm) {
+        result->max_fragmentation_pm = stats.fragmentation_pm;
+    }
+    if (result->samples % TLSF_REPLAY_CHECK_EVERY == 0 && tlsf_check(heap) != TLSF_STATUS_OK) {
+        fprintf(stderr, "heap corrupt after %u calls\n", result->samples);
+        return false;
+    }
+    return true;
+}
+
+static void tlsf_replay_walk_cb(void* ptr, size_t size_b, bool used, void* user) {
+    (void)ptr;
+    tlsf_replay_walk_t* walk = user;
+    if (used) {
+        walk->used_blocks++;
+        return;
+    }
+    walk->free_blocks++;
+    walk->free_b += size_b;
+    walk->largest_free_b = size_b > walk->largest_free_b ? size_b : walk->largest_free_b;
+}
+
+int main(int argc, char** argv) {
+    FILE* trace = NULL;
+    if (argc == 2) {
+        trace = fopen(argv[1], "r");
+        if (trace == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    } else if (argc > 2) {
+        fprintf(stderr, "usage: %s [trace]\n", argv[0]);
+        return 1;
+    }
+
+    void* pool = malloc(SDRAM_HEAP_SIZE);
+    static tlsf_t heap;
+    static tlsf_replay_result_t result;
+    if (pool != NULL) {
+        // Fault the pages in now, so the host's paging does not show up in the timings.
+        memset(pool, 0, SDRAM_HEAP_SIZE);
+    }
+    if (pool == NULL || tlsf_init(&heap, pool, SDRAM_HEAP_SIZE) != TLSF_STATUS_OK) {
+        fprintf(stderr, "%s: cannot set up a %lu byte pool\n", argv[0],
+                (unsigned long)SDRAM_HEAP_SIZE);
+        return 1;
+    }
+
+    bool ok = true;
+    if (trace != NULL) {
+        char line[128];
+        for (uint32_t n = 1; ok && fgets(line, sizeof(line), trace) != NULL; n++) {
+            tlsf_replay_call_t call;
+            if (!tlsf_replay_parse(line, &call)) {
+                fprintf(stderr, "%s:%u: malformed call\n", argv[1], n);
+                ok = false;
+            } else if (call.op != (tlsf_replay_op_t)-1) {
+                ok = tlsf_replay_run(&heap, &call, &result);
+            }
+        }
+        fclose(trace);
+    } else {
+        static uint32_t live[TLSF_REPLAY_LIVE];
+        uint32_t live_count = 0;
+        for (uint32_t n = 0; ok && n < TLSF_REPLAY_CALLS; n++) {
+            tlsf_replay_call_t call = tlsf_replay_generate(live, &live_count);
+            ok = tlsf_replay_run(&heap, &call, &result);
+        }
+    }
+
+    static const char* const names[] = {"malloc", "memalign", "free"};
+    printf("%-8s %8s %10s %10s\n", "call", "count", "mean ns", "max ns");
+    for (uint32_t i = 0; i < 3; i++) {
+        const tlsf_replay_timing_t* t = &result.timing[i];
+        printf("%-8s %8u %10lu %10lu\n", names[i], t->calls,
+               (unsigned long)(t->calls != 0 ? t->total_ns / t->calls : 0),
+               (unsigned long)t->max_ns);
+    }
+
+    tlsf_stats_t stats;
+    tlsf_get_stats(&heap, &stats);
+    printf("\nfailed allocations  %u, %u of them freed\n", result.failed, result.null_frees);
+    printf("peak used           %lu of %lu bytes\n", (unsigned long)stats.peak_used_b,
+           (unsigned long)stats.total_b);
+    printf("fragmentation       %u permille at the end, %lu mean, %u worst\n",
+           stats.fragmentation_pm,
+           (unsigned long)(result.samples != 0 ? result.fragmentation_sum_pm / result.samples
+                                               : 0),
+           result.max_fragmentation_pm);
+    printf("free                %lu bytes in %u blocks, largest allocation %lu\n",
+           (unsigned long)stats.free_b, stats.free_blocks, (unsigned long)stats.largest_free_b);
+
+    tlsf_replay_walk_t walk = {0};
+    if (tlsf_check(&heap) != TLSF_STATUS_OK ||
+        tlsf_walk(&heap, tlsf_replay_walk_cb, &walk) != TLSF_STATUS_OK) {
+        fprintf(stderr, "heap corrupt at the end\n");
+        ok = false;
+    } else if (walk.free_blocks != stats.free_blocks || walk.used_blocks != stats.used_blocks ||
+               walk.largest_free_b < stats.largest_free_b) {
+        fprintf(stderr, "walk (%u free, %u used, largest %lu) disagrees with the stats\n",
+                walk.free_blocks, walk.used_blocks, (unsigned long)walk.largest_free_b);
+        ok = false;
+    } else if (stats.largest_free_b != 0) {
+        void* largest = tlsf_malloc(&heap, stats.largest_free_b);
+        void* larger = tlsf_malloc(&heap, stats.largest_free_b + 1);
+        if (largest == NULL || larger != NULL) {
+            fprintf(stderr, "largest allocation %lu is wrong\n",
+                    (unsigned long)stats.largest_free_b);
+            ok = false;
+        }
+        tlsf_free(&heap, largest);
+        tlsf_free(&heap, larger);
+    }
+    free(pool);
+    return ok ? 0 : 1;
+}
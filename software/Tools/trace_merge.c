@@ -0,0 +1,147 @@
+// Merges the two per-core trace rings into one Chrome trace (JSON), which chrome://tracing and
+// ui.perfetto.dev both open.
+//
+// Build on the host:
+//     cc -std=c11 -O2 -I../Common/Inc -o trace_merge trace_merge.c
+//
+// Capture with the target halted, from gdb attached to either core:
+//     dump binary value trace.bin shared_mem.trace
+//
+// Then:
+//     ./trace_merge trace.bin > trace.json
+//
+// The dump is the raw trace_shared_t, so this must be built from the same trace.h as the
+// firmware. The two cores show up as two threads of one process; timestamps are microseconds
+// from the oldest record that survived in either ring. Boot milestones that are still in the
+// rings are also listed on stderr with their time since reset (boot-to-first-pixel among them).
+
+#include "trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    trace_record_t record;
+    uint32_t core;
+    int64_t time_us;  // Unwrapped, relative to the oldest record.
+} merged_record_t;
+
+static const char* const event_names[TRACE_EVENT_COUNT] = {
+    [TRACE_EVENT_FRAME] = "frame",
+    [TRACE_EVENT_TILE] = "tile",
+    [TRACE_EVENT_GEOMETRY] = "geometry",
+    [TRACE_EVENT_DMA] = "dma",
+    [TRACE_EVENT_I2C] = "i2c",
+    [TRACE_EVENT_FENCE_WAIT] = "fence wait",
+    [TRACE_EVENT_LOCK_WAIT] = "lock wait",
+    [TRACE_EVENT_IPC_SEND] = "ipc send",
+    [TRACE_EVENT_BUFFER_QUEUE] = "buffer queue",
+    [TRACE_EVENT_BUFFER_PRESENT] = "buffer present",
+    [TRACE_EVENT_BOOT] = "boot",
+};
+
+static const char* const core_names[CORE_ID_COUNT] = {
+    [CORE_ID_CM7] = "CM7",
+    [CORE_ID_CM4] = "CM4",
+};
+
+static const char phase_codes[] = {
+    [TRACE_PHASE_BEGIN] = 'B',
+    [TRACE_PHASE_END] = 'E',
+    [TRACE_PHASE_INSTANT] = 'i',
+    [TRACE_PHASE_ASYNC_BEGIN] = 'b',
+    [TRACE_PHASE_ASYNC_END] = 'e',
+};
+
+static int compare_records(const void* a, const void* b) {
+    const merged_record_t* ra = a;
+    const merged_record_t* rb = b;
+    if (ra->time_us != rb->time_us) {
+        return ra->time_us < rb->time_us ? -1 : 1;
+    }
+    // Keep each core's own order for equal timestamps (qsort is not stable).
+    return ra < rb ? -1 : ra > rb;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s trace.bin > trace.json\n", argv[0]);
+        return 2;
+    }
+
+    static trace_shared_t trace;
+    FILE* in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t read = fread(&trace, 1, sizeof(trace), in);
+    fclose(in);
+    if (read != sizeof(trace)) {
+        fprintf(stderr, "%s: expected %zu bytes, got %zu; was trace.h changed?\n", argv[1],
+                sizeof(trace), read);
+        return 1;
+    } else if (trace.magic != TRACE_MAGIC) {
+        fprintf(stderr, "%s: bad magic 0x%08" PRIx32 "; tracing was never initialized\n",
+                argv[1], trace.magic);
+        return 1;
+    }
+
+    // Oldest surviving record of each ring first. The timebase wraps, so times are unwrapped by
+    // accumulating signed differences within each ring, and the rings are aligned by the first
+    // record of the CM7's.
+    static merged_record_t merged[CORE_ID_COUNT * TRACE_RING_RECORDS];
+    size_t count = 0;
+    uint32_t base_us = 0;
+    int base_set = 0;
+    for (uint32_t core = 0; core < CORE_ID_COUNT; core++) {
+        const trace_ring_t* ring = &trace.rings[core];
+        uint32_t n = ring->head < TRACE_RING_RECORDS ? ring->head : TRACE_RING_RECORDS;
+        uint32_t prev_us = 0;
+        int64_t time_us = 0;
+        for (uint32_t i = ring->head - n; i != ring->head; i++) {
+            const trace_record_t* record = &ring->records[i % TRACE_RING_RECORDS];
+            if (record->event >= TRACE_EVENT_COUNT || record->phase > TRACE_PHASE_ASYNC_END) {
+                continue;
+            }
+            if (!base_set) {
+                base_us = record->time_us;
+                base_set = 1;
+            }
+            time_us = i == ring->head - n ? (int32_t)(record->time_us - base_us)
+                                          : time_us + (int32_t)(record->time_us - prev_us);
+            prev_us = record->time_us;
+            merged[count++] = (merged_record_t){*record, core, time_us};
+            if (record->event == TRACE_EVENT_BOOT) {
+                fprintf(stderr, "boot mark %u (%s): %" PRIu32 " us after reset\n", record->arg,
+                        core_names[core], record->time_us);
+            }
+        }
+    }
+    qsort(merged, count, sizeof(merged[0]), compare_records);
+    int64_t origin_us = count > 0 ? merged[0].time_us : 0;
+
+    printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (uint32_t core = 0; core < CORE_ID_COUNT; core++) {
+        printf("  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %" PRIu32
+               ", \"args\": {\"name\": \"%s\"}}%s\n",
+               core, core_names[core], core + 1 < CORE_ID_COUNT || count > 0 ? "," : "");
+    }
+    for (size_t i = 0; i < count; i++) {
+        const merged_record_t* m = &merged[i];
+        printf("  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %" PRId64
+               ", \"pid\": 0, \"tid\": %" PRIu32,
+               event_names[m->record.event], core_names[m->core], phase_codes[m->record.phase],
+               m->time_us - origin_us, m->core);
+        if (m->record.phase == TRACE_PHASE_INSTANT) {
+            printf(", \"s\": \"t\"");
+        } else if (m->record.phase == TRACE_PHASE_ASYNC_BEGIN ||
+                   m->record.phase == TRACE_PHASE_ASYNC_END) {
+            printf(", \"id\": %u", m->record.arg);
+        }
+        printf(", \"args\": {\"arg\": %u}}%s\n", m->record.arg, i + 1 < count ? "," : "");
+    }
+    printf("]}\n");
+    return 0;
+}